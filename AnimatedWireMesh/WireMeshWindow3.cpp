@@ -7,14 +7,19 @@
 
 #include <iostream>
 #include "WireMeshWindow3.h"
+#include "Profiler.h"
+#include "CompressedKeyframeController.h"
 #include <Graphics/MeshFactory.h>
 #include <Mathematics/Transform.h>
 
+// 0: the keys are evaluated by mAnimation, 1: by a
+// CompressedKeyframeController attached to the sphere.
+#define COMPRESSED_KEYFRAMES 0
+
 WireMeshWindow3::WireMeshWindow3(Parameters& parameters)
     :
     Window3(parameters),
-    mApplicationTime(0.0),
-    mApplicationDeltaTime(0.001)
+    mClock(AnimationClock::FIXED_STEP)
 {
 
     if (!SetEnvironment() || !CreateScene())
@@ -28,30 +33,57 @@ WireMeshWindow3::WireMeshWindow3(Parameters& parameters)
 
     InitializeCamera(60.0f, GetAspectRatio(), 0.1f, 100.0f, 0.01f, 0.001f,
         { 0.0f, 0.0f, -2.5f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f, 0.0f });
-    mPVWMatrices.Update();
+    mPVWTracker.Set(mCamera, mUpdater);
+    mPVWTracker.Update();
+
+    // The scene creation time is not animation time.
+    mClock.Reset();
 }
 
 void WireMeshWindow3::OnIdle()
 {
+    GTE_PROFILE_SCOPE("OnIdle");
     mTimer.Measure();
+    mBenchmark.BeginFrame(mEngine);
 
-    mScene->Update(mApplicationTime);
-    mApplicationTime += mApplicationDeltaTime;
+    {
+        GTE_PROFILE_SCOPE("SceneUpdate");
+        mClock.Tick();
+        mAnimation.Update(mClock.GetTime());
+        mSceneUpdater.Update(mScene, mClock.GetTime());
+        for (auto visual : mAnimatedVisuals)
+        {
+            mCuller.MarkMoved(visual);
+        }
+    }
 
-    mCameraRig.Move();
-    mPVWMatrices.Update();    
+    if (!mBenchmark.MoveCamera(*mCamera))
+    {
+        mCameraRig.Move();
+    }
+
+    mBenchmark.Begin(FrameBenchmark::PVW_UPDATE);
+    mPVWTracker.Update();
+    mBenchmark.End();
 
+    mBenchmark.Begin(FrameBenchmark::CULL);
     mCuller.ComputeVisibleSet(mCamera, mScene);
+    mBenchmark.End();
 
-    mEngine->ClearBuffers();
+    {
+        GTE_PROFILE_SCOPE("ClearBuffers");
+        mEngine->ClearBuffers();
+    }
 
+    mBenchmark.Begin(FrameBenchmark::DRAW_SUBMISSION);
     for (auto const& visual : mCuller.GetVisibleSet())
     {
       mEngine->Draw(visual);
     }
 
     mEngine->Draw(8, mYSize - 8, { 1.0f, 1.0f, 1.0f, 1.0 }, mTimer.GetFPS());
-    mEngine->DisplayColorBuffer(0);
+    mBenchmark.End();
+    mBenchmark.Present(mEngine);
 
     mTimer.UpdateFrameCount();
 }
@@ -65,6 +97,31 @@ bool WireMeshWindow3::OnResize(int xSize, int ySize)
     return true;
 }
 
+bool WireMeshWindow3::RunBenchmark(unsigned int numFrames, std::string const& output)
+{
+    mPVWTracker.Set(mCamera, [this](std::shared_ptr<Buffer> const& buffer)
+    {
+        mBenchmark.Begin(FrameBenchmark::CONSTANT_UPLOAD);
+        mEngine->Update(buffer);
+        mBenchmark.End();
+    });
+
+    // Circle the keyframed path of the sphere, which runs from z = 0 to
+    // z = 3.  The clock advances by one step per frame, so every run draws
+    // the same frames.
+    mClock.SetMode(AnimationClock::REPLAY);
+    mClock.Reset();
+    mBenchmark.Start(numFrames, mXSize, mYSize, { 0.0f, 0.0f, 1.5f, 1.0f }, 5.0f, 1.0f);
+    while (mBenchmark.IsRunning())
+    {
+        OnIdle();
+    }
+
+    mPVWTracker.Set(mCamera, mUpdater);
+    mClock.SetMode(AnimationClock::FIXED_STEP);
+    return mBenchmark.Save(output, "AnimatedWireMesh");
+}
+
 bool WireMeshWindow3::SetEnvironment()
 {
     std::string path = GetGTEPath();
@@ -96,13 +153,18 @@ bool WireMeshWindow3::SetEnvironment()
 
 bool WireMeshWindow3::CreateScene()
 {
+    GTE_PROFILE_SCOPE("CreateScene");
     mScene = std::make_shared<Node>();
 
     std::string vsPath = mEnvironment.GetPath(mEngine->GetShaderName("WireMesh.vs"));
     std::string psPath = mEnvironment.GetPath(mEngine->GetShaderName("WireMesh.ps"));
     std::string gsPath = mEnvironment.GetPath(mEngine->GetShaderName("WireMesh.gs"));
 
-    auto program = mProgramFactory->CreateFromFiles(vsPath, psPath, gsPath);
+    std::shared_ptr<VisualProgram> program;
+    {
+        GTE_PROFILE_SCOPE("CreateProgram");
+        program = mProgramFactory->CreateFromFiles(vsPath, psPath, gsPath);
+    }
     if (!program)
     {
         return false;
@@ -139,14 +201,25 @@ bool WireMeshWindow3::CreateScene()
     mSphereController->minTime = 0.0;
     mSphereController->maxTime = 40.0;
 
-    std::shared_ptr<Visual> mMesh = mf.CreateSphere(16, 16, 1.0f);
+    std::shared_ptr<Visual> mMesh;
+    {
+        GTE_PROFILE_SCOPE("CreateMesh");
+        mMesh = mf.CreateSphere(16, 16, 1.0f);
+    }
     mMesh->localTransform.SetTranslation(0.0, 0.0, 0.0);
     mMesh->SetEffect(effect);
-    mMesh->AttachController(mSphereController);
-    mPVWMatrices.Subscribe(mMesh->worldTransform, cbuffer);
+#if COMPRESSED_KEYFRAMES
+    // The scene updater runs the controller.
+    mMesh->AttachController(std::make_shared<CompressedKeyframeController>(mSphereController));
+#else
+    mAnimation.Add(mSphereController, mMesh.get());
+#endif
+    mPVWTracker.Subscribe(mMesh->worldTransform, cbuffer, PVWTracker::DYNAMIC);
+    mAnimatedVisuals.push_back(mMesh.get());
 
     mScene->AttachChild(mMesh);
 
+    mAnimation.Update(mClock.GetTime());
     mScene->Update();
 
 
@@ -8,6 +8,12 @@
 #pragma once
 
 #include <Applications/Window3.h>
+#include "AnimationClock.h"
+#include "BVHCuller.h"
+#include "FrameBenchmark.h"
+#include "KeyframeBatch.h"
+#include "ParallelSceneUpdater.h"
+#include "PVWTracker.h"
 #include <Graphics/KeyframeController.h>
 
 using namespace gte;
@@ -21,15 +27,36 @@ public:
 
     virtual bool OnResize(int xSize, int ySize) override;
 
+    // Draw numFrames frames offscreen along a fixed camera path and write
+    // the frame times to 'output'.
+    bool RunBenchmark(unsigned int numFrames, std::string const& output);
+
 private:
-    Culler mCuller;
+    BVHCuller mCuller;
+    FrameBenchmark mBenchmark;
+
+    // Used instead of Window3::mPVWMatrices, which recomputes and uploads
+    // every subscription on each update.
+    PVWTracker mPVWTracker;
+
+    // Runs the controllers and the transform and bound propagation of
+    // mScene on a thread pool.
+    ParallelSceneUpdater mSceneUpdater;
 
     bool SetEnvironment();
     bool CreateScene();
     
+    // The keys of the sphere are set up in a KeyframeController and
+    // evaluated by mAnimation together with any other tracks.
     std::shared_ptr<KeyframeController> mSphereController;
+    KeyframeBatch mAnimation;
+
+    // The visuals that the animation moves, which the culler refits.
+    std::vector<Visual*> mAnimatedVisuals;
 
     std::shared_ptr<Node> mScene;
 
-    double mApplicationTime, mApplicationDeltaTime;
+    // Fixed steps with interpolation when interactive, one step per frame
+    // in a benchmark run.
+    AnimationClock mClock;
 };
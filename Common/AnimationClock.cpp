@@ -0,0 +1,108 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#include "AnimationClock.h"
+#include <Mathematics/Logger.h>
+#include <algorithm>
+using namespace gte;
+
+AnimationClock::AnimationClock(Mode mode, double step, unsigned int maxStepsPerFrame)
+    :
+    mMode(mode),
+    mStep(1.0 / 60.0),
+    mMaxStepsPerFrame(5)
+{
+    SetStep(step, maxStepsPerFrame);
+    Reset();
+}
+
+void AnimationClock::Reset(double time)
+{
+    mStartTime = time;
+    mStepTime = time;
+    mAccumulator = 0.0;
+    mAlpha = 0.0;
+    mLastTick = Clock::now();
+}
+
+void AnimationClock::SetMode(Mode mode)
+{
+    mMode = mode;
+    mAccumulator = 0.0;
+    mAlpha = 0.0;
+    mLastTick = Clock::now();
+}
+
+void AnimationClock::SetStep(double step, unsigned int maxStepsPerFrame)
+{
+    if (step <= 0.0 || maxStepsPerFrame == 0)
+    {
+        LogWarning("Invalid step or step limit; the clock keeps its step.");
+    }
+    else
+    {
+        mStep = step;
+        mMaxStepsPerFrame = maxStepsPerFrame;
+    }
+    mAccumulator = 0.0;
+    mAlpha = 0.0;
+}
+
+unsigned int AnimationClock::Tick()
+{
+    Clock::time_point now = Clock::now();
+    double realElapsed = std::chrono::duration<double>(now - mLastTick).count();
+    mLastTick = now;
+    return Advance(realElapsed);
+}
+
+unsigned int AnimationClock::Advance(double realElapsed)
+{
+    switch (mMode)
+    {
+    case WALL_CLOCK:
+        mStepTime += std::max(realElapsed, 0.0);
+        return 1;
+
+    case FIXED_STEP:
+    {
+        // A frame longer than the step limit is cut off; catching up on it
+        // would make the next frames even longer.
+        double const maxElapsed = mMaxStepsPerFrame * mStep;
+        mAccumulator += std::min(std::max(realElapsed, 0.0), maxElapsed);
+        unsigned int numSteps = 0;
+        while (mAccumulator >= mStep && numSteps < mMaxStepsPerFrame)
+        {
+            mAccumulator -= mStep;
+            mStepTime += mStep;
+            ++numSteps;
+        }
+
+        // Rounding can leave a whole step when the limit was reached.
+        if (mAccumulator >= mStep)
+        {
+            mAccumulator = 0.0;
+        }
+        mAlpha = mAccumulator / mStep;
+        return numSteps;
+    }
+
+    default:  // REPLAY
+        mStepTime += mStep;
+        return 1;
+    }
+}
+
+double AnimationClock::GetTime() const
+{
+    if (mMode == FIXED_STEP)
+    {
+        // Before the first step there is no earlier state to start from.
+        return std::max(mStepTime - mStep * (1.0 - mAlpha), mStartTime);
+    }
+    return mStepTime;
+}
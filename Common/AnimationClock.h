@@ -0,0 +1,92 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#pragma once
+
+#include <chrono>
+
+namespace gte
+{
+    class AnimationClock
+    {
+    public:
+        // The ways Tick advances the time.
+        //   WALL_CLOCK:  The time is the real time since Reset, so the
+        //     animation speed does not depend on the frame rate.
+        //   FIXED_STEP:  The real time accumulates and the simulation
+        //     advances in whole steps; at most maxStepsPerFrame steps are
+        //     taken per frame, and the rest of a long frame is dropped
+        //     rather than caught up later.  The time to draw lies between
+        //     the last two steps.
+        //   REPLAY:  Every Tick advances exactly one step, whatever the real
+        //     time was, so that a benchmark draws the same animation frames
+        //     on every machine and every run.
+        enum Mode
+        {
+            WALL_CLOCK,
+            FIXED_STEP,
+            REPLAY
+        };
+
+        // Construction.  The step is in seconds.
+        AnimationClock(Mode mode = WALL_CLOCK, double step = 1.0 / 60.0,
+            unsigned int maxStepsPerFrame = 5);
+
+        // Set the time to 'time' and restart the real time measurement.
+        // Changing the mode or the step also resets the accumulator.
+        void Reset(double time = 0.0);
+        void SetMode(Mode mode);
+        void SetStep(double step, unsigned int maxStepsPerFrame);
+
+        inline Mode GetMode() const
+        {
+            return mMode;
+        }
+
+        inline double GetStep() const
+        {
+            return mStep;
+        }
+
+        // Call once per frame.  Tick measures the real time since the
+        // previous Tick (or Reset); Advance takes it as an argument.  Both
+        // return the number of simulation steps taken, which is 1 in the
+        // WALL_CLOCK and REPLAY modes.
+        unsigned int Tick();
+        unsigned int Advance(double realElapsed);
+
+        // The time of the latest simulation step.  A simulation that must
+        // run in fixed steps runs the steps Tick returned, ending at this
+        // time.
+        inline double GetStepTime() const
+        {
+            return mStepTime;
+        }
+
+        // The fraction of a step accumulated after the latest one, in
+        // [0,1), and the time to draw:  GetStepTime() - step * (1 - alpha)
+        // in FIXED_STEP mode, which interpolates between the states of the
+        // last two steps, and GetStepTime() in the other modes.  Functions
+        // of time, such as keyframe animations, are evaluated directly at
+        // this time.
+        inline double GetAlpha() const
+        {
+            return mAlpha;
+        }
+
+        double GetTime() const;
+
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        Mode mMode;
+        double mStep;
+        unsigned int mMaxStepsPerFrame;
+        double mStartTime, mStepTime, mAccumulator, mAlpha;
+        Clock::time_point mLastTick;
+    };
+}
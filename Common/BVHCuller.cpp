@@ -0,0 +1,446 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#include "BVHCuller.h"
+#include <algorithm>
+#include <limits>
+using namespace gte;
+
+BVHCuller::BVHCuller()
+    :
+    mScene(nullptr),
+    mFullRefit(false),
+    mNumNodesVisited(0),
+    mNumUnmarkedMoves(0)
+{
+}
+
+void BVHCuller::ComputeVisibleSet(std::shared_ptr<Camera> const& camera,
+    std::shared_ptr<Spatial> const& scene)
+{
+    mVisibleSet.clear();
+    mNumNodesVisited = 0;
+    mNumUnmarkedMoves = 0;
+    if (!camera || !scene)
+    {
+        return;
+    }
+
+    if (scene.get() != mScene)
+    {
+        Rebuild(scene);
+    }
+    else if (mFullRefit)
+    {
+        RefitAll();
+    }
+    else
+    {
+        RefitMarked();
+    }
+
+    mFrustum.Compute(camera);
+
+    // Traverse the hierarchy.  Each stack entry carries the planes that
+    // still have to be tested; a plane is dropped as soon as a box lies
+    // entirely on its positive side, and a box with no planes left is
+    // emitted without testing its descendants.
+    mVisibleLeaves.clear();
+    if (!mNodes.empty())
+    {
+        mStack.clear();
+        mStack.push_back(std::make_pair(0, static_cast<uint32_t>(FrustumPlanes::ALL_PLANES)));
+        while (!mStack.empty())
+        {
+            int index = mStack.back().first;
+            uint32_t planeMask = mStack.back().second;
+            mStack.pop_back();
+            ++mNumNodesVisited;
+
+            BVHNode const& node = mNodes[index];
+            bool culled = false;
+            for (int i = 0; i < FrustumPlanes::NUM_PLANES; ++i)
+            {
+                uint32_t bit = (1u << i);
+                if ((planeMask & bit) == 0)
+                {
+                    continue;
+                }
+
+                // The signed distances of the box corners that are farthest
+                // along and against the plane normal.
+                auto const& plane = mFrustum[i];
+                float dmax = -plane[3], dmin = -plane[3];
+                for (int j = 0; j < 3; ++j)
+                {
+                    if (plane[j] >= 0.0f)
+                    {
+                        dmax += plane[j] * node.max[j];
+                        dmin += plane[j] * node.min[j];
+                    }
+                    else
+                    {
+                        dmax += plane[j] * node.min[j];
+                        dmin += plane[j] * node.max[j];
+                    }
+                }
+
+                if (dmax < 0.0f)
+                {
+                    culled = true;
+                    break;
+                }
+                if (dmin >= 0.0f)
+                {
+                    planeMask &= ~bit;
+                }
+            }
+
+            if (culled)
+            {
+                continue;
+            }
+
+            if (planeMask == 0)
+            {
+                EmitSubtree(index);
+            }
+            else if (node.child0 >= 0)
+            {
+                mStack.push_back(std::make_pair(node.child1, planeMask));
+                mStack.push_back(std::make_pair(node.child0, planeMask));
+            }
+            else
+            {
+                for (int i = 0; i < node.count; ++i)
+                {
+                    int leaf = mLeafIndex[node.first + i];
+                    uint32_t leafMask = planeMask;
+                    if (mFrustum.IsVisible(mLeaves[leaf].sphere, leafMask))
+                    {
+                        mVisibleLeaves.push_back(leaf);
+                    }
+                }
+            }
+        }
+    }
+
+    // The leaves were gathered in depth-first order, so sorting by leaf
+    // index and merging with the never-culled visuals by ordinal produces
+    // the order in which Culler would have inserted the visuals.
+    std::sort(mVisibleLeaves.begin(), mVisibleLeaves.end());
+    auto never = mNeverCulled.begin();
+    for (auto leaf : mVisibleLeaves)
+    {
+        int ordinal = mLeaves[leaf].ordinal;
+        while (never != mNeverCulled.end() && never->first < ordinal)
+        {
+            mVisibleSet.push_back(never->second);
+            ++never;
+        }
+        mVisibleSet.push_back(mLeaves[leaf].visual);
+    }
+    for (; never != mNeverCulled.end(); ++never)
+    {
+        mVisibleSet.push_back(never->second);
+    }
+}
+
+void BVHCuller::Rebuild(std::shared_ptr<Spatial> const& scene)
+{
+    mScene = scene.get();
+    Gather(scene);
+
+    mNodes.clear();
+    mLeafIndex.resize(mLeaves.size());
+    for (size_t i = 0; i < mLeaves.size(); ++i)
+    {
+        mLeafIndex[i] = static_cast<int>(i);
+    }
+
+    if (!mLeaves.empty())
+    {
+        mNodes.reserve(2 * mLeaves.size() / MAX_LEAF_SIZE + 1);
+        BuildRecursive(-1, 0, static_cast<int>(mLeaves.size()));
+    }
+}
+
+void BVHCuller::MarkMoved(Visual const* visual)
+{
+    auto element = mLeafOfVisual.find(visual);
+    if (element != mLeafOfVisual.end() && !mLeaves[element->second].marked)
+    {
+        mLeaves[element->second].marked = true;
+        mMarkedLeaves.push_back(element->second);
+    }
+}
+
+void BVHCuller::Refit(Visual const* visual)
+{
+    auto element = mLeafOfVisual.find(visual);
+    if (element != mLeafOfVisual.end() && UpdateLeafSphere(element->second))
+    {
+        RefitPath(mLeaves[element->second].node);
+    }
+}
+
+void BVHCuller::RefitAll()
+{
+    mDirtyNodes.clear();
+    for (int i = 0; i < static_cast<int>(mLeaves.size()); ++i)
+    {
+        if (UpdateLeafSphere(i))
+        {
+            if (!mLeaves[i].marked)
+            {
+                ++mNumUnmarkedMoves;
+            }
+            int node = mLeaves[i].node;
+            if (mDirtyNodes.empty() || mDirtyNodes.back() != node)
+            {
+                mDirtyNodes.push_back(node);
+            }
+        }
+        mLeaves[i].marked = false;
+    }
+    mMarkedLeaves.clear();
+    RefitDirtyNodes();
+}
+
+void BVHCuller::RefitMarked()
+{
+    mDirtyNodes.clear();
+    for (auto leaf : mMarkedLeaves)
+    {
+        mLeaves[leaf].marked = false;
+        if (UpdateLeafSphere(leaf))
+        {
+            mDirtyNodes.push_back(mLeaves[leaf].node);
+        }
+    }
+    mMarkedLeaves.clear();
+
+    // The leaves of a node may have been marked in any order.
+    std::sort(mDirtyNodes.begin(), mDirtyNodes.end());
+    mDirtyNodes.erase(std::unique(mDirtyNodes.begin(), mDirtyNodes.end()), mDirtyNodes.end());
+    RefitDirtyNodes();
+}
+
+void BVHCuller::RefitDirtyNodes()
+{
+    // Walking up from every dirty leaf node revisits shared ancestors, so
+    // once a sizable fraction of the tree is dirty a single post-order pass
+    // over all nodes is cheaper.
+    if (4 * mDirtyNodes.size() > mNodes.size())
+    {
+        RefitPostOrder();
+    }
+    else
+    {
+        for (auto node : mDirtyNodes)
+        {
+            RefitPath(node);
+        }
+    }
+}
+
+void BVHCuller::Gather(std::shared_ptr<Spatial> const& scene)
+{
+    // Mirror Spatial::OnGetVisibleSet: CULL_ALWAYS hides a subtree and
+    // CULL_NEVER makes a subtree visible regardless of the frustum.
+    mLeaves.clear();
+    mLeafOfVisual.clear();
+    mMarkedLeaves.clear();
+    mNeverCulled.clear();
+    mGatherStack.clear();
+    mGatherStack.push_back(std::make_pair(scene.get(), false));
+
+    int ordinal = 0;
+    while (!mGatherStack.empty())
+    {
+        Spatial* spatial = mGatherStack.back().first;
+        bool noCull = mGatherStack.back().second;
+        mGatherStack.pop_back();
+
+        if (spatial->culling == CULL_ALWAYS)
+        {
+            continue;
+        }
+        if (spatial->culling == CULL_NEVER)
+        {
+            noCull = true;
+        }
+
+        if (auto visual = dynamic_cast<Visual*>(spatial))
+        {
+            if (noCull)
+            {
+                mNeverCulled.push_back(std::make_pair(ordinal, visual));
+            }
+            else
+            {
+                Leaf leaf;
+                leaf.visual = visual;
+                leaf.node = -1;
+                leaf.ordinal = ordinal;
+                leaf.marked = false;
+                mLeaves.push_back(leaf);
+                mLeafOfVisual[visual] = static_cast<int>(mLeaves.size()) - 1;
+                UpdateLeafSphere(static_cast<int>(mLeaves.size()) - 1);
+            }
+            ++ordinal;
+        }
+        else if (auto node = dynamic_cast<Node*>(spatial))
+        {
+            for (int i = node->GetNumChildren() - 1; i >= 0; --i)
+            {
+                Spatial* child = node->GetChild(i).get();
+                if (child)
+                {
+                    mGatherStack.push_back(std::make_pair(child, noCull));
+                }
+            }
+        }
+    }
+}
+
+int BVHCuller::BuildRecursive(int parent, int first, int count)
+{
+    int index = static_cast<int>(mNodes.size());
+    mNodes.push_back(BVHNode());
+    mNodes[index].parent = parent;
+    mNodes[index].child0 = -1;
+    mNodes[index].child1 = -1;
+    mNodes[index].first = first;
+    mNodes[index].count = count;
+
+    if (count <= MAX_LEAF_SIZE)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            mLeaves[mLeafIndex[first + i]].node = index;
+        }
+        ComputeNodeBox(index);
+        return index;
+    }
+
+    // Split at the median of the sphere centers along the axis of largest
+    // center spread.
+    std::array<float, 3> cmin = { mLeaves[mLeafIndex[first]].sphere[0],
+        mLeaves[mLeafIndex[first]].sphere[1], mLeaves[mLeafIndex[first]].sphere[2] };
+    std::array<float, 3> cmax = cmin;
+    for (int i = 1; i < count; ++i)
+    {
+        auto const& sphere = mLeaves[mLeafIndex[first + i]].sphere;
+        for (int j = 0; j < 3; ++j)
+        {
+            cmin[j] = std::min(cmin[j], sphere[j]);
+            cmax[j] = std::max(cmax[j], sphere[j]);
+        }
+    }
+    int axis = 0;
+    for (int j = 1; j < 3; ++j)
+    {
+        if (cmax[j] - cmin[j] > cmax[axis] - cmin[axis])
+        {
+            axis = j;
+        }
+    }
+
+    int half = count / 2;
+    auto begin = mLeafIndex.begin() + first;
+    std::nth_element(begin, begin + half, begin + count,
+        [this, axis](int leaf0, int leaf1)
+        {
+            return mLeaves[leaf0].sphere[axis] < mLeaves[leaf1].sphere[axis];
+        });
+
+    int child0 = BuildRecursive(index, first, half);
+    int child1 = BuildRecursive(index, first + half, count - half);
+    mNodes[index].child0 = child0;
+    mNodes[index].child1 = child1;
+    ComputeNodeBox(index);
+    return index;
+}
+
+void BVHCuller::ComputeNodeBox(int index)
+{
+    BVHNode& node = mNodes[index];
+    if (node.child0 >= 0)
+    {
+        BVHNode const& node0 = mNodes[node.child0];
+        BVHNode const& node1 = mNodes[node.child1];
+        for (int j = 0; j < 3; ++j)
+        {
+            node.min[j] = std::min(node0.min[j], node1.min[j]);
+            node.max[j] = std::max(node0.max[j], node1.max[j]);
+        }
+        return;
+    }
+
+    node.min.fill(std::numeric_limits<float>::max());
+    node.max.fill(-std::numeric_limits<float>::max());
+    for (int i = 0; i < node.count; ++i)
+    {
+        auto const& sphere = mLeaves[mLeafIndex[node.first + i]].sphere;
+        for (int j = 0; j < 3; ++j)
+        {
+            node.min[j] = std::min(node.min[j], sphere[j] - sphere[3]);
+            node.max[j] = std::max(node.max[j], sphere[j] + sphere[3]);
+        }
+    }
+}
+
+bool BVHCuller::UpdateLeafSphere(int leaf)
+{
+    BoundingSphere const& bound = mLeaves[leaf].visual->worldBound;
+    Vector4<float> center = bound.GetCenter();
+    std::array<float, 4> sphere = { center[0], center[1], center[2], bound.GetRadius() };
+    if (sphere != mLeaves[leaf].sphere)
+    {
+        mLeaves[leaf].sphere = sphere;
+        return true;
+    }
+    return false;
+}
+
+void BVHCuller::RefitPath(int index)
+{
+    ComputeNodeBox(index);
+    for (int parent = mNodes[index].parent; parent >= 0; parent = mNodes[parent].parent)
+    {
+        std::array<float, 3> oldMin = mNodes[parent].min, oldMax = mNodes[parent].max;
+        ComputeNodeBox(parent);
+        if (mNodes[parent].min == oldMin && mNodes[parent].max == oldMax)
+        {
+            break;
+        }
+    }
+}
+
+void BVHCuller::RefitPostOrder()
+{
+    // Children always have larger indices than their parent.
+    for (int i = static_cast<int>(mNodes.size()) - 1; i >= 0; --i)
+    {
+        ComputeNodeBox(i);
+    }
+}
+
+void BVHCuller::EmitSubtree(int index)
+{
+    BVHNode const& node = mNodes[index];
+    for (int i = 0; i < node.count; ++i)
+    {
+        int leaf = mLeafIndex[node.first + i];
+        // Culler treats a zero radius as a dummy bound that is never visible.
+        if (mLeaves[leaf].sphere[3] != 0.0f)
+        {
+            mVisibleLeaves.push_back(leaf);
+        }
+    }
+}
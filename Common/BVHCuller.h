@@ -0,0 +1,150 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#pragma once
+
+#include <Graphics/Camera.h>
+#include <Graphics/Culler.h>
+#include <Graphics/Node.h>
+#include <Graphics/Visual.h>
+#include "FrustumPlanes.h"
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+
+namespace gte
+{
+    class BVHCuller
+    {
+    public:
+        // Construction.  The culler is a drop-in replacement for Culler in
+        // the samples: ComputeVisibleSet(camera, scene) followed by
+        // GetVisibleSet() produces the same visuals in the same (scene
+        // graph) order.  The difference is that the Visual world bounds are
+        // kept in a bounding volume hierarchy of axis-aligned boxes, so the
+        // frustum test rejects or accepts whole clusters of visuals at once
+        // instead of visiting every node of the scene graph.
+        virtual ~BVHCuller() = default;
+        BVHCuller();
+
+        // The hierarchy is built on the first ComputeVisibleSet call for a
+        // scene and reused afterwards.  Call Rebuild() after attaching or
+        // detaching children, or after a refit has degraded the tree because
+        // the visuals moved far from their original clusters.
+        void ComputeVisibleSet(std::shared_ptr<Camera> const& camera,
+            std::shared_ptr<Spatial> const& scene);
+
+        inline VisibleSet& GetVisibleSet()
+        {
+            return mVisibleSet;
+        }
+
+        void Rebuild(std::shared_ptr<Spatial> const& scene);
+
+        // Refitting.  The hierarchy keeps a copy of the world bound of every
+        // leaf.  Pass the visuals whose world bounds changed to MarkMoved,
+        // for example after the update of the world transforms; the next
+        // ComputeVisibleSet refits the boxes of those leaves and of their
+        // ancestors, so the cost follows the number of moved visuals and
+        // not the size of the scene.  Refit does the same at once.  Visuals
+        // that are not in the hierarchy are ignored.
+        void MarkMoved(Visual const* visual);
+        void Refit(Visual const* visual);
+
+        // Debugging.  With a full refit (off by default) ComputeVisibleSet
+        // compares the world bound of every leaf with its copy and refits
+        // all changed leaves, which costs a pass over the leaves per frame.
+        // GetNumUnmarkedMoves counts the changed leaves that were not
+        // marked, which are missing MarkMoved calls.  RefitAll does one
+        // such pass at once.
+        inline void SetFullRefit(bool fullRefit)
+        {
+            mFullRefit = fullRefit;
+        }
+
+        inline bool GetFullRefit() const
+        {
+            return mFullRefit;
+        }
+
+        void RefitAll();
+
+        // Statistics for the most recent ComputeVisibleSet call.
+        inline int GetNumLeaves() const
+        {
+            return static_cast<int>(mLeaves.size());
+        }
+
+        inline int GetNumNodesVisited() const
+        {
+            return mNumNodesVisited;
+        }
+
+        inline int GetNumUnmarkedMoves() const
+        {
+            return mNumUnmarkedMoves;
+        }
+
+    private:
+        enum { MAX_LEAF_SIZE = 4 };
+
+        struct Leaf
+        {
+            Visual* visual;
+            std::array<float, 4> sphere;  // (center, radius) in world space
+            int node;                     // BVH node containing the leaf
+            int ordinal;                  // position in scene graph order
+            bool marked;                  // passed to MarkMoved since the last refit
+        };
+
+        struct BVHNode
+        {
+            std::array<float, 3> min, max;
+            int parent;
+            // Interior nodes have child0 >= 0 and child1 >= 0 with
+            // child0 == index + 1.  Leaf nodes have child0 == -1 and own the
+            // entries mLeafIndex[first..first+count-1].
+            int child0, child1;
+            int first, count;
+        };
+
+        void Gather(std::shared_ptr<Spatial> const& scene);
+        int BuildRecursive(int parent, int first, int count);
+        void ComputeNodeBox(int node);
+        bool UpdateLeafSphere(int leaf);
+        void RefitMarked();
+        void RefitDirtyNodes();
+        void RefitPath(int node);
+        void RefitPostOrder();
+
+        void EmitSubtree(int node);
+
+        FrustumPlanes mFrustum;
+
+        Spatial const* mScene;
+        std::vector<Leaf> mLeaves;
+        std::vector<int> mLeafIndex;
+        std::vector<BVHNode> mNodes;
+        std::unordered_map<Visual const*, int> mLeafOfVisual;
+
+        // Visuals below a CULL_NEVER node are always visible and are kept out
+        // of the hierarchy.  The ordinals of both lists come from one
+        // depth-first pass, so merging the visible leaves and mNeverCulled
+        // by ordinal recovers the scene graph order of Culler.
+        std::vector<std::pair<int, Visual*>> mNeverCulled;
+
+        std::vector<std::pair<int, uint32_t>> mStack;
+        std::vector<std::pair<Spatial*, bool>> mGatherStack;
+        std::vector<int> mVisibleLeaves;
+        std::vector<int> mMarkedLeaves;
+        std::vector<int> mDirtyNodes;
+        VisibleSet mVisibleSet;
+        bool mFullRefit;
+        int mNumNodesVisited;
+        int mNumUnmarkedMoves;
+    };
+}
@@ -0,0 +1,120 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#include "BarycentricWire.h"
+#include <Graphics/ConstantBuffer.h>
+#include <cstdint>
+#include <cstring>
+using namespace gte;
+
+BarycentricWire::BarycentricWire(std::shared_ptr<VisualProgram> const& program)
+    :
+    mProgram(program),
+    mEffect(std::make_shared<VisualEffect>(program))
+{
+}
+
+bool BarycentricWire::Draw(std::shared_ptr<GraphicsEngine> const& engine, Visual* visual)
+{
+    auto const& effect = visual->GetEffect();
+    if (!effect)
+    {
+        return false;
+    }
+    std::shared_ptr<ConstantBuffer> pvwMatrix = effect->GetPVWMatrixConstant();
+    if (!pvwMatrix)
+    {
+        pvwMatrix = effect->GetVertexShader()->Get<ConstantBuffer>("PVWMatrix");
+        if (!pvwMatrix)
+        {
+            return false;
+        }
+    }
+
+    Key key(visual->GetVertexBuffer().get(), visual->GetIndexBuffer().get());
+    auto element = mMeshes.find(key);
+    if (element == mMeshes.end())
+    {
+        element = mMeshes.insert(std::make_pair(key, CreateMesh(*visual))).first;
+    }
+    if (!element->second)
+    {
+        return false;
+    }
+
+    // The copies share the program, so the PVWMatrix binding is switched
+    // before each draw, as EffectCache::Bind does for shared programs.
+    mProgram->GetVertexShader()->Set("PVWMatrix", pvwMatrix);
+    engine->Draw(element->second.get());
+    return true;
+}
+
+void BarycentricWire::Clear()
+{
+    mMeshes.clear();
+}
+
+std::shared_ptr<Visual> BarycentricWire::CreateMesh(Visual const& visual) const
+{
+    auto const& vbuffer = visual.GetVertexBuffer();
+    auto const& ibuffer = visual.GetIndexBuffer();
+    if (!vbuffer || !ibuffer || !vbuffer->GetData() || ibuffer->GetPrimitiveType() != IP_TRIMESH)
+    {
+        return nullptr;
+    }
+
+    VertexFormat const& vformat = vbuffer->GetFormat();
+    int index = vformat.GetIndex(VA_POSITION, 0);
+    if (index < 0)
+    {
+        return nullptr;
+    }
+    DFType type = vformat.GetType(index);
+    if (type != DF_R32G32B32_FLOAT && type != DF_R32G32B32A32_FLOAT)
+    {
+        return nullptr;
+    }
+
+    // An index buffer without indices draws the vertices in order.
+    size_t const indexSize = (ibuffer->IsIndexed() ? ibuffer->GetElementSize() : 0);
+    if (indexSize != 0 && indexSize != sizeof(uint16_t) && indexSize != sizeof(uint32_t))
+    {
+        return nullptr;
+    }
+
+    unsigned int const numVertices = vbuffer->GetNumElements();
+    unsigned int const numCorners = 3 * ibuffer->GetNumPrimitives();
+    unsigned int const stride = vformat.GetVertexSize();
+    char const* source = vbuffer->GetData() + vformat.GetOffset(index);
+    char const* indices = ibuffer->GetData();
+
+    VertexFormat cornerFormat;
+    cornerFormat.Bind(VA_POSITION, DF_R32G32B32_FLOAT, 0);
+    auto corners = std::make_shared<VertexBuffer>(cornerFormat, numCorners);
+    auto* target = corners->Get<float>();
+    for (unsigned int i = 0; i < numCorners; ++i, target += 3)
+    {
+        uint32_t v = i;
+        if (indexSize == sizeof(uint32_t))
+        {
+            v = reinterpret_cast<uint32_t const*>(indices)[i];
+        }
+        else if (indexSize == sizeof(uint16_t))
+        {
+            v = reinterpret_cast<uint16_t const*>(indices)[i];
+        }
+
+        if (v >= numVertices)
+        {
+            return nullptr;
+        }
+        std::memcpy(target, source + static_cast<size_t>(v) * stride, 3 * sizeof(float));
+    }
+
+    auto triangles = std::make_shared<IndexBuffer>(IP_TRIMESH, numCorners / 3);
+    return std::make_shared<Visual>(corners, triangles, mEffect);
+}
@@ -0,0 +1,59 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#pragma once
+
+#include <Graphics/GraphicsEngine.h>
+#include <Graphics/Visual.h>
+#include <Graphics/VisualProgram.h>
+#include <map>
+#include <memory>
+
+namespace gte
+{
+    class BarycentricWire
+    {
+    public:
+        // Construction.  The program must be built from the
+        // WireMeshBarycentric shaders, with WireParameters already set.
+        // They draw the wireframe of the WireMesh shaders without a
+        // geometry shader: the mesh is drawn without indices, the vertex
+        // shader derives the barycentric coordinates of a corner from its
+        // vertex ID, and the pixel shader turns them into edge distances.
+        BarycentricWire(std::shared_ptr<VisualProgram> const& program);
+
+        // Draw 'visual' with the PVWMatrix buffer of its own effect (the
+        // PVW matrix constant of the effect or the PVWMatrix binding of its
+        // vertex shader).  The triangles of a vertex and index buffer pair
+        // are copied into a vertex buffer with one vertex per corner on the
+        // first draw, so the Visuals that share a mesh share the copy.
+        // Draw returns false, and draws nothing, for geometry that is not a
+        // triangle mesh with float positions; draw those Visuals with their
+        // own effects.
+        bool Draw(std::shared_ptr<GraphicsEngine> const& engine, Visual* visual);
+
+        // Release the copies, for example after the scene was rebuilt.
+        void Clear();
+
+        inline size_t GetNumMeshes() const
+        {
+            return mMeshes.size();
+        }
+
+    private:
+        typedef std::pair<VertexBuffer const*, IndexBuffer const*> Key;
+
+        std::shared_ptr<Visual> CreateMesh(Visual const& visual) const;
+
+        std::shared_ptr<VisualProgram> mProgram;
+        std::shared_ptr<VisualEffect> mEffect;
+
+        // A null mesh records geometry that was rejected, so it is not
+        // examined again every frame.
+        std::map<Key, std::shared_ptr<Visual>> mMeshes;
+    };
+}
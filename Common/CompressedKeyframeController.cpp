@@ -0,0 +1,347 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#include "CompressedKeyframeController.h"
+#include "KeyframeSearch.h"
+#include <Graphics/Spatial.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+using namespace gte;
+
+namespace
+{
+    float const MAX_UINT16 = 65535.0f;
+
+    // The smaller quaternion components are in [-1/sqrt(2),1/sqrt(2)] and
+    // are stored in 15 bits as HALF_UINT15 * (1 + sqrt(2) * component), so
+    // that 0 is exact.
+    float const HALF_UINT15 = 16383.0f;
+
+    uint16_t Quantize(float value, float minimum, float scale)
+    {
+        if (scale <= 0.0f)
+        {
+            return 0;
+        }
+        float q = std::round((value - minimum) / scale);
+        return static_cast<uint16_t>(std::min(std::max(q, 0.0f), MAX_UINT16));
+    }
+
+    // The keys that are kept, always including the first and the last.  A
+    // key is dropped when the segment from the last kept key to the key
+    // after it reproduces every key in between, which error(k0, k1, j)
+    // measures, within 'tolerance'.
+    std::vector<int> ReduceKeys(int numKeys, float tolerance,
+        std::function<float(int, int, int)> const& error)
+    {
+        std::vector<int> kept;
+        kept.push_back(0);
+        for (int i = 1; i + 1 < numKeys; ++i)
+        {
+            int const k0 = kept.back();
+            bool droppable = true;
+            for (int j = k0 + 1; j <= i && droppable; ++j)
+            {
+                droppable = (error(k0, i + 1, j) <= tolerance);
+            }
+            if (!droppable)
+            {
+                kept.push_back(i);
+            }
+        }
+        if (numKeys > 1)
+        {
+            kept.push_back(numKeys - 1);
+        }
+        return kept;
+    }
+
+    float GetNormTime(float const* times, int k0, int k1, int j)
+    {
+        float dt = times[k1] - times[k0];
+        return (dt > 0.0f ? (times[j] - times[k0]) / dt : 0.0f);
+    }
+
+    // The angle between two rotations.
+    float GetAngle(Quaternion<float> const& q0, Quaternion<float> const& q1)
+    {
+        float cosHalf = 0.0f;
+        for (int c = 0; c < 4; ++c)
+        {
+            cosHalf += q0[c] * q1[c];
+        }
+        return 2.0f * std::acos(std::min(std::fabs(cosHalf), 1.0f));
+    }
+
+    Quaternion<float> SlerpKeys(float t, Quaternion<float> const& q0, Quaternion<float> q1)
+    {
+        float cosA = 0.0f;
+        for (int c = 0; c < 4; ++c)
+        {
+            cosA += q0[c] * q1[c];
+        }
+        if (cosA < 0.0f)
+        {
+            cosA = -cosA;
+            for (int c = 0; c < 4; ++c)
+            {
+                q1[c] = -q1[c];
+            }
+        }
+
+        float f0 = 1.0f - t, f1 = t;
+        if (cosA < 0.9999f)
+        {
+            float angle = std::acos(cosA);
+            float invSin = 1.0f / std::sin(angle);
+            f0 = std::sin(f0 * angle) * invSin;
+            f1 = std::sin(f1 * angle) * invSin;
+        }
+
+        Quaternion<float> q;
+        float sqrLength = 0.0f;
+        for (int c = 0; c < 4; ++c)
+        {
+            q[c] = f0 * q0[c] + f1 * q1[c];
+            sqrLength += q[c] * q[c];
+        }
+        float invLength = 1.0f / std::sqrt(sqrLength);
+        for (int c = 0; c < 4; ++c)
+        {
+            q[c] *= invLength;
+        }
+        return q;
+    }
+}
+
+CompressedKeyframeController::CompressedKeyframeController(
+    std::shared_ptr<KeyframeController> const& source, float translationTolerance,
+    float rotationTolerance, float scaleTolerance)
+    :
+    mScaleMin(0.0f),
+    mScaleScale(0.0f)
+{
+    repeat = source->repeat;
+    minTime = source->minTime;
+    maxTime = source->maxTime;
+    phase = source->phase;
+    frequency = source->frequency;
+    active = source->active;
+    for (int c = 0; c < 3; ++c)
+    {
+        mTranslationMin[c] = 0.0f;
+        mTranslationScale[c] = 0.0f;
+    }
+
+    int const numCommonTimes = source->GetNumCommonTimes();
+    float const* commonTimes = source->GetCommonTimes();
+    auto setTimes = [](Times& times, std::vector<int> const& kept, float const* keyTimes)
+    {
+        times.lastIndex = 0;
+        for (auto k : kept)
+        {
+            times.keys.push_back(keyTimes[k]);
+        }
+    };
+
+    // Translations.
+    int numKeys = source->GetNumTranslations();
+    float const* keyTimes = (numCommonTimes > 0 ? commonTimes : source->GetTranslationTimes());
+    Vector4<float> const* translations = source->GetTranslations();
+    std::vector<int> kept = ReduceKeys(numKeys, translationTolerance,
+        [keyTimes, translations](int k0, int k1, int j)
+        {
+            float t = GetNormTime(keyTimes, k0, k1, j);
+            float sqrLength = 0.0f;
+            for (int c = 0; c < 3; ++c)
+            {
+                float value = translations[k0][c] + t * (translations[k1][c] - translations[k0][c]);
+                float diff = value - translations[j][c];
+                sqrLength += diff * diff;
+            }
+            return std::sqrt(sqrLength);
+        });
+    setTimes(mTranslationTimes, kept, keyTimes);
+    if (!kept.empty())
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            float minimum = translations[kept[0]][c], maximum = minimum;
+            for (auto k : kept)
+            {
+                minimum = std::min(minimum, translations[k][c]);
+                maximum = std::max(maximum, translations[k][c]);
+            }
+            mTranslationMin[c] = minimum;
+            mTranslationScale[c] = (maximum - minimum) / MAX_UINT16;
+        }
+        for (auto k : kept)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                mTranslations.push_back(Quantize(translations[k][c], mTranslationMin[c],
+                    mTranslationScale[c]));
+            }
+        }
+    }
+
+    // Rotations.
+    numKeys = source->GetNumRotations();
+    keyTimes = (numCommonTimes > 0 ? commonTimes : source->GetRotationTimes());
+    Quaternion<float> const* rotations = source->GetRotations();
+    kept = ReduceKeys(numKeys, rotationTolerance,
+        [keyTimes, rotations](int k0, int k1, int j)
+        {
+            float t = GetNormTime(keyTimes, k0, k1, j);
+            return GetAngle(SlerpKeys(t, rotations[k0], rotations[k1]), rotations[j]);
+        });
+    setTimes(mRotationTimes, kept, keyTimes);
+    for (auto k : kept)
+    {
+        // q and -q are the same rotation, so the largest component is made
+        // positive and need not be stored.
+        Quaternion<float> q = rotations[k];
+        int largest = 0;
+        for (int c = 1; c < 4; ++c)
+        {
+            if (std::fabs(q[c]) > std::fabs(q[largest]))
+            {
+                largest = c;
+            }
+        }
+        float sign = (q[largest] < 0.0f ? -1.0f : 1.0f);
+
+        uint16_t words[3];
+        for (int c = 0, w = 0; c < 4; ++c)
+        {
+            if (c != largest)
+            {
+                float value = std::round(HALF_UINT15 * (1.0f + sign * q[c] * std::sqrt(2.0f)));
+                value = std::min(std::max(value, 0.0f), 2.0f * HALF_UINT15);
+                words[w++] = static_cast<uint16_t>(value);
+            }
+        }
+        words[0] |= static_cast<uint16_t>((largest & 1) << 15);
+        words[1] |= static_cast<uint16_t>((largest >> 1) << 15);
+        mRotations.insert(mRotations.end(), words, words + 3);
+    }
+
+    // Scales.
+    numKeys = source->GetNumScales();
+    keyTimes = (numCommonTimes > 0 ? commonTimes : source->GetScaleTimes());
+    float const* scales = source->GetScales();
+    kept = ReduceKeys(numKeys, scaleTolerance,
+        [keyTimes, scales](int k0, int k1, int j)
+        {
+            float t = GetNormTime(keyTimes, k0, k1, j);
+            return std::fabs(scales[k0] + t * (scales[k1] - scales[k0]) - scales[j]);
+        });
+    setTimes(mScaleTimes, kept, keyTimes);
+    if (!kept.empty())
+    {
+        float minimum = scales[kept[0]], maximum = minimum;
+        for (auto k : kept)
+        {
+            minimum = std::min(minimum, scales[k]);
+            maximum = std::max(maximum, scales[k]);
+        }
+        mScaleMin = minimum;
+        mScaleScale = (maximum - minimum) / MAX_UINT16;
+        for (auto k : kept)
+        {
+            mScales.push_back(Quantize(scales[k], mScaleMin, mScaleScale));
+        }
+    }
+}
+
+bool CompressedKeyframeController::Update(double applicationTime)
+{
+    if (!Controller::Update(applicationTime))
+    {
+        return false;
+    }
+
+    auto spatial = dynamic_cast<Spatial*>(mObject);
+    if (!spatial)
+    {
+        return false;
+    }
+
+    float ctrlTime = static_cast<float>(GetControlTime(applicationTime));
+    float normTime;
+    int i0, i1;
+
+    if (GetNumTranslations() > 0)
+    {
+        GetKeyInfo(ctrlTime, static_cast<int>(mTranslationTimes.keys.size()),
+            mTranslationTimes.keys.data(), mTranslationTimes.lastIndex, normTime, i0, i1);
+        Vector4<float> trn0 = GetTranslation(i0), trn1 = GetTranslation(i1);
+        spatial->localTransform.SetTranslation(trn0 + normTime * (trn1 - trn0));
+    }
+
+    if (GetNumRotations() > 0)
+    {
+        GetKeyInfo(ctrlTime, static_cast<int>(mRotationTimes.keys.size()),
+            mRotationTimes.keys.data(), mRotationTimes.lastIndex, normTime, i0, i1);
+        spatial->localTransform.SetRotation(SlerpKeys(normTime, GetRotation(i0), GetRotation(i1)));
+    }
+
+    if (GetNumScales() > 0)
+    {
+        GetKeyInfo(ctrlTime, static_cast<int>(mScaleTimes.keys.size()),
+            mScaleTimes.keys.data(), mScaleTimes.lastIndex, normTime, i0, i1);
+        float scale0 = GetScale(i0), scale1 = GetScale(i1);
+        spatial->localTransform.SetUniformScale(scale0 + normTime * (scale1 - scale0));
+    }
+    return true;
+}
+
+size_t CompressedKeyframeController::GetNumBytes() const
+{
+    size_t numTimes = mTranslationTimes.keys.size() + mRotationTimes.keys.size()
+        + mScaleTimes.keys.size();
+    size_t numWords = mTranslations.size() + mRotations.size() + mScales.size();
+    return numTimes * sizeof(float) + numWords * sizeof(uint16_t);
+}
+
+Vector4<float> CompressedKeyframeController::GetTranslation(int i) const
+{
+    uint16_t const* words = &mTranslations[3 * i];
+    return Vector4<float>
+    {
+        mTranslationMin[0] + static_cast<float>(words[0]) * mTranslationScale[0],
+        mTranslationMin[1] + static_cast<float>(words[1]) * mTranslationScale[1],
+        mTranslationMin[2] + static_cast<float>(words[2]) * mTranslationScale[2],
+        1.0f
+    };
+}
+
+Quaternion<float> CompressedKeyframeController::GetRotation(int i) const
+{
+    uint16_t const* words = &mRotations[3 * i];
+    int largest = (words[0] >> 15) | ((words[1] >> 15) << 1);
+
+    Quaternion<float> q;
+    float sqrLength = 0.0f;
+    for (int c = 0, w = 0; c < 4; ++c)
+    {
+        if (c != largest)
+        {
+            float value = static_cast<float>(words[w++] & 0x7FFF) / HALF_UINT15 - 1.0f;
+            q[c] = value / std::sqrt(2.0f);
+            sqrLength += q[c] * q[c];
+        }
+    }
+    q[largest] = std::sqrt(std::max(1.0f - sqrLength, 0.0f));
+    return q;
+}
+
+float CompressedKeyframeController::GetScale(int i) const
+{
+    return mScaleMin + static_cast<float>(mScales[i]) * mScaleScale;
+}
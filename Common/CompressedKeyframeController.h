@@ -0,0 +1,90 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#pragma once
+
+#include <Graphics/KeyframeController.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace gte
+{
+    class CompressedKeyframeController : public Controller
+    {
+    public:
+        // Construction.  The keys and the timing members of 'source' are
+        // compressed, and the controller decodes the two keys around the
+        // control time on every Update; it sets the same local transform
+        // channels that 'source' would.
+        //
+        // First the keys that linear interpolation (slerp for rotations)
+        // of their neighbors reproduces within a tolerance are dropped.
+        // The tolerances are a distance for translations, an angle in
+        // radians for rotations and an absolute difference for scales.
+        // The times of the remaining keys are kept as floats, because an
+        // error in time becomes an error in position wherever the motion is
+        // fast, and the values are quantized to 16 bits:
+        //   - translations relative to the bounding box of the track;
+        //   - rotations as the smallest three components of the unit
+        //     quaternion, 15 bits each, with the index of the largest one
+        //     in the remaining bits;
+        //   - scales relative to their range.
+        // A translation or rotation key takes 10 bytes instead of 20.
+        virtual ~CompressedKeyframeController() = default;
+        CompressedKeyframeController(std::shared_ptr<KeyframeController> const& source,
+            float translationTolerance = 1e-4f, float rotationTolerance = 1e-4f,
+            float scaleTolerance = 1e-4f);
+
+        virtual bool Update(double applicationTime) override;
+
+        // The number of keys after the reduction.
+        inline int GetNumTranslations() const
+        {
+            return static_cast<int>(mTranslationTimes.keys.size());
+        }
+
+        inline int GetNumRotations() const
+        {
+            return static_cast<int>(mRotationTimes.keys.size());
+        }
+
+        inline int GetNumScales() const
+        {
+            return static_cast<int>(mScaleTimes.keys.size());
+        }
+
+        // The size of the compressed keys.
+        size_t GetNumBytes() const;
+
+    private:
+        // The last key found is cached as in KeyframeController, so the
+        // search is O(1) while the time moves forward.
+        struct Times
+        {
+            std::vector<float> keys;
+            int lastIndex;
+        };
+
+        Vector4<float> GetTranslation(int i) const;
+        Quaternion<float> GetRotation(int i) const;
+        float GetScale(int i) const;
+
+        Times mTranslationTimes, mRotationTimes, mScaleTimes;
+
+        // Component c of translation i is mTranslationMin[c] +
+        // mTranslations[3 * i + c] * mTranslationScale[c].
+        float mTranslationMin[3], mTranslationScale[3];
+        std::vector<uint16_t> mTranslations;
+
+        // Three packed words per rotation.
+        std::vector<uint16_t> mRotations;
+
+        float mScaleMin, mScaleScale;
+        std::vector<uint16_t> mScales;
+    };
+}
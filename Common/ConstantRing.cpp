@@ -0,0 +1,120 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#include "ConstantRing.h"
+#include <Mathematics/Vector4.h>
+#include <algorithm>
+#include <cstdint>
+using namespace gte;
+
+ConstantRing::ConstantRing(unsigned int numFrames)
+    :
+    mNumFrames(std::max(numFrames, 1u)),
+    mFrame(0),
+    mNumSlots(0),
+    mCapacity(0),
+    mChanged(false),
+    mRingFrame(std::make_shared<ConstantBuffer>(sizeof(Vector4<uint32_t>), true))
+{
+    *mRingFrame->Get<uint32_t>() = 0;
+    Reserve(256);
+}
+
+void ConstantRing::Attach(std::shared_ptr<Shader> const& vshader)
+{
+    vshader->Set("PVWMatrices", mBuffer);
+    vshader->Set("RingFrame", mRingFrame);
+    mShaders.push_back(vshader);
+}
+
+unsigned int ConstantRing::Allocate()
+{
+    if (!mFreeSlots.empty())
+    {
+        unsigned int slot = mFreeSlots.back();
+        mFreeSlots.pop_back();
+        return slot;
+    }
+
+    if (mNumSlots == mCapacity)
+    {
+        Reserve(2 * mCapacity);
+    }
+
+    unsigned int slot = mNumSlots++;
+    if (slot == mSlotConstants.size())
+    {
+        auto constant = std::make_shared<ConstantBuffer>(sizeof(Vector4<uint32_t>), false);
+        *constant->Get<uint32_t>() = slot;
+        mSlotConstants.push_back(constant);
+    }
+    return slot;
+}
+
+void ConstantRing::Free(unsigned int slot)
+{
+    mFreeSlots.push_back(slot);
+}
+
+void ConstantRing::Clear()
+{
+    // The slot constants are immutable and keep their slot numbers, so
+    // they are kept for the next allocations.
+    mNumSlots = 0;
+    mFreeSlots.clear();
+}
+
+void ConstantRing::Set(unsigned int slot, Matrix4x4<float> const& pvwMatrix)
+{
+    mMatrices[slot] = pvwMatrix;
+    mChanged = true;
+}
+
+bool ConstantRing::Commit(BufferUpdater const& updater)
+{
+    if (!mChanged || mNumSlots == 0)
+    {
+        return false;
+    }
+
+    mFrame = (mFrame + 1) % mNumFrames;
+    unsigned int const frameBase = mFrame * mCapacity;
+    std::copy(mMatrices.begin(), mMatrices.begin() + mNumSlots,
+        mBuffer->Get<Matrix4x4<float>>() + frameBase);
+
+    // The whole buffer is uploaded, not just the new region.  Whether an
+    // update honors the offset and active element count of a buffer, and
+    // whether it discards the contents it does not copy, is up to the
+    // GraphicsEngine backend, whose sources are not part of this
+    // repository.  The CPU copy holds every region, so a full upload is
+    // correct either way.
+    updater(mBuffer);
+
+    *mRingFrame->Get<uint32_t>() = frameBase;
+    updater(mRingFrame);
+    mChanged = false;
+    return true;
+}
+
+void ConstantRing::Reserve(unsigned int capacity)
+{
+    mCapacity = capacity;
+    mMatrices.resize(capacity);
+    mBuffer = std::make_shared<StructuredBuffer>(mNumFrames * capacity, sizeof(Matrix4x4<float>));
+    mBuffer->SetUsage(Resource::DYNAMIC_UPDATE);
+
+    // The new buffer holds no region yet, so the next Commit writes one.
+    mChanged = true;
+    auto end = std::remove_if(mShaders.begin(), mShaders.end(),
+        [](std::weak_ptr<Shader> const& shader) { return shader.expired(); });
+    mShaders.erase(end, mShaders.end());
+    for (auto const& shader : mShaders)
+    {
+        auto vshader = shader.lock();
+        vshader->Set("PVWMatrices", mBuffer);
+    }
+}
@@ -0,0 +1,84 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#pragma once
+
+#include <Graphics/ConstantBuffer.h>
+#include <Graphics/PVWUpdater.h>
+#include <Graphics/Shader.h>
+#include <Graphics/StructuredBuffer.h>
+#include <Mathematics/Matrix4x4.h>
+#include <memory>
+#include <vector>
+
+namespace gte
+{
+    class ConstantRing
+    {
+    public:
+        // Construction.  The ring stores the PVW matrices of many visuals
+        // in one structured buffer, PVWMatrices, that is divided into
+        // numFrames regions of one slot per visual.  A frame that changes
+        // a matrix writes all of them to the next region and uploads the
+        // buffer with one update; the vertex shader reads the matrix at
+        // RingFrame.frameBase + PVWMatrix.pvwMatrixSlot.  The PVWMatrix
+        // constant of a visual therefore holds its slot, which is written
+        // once, and the per-visual constant updates disappear.
+        //
+        // GTEngine exposes neither persistent mapping nor fences, so the
+        // ring depth stands in for the fences:  a region is rewritten only
+        // after numFrames - 1 other frames were submitted, which is the
+        // frame latency the driver keeps, so the regions of the frames in
+        // flight keep the matrices those frames were drawn with.
+        ConstantRing(unsigned int numFrames = 3);
+
+        // Set PVWMatrices and RingFrame on a vertex shader built from
+        // WireMeshRing.vs.  The buffer is replaced when the ring grows, and
+        // the attached shaders are set again.
+        void Attach(std::shared_ptr<Shader> const& vshader);
+
+        // Slots.  The PVWMatrix constant of a slot is created with the slot
+        // and reused when a freed slot is allocated again.  Clear frees all
+        // slots.
+        unsigned int Allocate();
+        void Free(unsigned int slot);
+        void Clear();
+
+        inline std::shared_ptr<ConstantBuffer> const& GetSlotConstant(unsigned int slot) const
+        {
+            return mSlotConstants[slot];
+        }
+
+        // Per-frame use:  Set the matrices that changed, then Commit.  When
+        // a matrix was set, Commit writes the next region and uploads the
+        // buffer and RingFrame; it returns false when there was nothing to
+        // upload.
+        void Set(unsigned int slot, Matrix4x4<float> const& pvwMatrix);
+        bool Commit(BufferUpdater const& updater);
+
+        inline unsigned int GetNumSlots() const
+        {
+            return mNumSlots;
+        }
+
+    private:
+        void Reserve(unsigned int capacity);
+
+        unsigned int mNumFrames, mFrame;
+        unsigned int mNumSlots, mCapacity;
+        std::vector<unsigned int> mFreeSlots;
+        std::vector<std::shared_ptr<ConstantBuffer>> mSlotConstants;
+
+        // The current matrices, copied to a region by Commit.
+        std::vector<Matrix4x4<float>> mMatrices;
+        bool mChanged;
+
+        std::shared_ptr<StructuredBuffer> mBuffer;
+        std::shared_ptr<ConstantBuffer> mRingFrame;
+        std::vector<std::weak_ptr<Shader>> mShaders;
+    };
+}
@@ -0,0 +1,74 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#include "DepthPrepass.h"
+#include <Graphics/ConstantBuffer.h>
+using namespace gte;
+
+DepthPrepass::DepthPrepass(std::shared_ptr<VisualProgram> const& program)
+    :
+    mProgram(program),
+    mEffect(std::make_shared<VisualEffect>(program)),
+    mNoColor(std::make_shared<BlendState>()),
+    mDepthTest(std::make_shared<DepthStencilState>())
+{
+    mNoColor->target[0].mask = 0;
+
+    mDepthTest->depthEnable = true;
+    mDepthTest->writeMask = DepthStencilState::MASK_ZERO;
+    mDepthTest->comparison = DepthStencilState::LESS_EQUAL;
+}
+
+void DepthPrepass::Begin(std::shared_ptr<GraphicsEngine> const& engine, VisibleSet const& visuals)
+{
+    engine->SetBlendState(mNoColor);
+    for (auto visual : visuals)
+    {
+        auto const& effect = visual->GetEffect();
+        if (!effect)
+        {
+            continue;
+        }
+        std::shared_ptr<ConstantBuffer> pvwMatrix = effect->GetPVWMatrixConstant();
+        if (!pvwMatrix)
+        {
+            pvwMatrix = effect->GetVertexShader()->Get<ConstantBuffer>("PVWMatrix");
+            if (!pvwMatrix)
+            {
+                continue;
+            }
+        }
+
+        auto const& vbuffer = visual->GetVertexBuffer();
+        auto const& ibuffer = visual->GetIndexBuffer();
+        Key key(vbuffer.get(), ibuffer.get());
+        auto element = mMeshes.find(key);
+        if (element == mMeshes.end())
+        {
+            auto mesh = std::make_shared<Visual>(vbuffer, ibuffer, mEffect);
+            element = mMeshes.insert(std::make_pair(key, mesh)).first;
+        }
+
+        // The meshes share the program, so the PVWMatrix binding is
+        // switched before each draw, as EffectCache::Bind does for shared
+        // programs.
+        mProgram->GetVertexShader()->Set("PVWMatrix", pvwMatrix);
+        engine->Draw(element->second.get());
+    }
+    engine->SetDefaultBlendState();
+    engine->SetDepthStencilState(mDepthTest);
+}
+
+void DepthPrepass::End(std::shared_ptr<GraphicsEngine> const& engine)
+{
+    engine->SetDefaultDepthStencilState();
+}
+
+void DepthPrepass::Clear()
+{
+    mMeshes.clear();
+}
@@ -0,0 +1,62 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#pragma once
+
+#include <Graphics/BlendState.h>
+#include <Graphics/Culler.h>
+#include <Graphics/DepthStencilState.h>
+#include <Graphics/GraphicsEngine.h>
+#include <Graphics/VisualProgram.h>
+#include <map>
+#include <memory>
+
+namespace gte
+{
+    class DepthPrepass
+    {
+    public:
+        // Construction.  The program must be built from the WireMeshDepth
+        // shaders, which transform the positions like the WireMesh shaders
+        // and shade nothing.
+        DepthPrepass(std::shared_ptr<VisualProgram> const& program);
+
+        // Draw the visuals into the depth buffer with the color writes
+        // masked off, and leave the engine with a depth test of LESS_EQUAL
+        // and no depth writes, so the shading pass that follows runs its
+        // pixel shader once per covered pixel.  A visual is drawn with the
+        // PVWMatrix buffer of its own effect (the PVW matrix constant of
+        // the effect or the PVWMatrix binding of its vertex shader); one
+        // without either is left to the shading pass.  Pass the visuals
+        // front to back.
+        void Begin(std::shared_ptr<GraphicsEngine> const& engine, VisibleSet const& visuals);
+
+        // Restore the default depth-stencil state after the shading pass.
+        void End(std::shared_ptr<GraphicsEngine> const& engine);
+
+        // Release the per-mesh Visuals, for example after the scene was
+        // rebuilt.
+        void Clear();
+
+        inline size_t GetNumMeshes() const
+        {
+            return mMeshes.size();
+        }
+
+    private:
+        typedef std::pair<VertexBuffer const*, IndexBuffer const*> Key;
+
+        std::shared_ptr<VisualProgram> mProgram;
+        std::shared_ptr<VisualEffect> mEffect;
+        std::shared_ptr<BlendState> mNoColor;
+        std::shared_ptr<DepthStencilState> mDepthTest;
+
+        // The Visuals that share a vertex and index buffer pair share a
+        // Visual that draws the pair with the depth program.
+        std::map<Key, std::shared_ptr<Visual>> mMeshes;
+    };
+}
@@ -0,0 +1,280 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#include "DrawQueue.h"
+#include <algorithm>
+#include <cstring>
+using namespace gte;
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define DRAW_QUEUE_SSE
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // The fields of the key, from the least significant bit.
+    unsigned int const DEPTH_BITS = 24;
+    unsigned int const INDEX_BUFFER_BITS = 12;
+    unsigned int const VERTEX_BUFFER_BITS = 12;
+    unsigned int const FORMAT_BITS = 4;
+    unsigned int const PROGRAM_BITS = 12;
+
+    unsigned int const INDEX_BUFFER_SHIFT = DEPTH_BITS;
+    unsigned int const VERTEX_BUFFER_SHIFT = INDEX_BUFFER_SHIFT + INDEX_BUFFER_BITS;
+    unsigned int const FORMAT_SHIFT = VERTEX_BUFFER_SHIFT + VERTEX_BUFFER_BITS;
+    unsigned int const PROGRAM_SHIFT = FORMAT_SHIFT + FORMAT_BITS;
+    static_assert(PROGRAM_SHIFT + PROGRAM_BITS == 64, "The key fields must fill 64 bits.");
+
+    // FRONT_TO_BACK moves the depth above the state fields.
+    unsigned int const STATE_BITS = 64 - DEPTH_BITS;
+
+    // Return the number of 'key' in the table, numbering it on its first
+    // appearance.
+    template <typename Table, typename Key>
+    uint32_t Number(Table& table, Key const& key, unsigned int bits)
+    {
+        uint32_t const maxNumber = (1u << bits) - 1u;
+        uint32_t next = static_cast<uint32_t>(std::min(table.size(), static_cast<size_t>(maxNumber)));
+        return table.insert(std::make_pair(key, next)).first->second;
+    }
+
+    // Nonnegative floats are ordered like their bit patterns, whose
+    // sign bit is zero; the top 24 of the remaining 31 bits keep the
+    // exponent and 16 bits of the mantissa.
+    uint64_t DepthBits(float depth)
+    {
+        depth = std::max(depth, 0.0f);
+        uint32_t bits;
+        std::memcpy(&bits, &depth, sizeof(bits));
+        return bits >> (31 - DEPTH_BITS);
+    }
+
+    VisualProgram const* GetProgram(Visual const* visual)
+    {
+        auto const& effect = visual->GetEffect();
+        return (effect ? effect->GetProgram().get() : nullptr);
+    }
+}
+
+DrawQueue::DrawQueue(Order order)
+    :
+    mOrder(order),
+    mNumProgramChanges(0),
+    mNumBufferChanges(0)
+{
+}
+
+void DrawQueue::Sort(std::shared_ptr<Camera> const& camera, VisibleSet const& visibleSet)
+{
+    if (mPrograms.size() >= (1u << PROGRAM_BITS)
+        || mFormats.size() >= (1u << FORMAT_BITS)
+        || mVertexBuffers.size() >= (1u << VERTEX_BUFFER_BITS)
+        || mIndexBuffers.size() >= (1u << INDEX_BUFFER_BITS))
+    {
+        ClearNumbers();
+    }
+
+    size_t const numVisuals = visibleSet.size();
+    mEntries.resize(numVisuals);
+    if (camera)
+    {
+        mX.resize(numVisuals);
+        mY.resize(numVisuals);
+        mZ.resize(numVisuals);
+        mRadius.resize(numVisuals);
+        for (size_t i = 0; i < numVisuals; ++i)
+        {
+            BoundingSphere const& bound = visibleSet[i]->worldBound;
+            Vector4<float> center = bound.GetCenter();
+            mX[i] = center[0];
+            mY[i] = center[1];
+            mZ[i] = center[2];
+            mRadius[i] = bound.GetRadius();
+        }
+        ComputeDepths(camera->GetPosition(), camera->GetDVector());
+    }
+    else
+    {
+        mDepth.assign(numVisuals, 0.0f);
+    }
+
+    for (size_t i = 0; i < numVisuals; ++i)
+    {
+        Visual* visual = visibleSet[i];
+        uint64_t state = GetStateKey(*visual);
+        uint64_t depth = DepthBits(mDepth[i]);
+        if (mOrder == FRONT_TO_BACK)
+        {
+            mEntries[i] = { (depth << STATE_BITS) | (state >> DEPTH_BITS), visual };
+        }
+        else
+        {
+            mEntries[i] = { state | depth, visual };
+        }
+    }
+
+    RadixSort();
+
+    mVisuals.resize(mEntries.size());
+    mNumProgramChanges = 0;
+    mNumBufferChanges = 0;
+    for (size_t i = 0; i < mEntries.size(); ++i)
+    {
+        Visual* visual = mEntries[i].visual;
+        mVisuals[i] = visual;
+        if (i > 0)
+        {
+            Visual const* previous = mVisuals[i - 1];
+            if (GetProgram(visual) != GetProgram(previous))
+            {
+                ++mNumProgramChanges;
+            }
+            if (visual->GetVertexBuffer() != previous->GetVertexBuffer()
+                || visual->GetIndexBuffer() != previous->GetIndexBuffer())
+            {
+                ++mNumBufferChanges;
+            }
+        }
+    }
+}
+
+void DrawQueue::ComputeDepths(Vector4<float> const& P, Vector4<float> const& D)
+{
+    // depth = Dot(D, C - P) - radius = Dot(D, C) - radius - Dot(D, P)
+    size_t const numVisuals = mX.size();
+    mDepth.resize(numVisuals);
+    float const offset = D[0] * P[0] + D[1] * P[1] + D[2] * P[2];
+    size_t i = 0;
+#if defined(DRAW_QUEUE_SSE)
+    __m128 const dx = _mm_set1_ps(D[0]);
+    __m128 const dy = _mm_set1_ps(D[1]);
+    __m128 const dz = _mm_set1_ps(D[2]);
+    __m128 const dp = _mm_set1_ps(offset);
+    for (; i + 4 <= numVisuals; i += 4)
+    {
+        __m128 depth = _mm_mul_ps(dx, _mm_loadu_ps(&mX[i]));
+        depth = _mm_add_ps(depth, _mm_mul_ps(dy, _mm_loadu_ps(&mY[i])));
+        depth = _mm_add_ps(depth, _mm_mul_ps(dz, _mm_loadu_ps(&mZ[i])));
+        depth = _mm_sub_ps(depth, _mm_add_ps(_mm_loadu_ps(&mRadius[i]), dp));
+        _mm_storeu_ps(&mDepth[i], depth);
+    }
+#endif
+    for (; i < numVisuals; ++i)
+    {
+        mDepth[i] = D[0] * mX[i] + D[1] * mY[i] + D[2] * mZ[i] - (mRadius[i] + offset);
+    }
+}
+
+void DrawQueue::Clear()
+{
+    ClearNumbers();
+    mX.clear();
+    mY.clear();
+    mZ.clear();
+    mRadius.clear();
+    mDepth.clear();
+    mEntries.clear();
+    mScratch.clear();
+    mVisuals.clear();
+    mNumProgramChanges = 0;
+    mNumBufferChanges = 0;
+}
+
+void DrawQueue::ClearNumbers()
+{
+    mPrograms.clear();
+    mFormats.clear();
+    mVertexBuffers.clear();
+    mIndexBuffers.clear();
+}
+
+uint64_t DrawQueue::GetStateKey(Visual const& visual)
+{
+    uint64_t program = Number(mPrograms, GetProgram(&visual), PROGRAM_BITS);
+
+    // Vertex buffers with the same attributes share a format number.
+    VertexBuffer const* vbuffer = visual.GetVertexBuffer().get();
+    auto element = mVertexBuffers.find(vbuffer);
+    if (element == mVertexBuffers.end())
+    {
+        std::vector<uint32_t> signature;
+        if (vbuffer)
+        {
+            VertexFormat const& vformat = vbuffer->GetFormat();
+            for (int i = 0; i < vformat.GetNumAttributes(); ++i)
+            {
+                VASemantic semantic = VA_NO_SEMANTIC;
+                DFType type = DF_UNKNOWN;
+                unsigned int unit = 0, offset = 0;
+                vformat.GetAttribute(i, semantic, type, unit, offset);
+                signature.insert(signature.end(), { static_cast<uint32_t>(semantic),
+                    static_cast<uint32_t>(type), unit, offset });
+            }
+            signature.push_back(vformat.GetVertexSize());
+        }
+
+        VertexBufferNumber number;
+        number.format = Number(mFormats, signature, FORMAT_BITS);
+        number.buffer = static_cast<uint32_t>(std::min(mVertexBuffers.size(),
+            static_cast<size_t>((1u << VERTEX_BUFFER_BITS) - 1u)));
+        element = mVertexBuffers.insert(std::make_pair(vbuffer, number)).first;
+    }
+    uint64_t format = element->second.format;
+    uint64_t vertices = element->second.buffer;
+
+    uint64_t indices = Number(mIndexBuffers, visual.GetIndexBuffer().get(), INDEX_BUFFER_BITS);
+
+    return (program << PROGRAM_SHIFT) | (format << FORMAT_SHIFT)
+        | (vertices << VERTEX_BUFFER_SHIFT) | (indices << INDEX_BUFFER_SHIFT);
+}
+
+void DrawQueue::RadixSort()
+{
+    // Least significant digit first, 8 bits per pass.  All histograms are
+    // gathered in one pass over the keys, and a pass whose digit is the
+    // same for every key is skipped; typically only the depth bytes and
+    // the low bytes of the state numbers differ.
+    size_t const numEntries = mEntries.size();
+    if (numEntries < 2)
+    {
+        return;
+    }
+
+    size_t counts[8][256] = {};
+    for (auto const& entry : mEntries)
+    {
+        for (int pass = 0; pass < 8; ++pass)
+        {
+            ++counts[pass][(entry.key >> (8 * pass)) & 0xFF];
+        }
+    }
+
+    mScratch.resize(numEntries);
+    for (int pass = 0; pass < 8; ++pass)
+    {
+        size_t* count = counts[pass];
+        if (count[(mEntries[0].key >> (8 * pass)) & 0xFF] == numEntries)
+        {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (int digit = 0; digit < 256; ++digit)
+        {
+            size_t n = count[digit];
+            count[digit] = offset;
+            offset += n;
+        }
+
+        for (auto const& entry : mEntries)
+        {
+            mScratch[count[(entry.key >> (8 * pass)) & 0xFF]++] = entry;
+        }
+        mEntries.swap(mScratch);
+    }
+}
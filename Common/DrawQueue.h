@@ -0,0 +1,126 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#pragma once
+
+#include <Graphics/Camera.h>
+#include <Graphics/Culler.h>
+#include <Graphics/Visual.h>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace gte
+{
+    class DrawQueue
+    {
+    public:
+        // The queue sits between culling and drawing and orders the visible
+        // set by a 64-bit key built from these fields:
+        //   program        12 bits
+        //   vertex format   4 bits
+        //   vertex buffer  12 bits
+        //   index buffer   12 bits
+        //   view depth     24 bits
+        // BY_STATE puts them in this order, most significant first, so
+        // consecutive draws share as much state as possible and the draws
+        // of one mesh go front to back.  FRONT_TO_BACK puts the depth
+        // first, for an opaque pass whose pixel shading costs more than
+        // its state changes: the nearer surfaces fill the depth buffer
+        // first and the early depth test rejects the pixels behind them.
+        //
+        // The queue only orders the draws; it does not skip any binds.
+        // GraphicsEngine::Draw binds the program, buffers and constants of
+        // every visual it is given, whatever was bound before.  The
+        // statistics count the state changes that remain between
+        // consecutive draws of the order.
+        enum Order
+        {
+            BY_STATE,
+            FRONT_TO_BACK
+        };
+
+        // Construction.  A program, format or buffer is numbered when the
+        // queue first sees it; past the capacity of its field the later
+        // ones share the last number, which costs order but not
+        // correctness.  The next Sort then forgets all numbers and numbers
+        // the objects of its visible set afresh, so the tables do not keep
+        // the objects of a streamed or rebuilt scene forever.
+        DrawQueue(Order order = BY_STATE);
+
+        inline void SetOrder(Order order)
+        {
+            mOrder = order;
+        }
+
+        inline Order GetOrder() const
+        {
+            return mOrder;
+        }
+
+        // Sort the visuals of the visible set.  The view depth of a visual
+        // is the depth of the nearest point of its world bound.  Without a
+        // camera the visuals are ordered by state only.
+        void Sort(std::shared_ptr<Camera> const& camera, VisibleSet const& visibleSet);
+
+        // The visuals of the most recent Sort in drawing order.
+        inline VisibleSet const& GetVisuals() const
+        {
+            return mVisuals;
+        }
+
+        // Forget the numbering and the sorted visuals, for example after the
+        // scene was rebuilt and the old objects were released.
+        void Clear();
+
+        // Statistics for the most recent Sort, counted between consecutive
+        // draws of the sorted order.
+        inline unsigned int GetNumProgramChanges() const
+        {
+            return mNumProgramChanges;
+        }
+
+        inline unsigned int GetNumBufferChanges() const
+        {
+            return mNumBufferChanges;
+        }
+
+    private:
+        struct Entry
+        {
+            uint64_t key;
+            Visual* visual;
+        };
+
+        struct VertexBufferNumber
+        {
+            uint32_t format, buffer;
+        };
+
+        void ClearNumbers();
+        uint64_t GetStateKey(Visual const& visual);
+        void ComputeDepths(Vector4<float> const& P, Vector4<float> const& D);
+        void RadixSort();
+
+        Order mOrder;
+
+        std::unordered_map<VisualProgram const*, uint32_t> mPrograms;
+        std::map<std::vector<uint32_t>, uint32_t> mFormats;
+        std::unordered_map<VertexBuffer const*, VertexBufferNumber> mVertexBuffers;
+        std::unordered_map<IndexBuffer const*, uint32_t> mIndexBuffers;
+
+        // The world bounds of the visible set, one array per component, for
+        // computing the depths four at a time.
+        std::vector<float> mX, mY, mZ, mRadius, mDepth;
+
+        std::vector<Entry> mEntries, mScratch;
+        VisibleSet mVisuals;
+        unsigned int mNumProgramChanges, mNumBufferChanges;
+    };
+}
@@ -0,0 +1,70 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#include "EffectCache.h"
+using namespace gte;
+
+EffectCache::EffectCache(std::shared_ptr<ProgramFactory> const& factory)
+    :
+    mFactory(factory),
+    mNumHits(0)
+{
+}
+
+std::shared_ptr<VisualProgram> EffectCache::CreateFromFiles(std::string const& vsPath,
+    std::string const& psPath, std::string const& gsPath, Initializer const& initializer)
+{
+    std::string key = GetKey(vsPath, psPath, gsPath);
+    auto element = mPrograms.find(key);
+    if (element != mPrograms.end())
+    {
+        ++mNumHits;
+        return element->second;
+    }
+
+    auto program = mFactory->CreateFromFiles(vsPath, psPath, gsPath);
+    if (!program)
+    {
+        return nullptr;
+    }
+
+    if (initializer)
+    {
+        initializer(program);
+    }
+    mPrograms.insert(std::make_pair(key, program));
+    return program;
+}
+
+std::shared_ptr<VisualEffect> EffectCache::CreateEffect(
+    std::shared_ptr<VisualProgram> const& program,
+    std::shared_ptr<ConstantBuffer> const& pvwMatrix)
+{
+    auto effect = std::make_shared<VisualEffect>(program);
+    effect->SetPVWMatrixConstant(pvwMatrix);
+    return effect;
+}
+
+void EffectCache::Clear()
+{
+    mPrograms.clear();
+    mNumHits = 0;
+}
+
+std::string EffectCache::GetKey(std::string const& vsPath, std::string const& psPath,
+    std::string const& gsPath) const
+{
+    // The paths and the define pairs are separated by a character that
+    // cannot occur in a path or a preprocessor token, so different inputs
+    // cannot produce the same key.
+    std::string key = vsPath + '\n' + psPath + '\n' + gsPath;
+    for (auto const& define : mFactory->defines.GetDefinitions())
+    {
+        key += '\n' + define.first + '=' + define.second;
+    }
+    return key;
+}
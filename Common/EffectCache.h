@@ -0,0 +1,82 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#pragma once
+
+#include <Graphics/ConstantBuffer.h>
+#include <Graphics/ProgramFactory.h>
+#include <Graphics/Visual.h>
+#include <Graphics/VisualEffect.h>
+#include <functional>
+#include <map>
+#include <string>
+
+namespace gte
+{
+    class EffectCache
+    {
+    public:
+        // Construction.  The cache compiles each distinct combination of
+        // shader files and factory defines once and hands the same
+        // VisualProgram to every visual that asks for it.  Constants that
+        // are identical for all those visuals (WireParameters in the wire
+        // mesh samples) are attached to the shared program once, so they
+        // are also shared; only the PVWMatrix buffer stays per visual.
+        EffectCache(std::shared_ptr<ProgramFactory> const& factory);
+
+        // Return the program for the files and the current factory
+        // defines, compiling it on the first request.  The initializer is
+        // called only for a newly compiled program and is the place to set
+        // the shared constant buffers.  A null pointer is returned when the
+        // compilation fails, and the failure is not cached.
+        typedef std::function<void(std::shared_ptr<VisualProgram> const&)> Initializer;
+
+        std::shared_ptr<VisualProgram> CreateFromFiles(std::string const& vsPath,
+            std::string const& psPath, std::string const& gsPath,
+            Initializer const& initializer = nullptr);
+
+        // Create a light-weight effect that references the shared program
+        // and remembers the per-visual PVWMatrix buffer.  No GPU object is
+        // created by this call.
+        std::shared_ptr<VisualEffect> CreateEffect(std::shared_ptr<VisualProgram> const& program,
+            std::shared_ptr<ConstantBuffer> const& pvwMatrix);
+
+        // Visuals that share a program share its vertex shader, and a
+        // shader has a single PVWMatrix binding.  Call Bind before drawing
+        // a visual so that the binding refers to the buffer of that visual.
+        static inline void Bind(Visual* visual)
+        {
+            auto const& effect = visual->GetEffect();
+            if (effect && effect->GetPVWMatrixConstant())
+            {
+                effect->GetVertexShader()->Set("PVWMatrix", effect->GetPVWMatrixConstant());
+            }
+        }
+
+        void Clear();
+
+        // Statistics.  Every CreateFromFiles call is either a hit or a
+        // compilation.
+        inline size_t GetNumPrograms() const
+        {
+            return mPrograms.size();
+        }
+
+        inline size_t GetNumHits() const
+        {
+            return mNumHits;
+        }
+
+    private:
+        std::string GetKey(std::string const& vsPath, std::string const& psPath,
+            std::string const& gsPath) const;
+
+        std::shared_ptr<ProgramFactory> mFactory;
+        std::map<std::string, std::shared_ptr<VisualProgram>> mPrograms;
+        size_t mNumHits;
+    };
+}
@@ -0,0 +1,188 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#include "FlatHierarchy.h"
+#include <algorithm>
+#include <utility>
+using namespace gte;
+
+FlatHierarchy::FlatHierarchy()
+    :
+    mRootParent(nullptr),
+    mFirstDirty(0)
+{
+}
+
+void FlatHierarchy::Build(std::shared_ptr<Spatial> const& scene)
+{
+    mSpatials.clear();
+    mParents.clear();
+    mSubtreeEnd.clear();
+    mIsLeaf.clear();
+    mLocal.clear();
+    mWorld.clear();
+    mModelBound.clear();
+    mWorldBound.clear();
+    mDirty.clear();
+    mIndices.clear();
+    mRootParent = nullptr;
+    mFirstDirty = 0;
+    if (!scene)
+    {
+        return;
+    }
+
+    mRootParent = scene->GetParent();
+    std::vector<std::pair<Spatial*, int>> stack;
+    stack.push_back(std::make_pair(scene.get(), -1));
+    while (!stack.empty())
+    {
+        Spatial* spatial = stack.back().first;
+        int parent = stack.back().second;
+        stack.pop_back();
+
+        int const index = static_cast<int>(mSpatials.size());
+        auto node = dynamic_cast<Node*>(spatial);
+        auto visual = dynamic_cast<Visual*>(spatial);
+        mSpatials.push_back(spatial);
+        mParents.push_back(parent);
+        mIsLeaf.push_back(node ? 0 : 1);
+        mLocal.push_back(spatial->localTransform);
+        mWorld.push_back(spatial->worldTransform);
+        mModelBound.push_back(visual ? visual->modelBound : BoundingSphere());
+        mWorldBound.push_back(spatial->worldBound);
+        mDirty.push_back(TRANSFORM_DIRTY | BOUND_DIRTY);
+        mIndices.insert(std::make_pair(spatial, index));
+        spatial->worldTransformIsCurrent = true;
+        spatial->worldBoundIsCurrent = true;
+
+        if (node)
+        {
+            for (int i = node->GetNumChildren() - 1; i >= 0; --i)
+            {
+                Spatial* child = node->GetChild(i).get();
+                if (child)
+                {
+                    stack.push_back(std::make_pair(child, index));
+                }
+            }
+        }
+    }
+
+    int const numEntries = GetNumEntries();
+    mSubtreeEnd.resize(numEntries);
+    for (int i = numEntries - 1; i >= 0; --i)
+    {
+        mSubtreeEnd[i] = std::max(mSubtreeEnd[i], i + 1);
+        if (mParents[i] >= 0)
+        {
+            mSubtreeEnd[mParents[i]] = std::max(mSubtreeEnd[mParents[i]], mSubtreeEnd[i]);
+        }
+    }
+}
+
+void FlatHierarchy::Clear()
+{
+    for (auto spatial : mSpatials)
+    {
+        spatial->worldTransformIsCurrent = false;
+        spatial->worldBoundIsCurrent = false;
+    }
+    Build(nullptr);
+}
+
+int FlatHierarchy::GetIndex(Spatial const* spatial) const
+{
+    auto iter = mIndices.find(spatial);
+    return (iter != mIndices.end() ? iter->second : -1);
+}
+
+void FlatHierarchy::SetLocalTransform(int i, Transform<float> const& local)
+{
+    mLocal[i] = local;
+    mSpatials[i]->localTransform = local;
+    mDirty[i] |= TRANSFORM_DIRTY;
+    mFirstDirty = std::min(mFirstDirty, i);
+}
+
+size_t FlatHierarchy::Update()
+{
+    int const numEntries = GetNumEntries();
+    if (mFirstDirty >= numEntries)
+    {
+        return 0;
+    }
+
+    // Transforms.  The entries before the first marked one are unchanged,
+    // and a parent is visited before its children, so one forward pass
+    // carries the marks down the subtrees.
+    size_t numUpdated = 0;
+    for (int i = mFirstDirty; i < numEntries; ++i)
+    {
+        int const parent = mParents[i];
+        if (parent >= 0 && (mDirty[parent] & TRANSFORM_DIRTY))
+        {
+            mDirty[i] |= TRANSFORM_DIRTY;
+        }
+        if (mDirty[i] & TRANSFORM_DIRTY)
+        {
+            if (parent >= 0)
+            {
+                mWorld[i] = mWorld[parent] * mLocal[i];
+            }
+            else if (mRootParent)
+            {
+                mWorld[i] = mRootParent->worldTransform * mLocal[i];
+            }
+            else
+            {
+                mWorld[i] = mLocal[i];
+            }
+            if (mIsLeaf[i])
+            {
+                mModelBound[i].TransformBy(mWorld[i], mWorldBound[i]);
+            }
+            mDirty[i] |= BOUND_DIRTY;
+            ++numUpdated;
+        }
+    }
+
+    // Bounds.  A backward pass reaches a node after all of its
+    // descendants, which have marked it when their bounds changed.  The
+    // bound of a marked node is merged from its children in child order,
+    // as Node::UpdateWorldBound does, so both produce the same sphere.
+    for (int i = numEntries - 1; i >= 0; --i)
+    {
+        if (!mIsLeaf[i] && (mDirty[i] & BOUND_DIRTY))
+        {
+            mWorldBound[i].SetCenter({ 0.0f, 0.0f, 0.0f, 1.0f });
+            mWorldBound[i].SetRadius(0.0f);
+            for (int child = i + 1; child < mSubtreeEnd[i]; child = mSubtreeEnd[child])
+            {
+                mWorldBound[i].GrowToContain(mWorldBound[child]);
+            }
+        }
+
+        if (mDirty[i])
+        {
+            if (mParents[i] >= 0)
+            {
+                mDirty[mParents[i]] |= BOUND_DIRTY;
+            }
+            Spatial* spatial = mSpatials[i];
+            if (mDirty[i] & TRANSFORM_DIRTY)
+            {
+                spatial->worldTransform = mWorld[i];
+            }
+            spatial->worldBound = mWorldBound[i];
+            mDirty[i] = 0;
+        }
+    }
+
+    mFirstDirty = numEntries;
+    return numUpdated;
+}
@@ -0,0 +1,111 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#pragma once
+
+#include <Graphics/Node.h>
+#include <Graphics/Visual.h>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace gte
+{
+    class FlatHierarchy
+    {
+    public:
+        // Construction.  Build flattens the subtree of a scene into arrays
+        // indexed by entry, in depth-first order, so that every parent
+        // precedes its children and a subtree is a contiguous run.  The
+        // local and world transforms, the bounds and the parent indices
+        // are stored contiguously, and Update propagates the transforms in
+        // one forward pass and the bounds in backward passes, without
+        // virtual calls or pointer chasing.
+        //
+        // The engine classes keep their own worldTransform and worldBound
+        // members, which the drawing and culling code reads, so Update
+        // writes the entries it recomputed back to their Spatial objects.
+        // Build sets worldTransformIsCurrent and worldBoundIsCurrent on the
+        // flattened objects, so Spatial::Update leaves them to this
+        // hierarchy.  Clear resets the flags and therefore must be called
+        // while the objects exist; Build does not touch the objects of a
+        // previous scene.  Children attached after Build are not part of
+        // the hierarchy until the next Build.
+        FlatHierarchy();
+
+        void Build(std::shared_ptr<Spatial> const& scene);
+        void Clear();
+
+        inline int GetNumEntries() const
+        {
+            return static_cast<int>(mSpatials.size());
+        }
+
+        // Returns -1 when 'spatial' is not in the hierarchy.
+        int GetIndex(Spatial const* spatial) const;
+
+        inline Spatial* GetSpatial(int i) const
+        {
+            return mSpatials[i];
+        }
+
+        inline int GetParent(int i) const
+        {
+            return mParents[i];
+        }
+
+        // Changing a local transform marks the subtree of the entry for the
+        // next Update.
+        inline Transform<float> const& GetLocalTransform(int i) const
+        {
+            return mLocal[i];
+        }
+
+        void SetLocalTransform(int i, Transform<float> const& local);
+
+        // Recompute the marked subtrees and the bounds that contain them.
+        // Returns the number of recomputed world transforms; a static
+        // scene costs nothing after its first Update.
+        size_t Update();
+
+        inline Transform<float> const& GetWorldTransform(int i) const
+        {
+            return mWorld[i];
+        }
+
+        inline BoundingSphere const& GetWorldBound(int i) const
+        {
+            return mWorldBound[i];
+        }
+
+    private:
+        enum : uint8_t
+        {
+            TRANSFORM_DIRTY = 0x01,
+            BOUND_DIRTY = 0x02
+        };
+
+        std::vector<Spatial*> mSpatials;
+        std::vector<int> mParents;
+
+        // One past the last entry of the subtree of an entry.  The children
+        // of a node are i + 1, mSubtreeEnd[i + 1] and so on, in the order
+        // of Node::GetChild.
+        std::vector<int> mSubtreeEnd;
+        std::vector<uint8_t> mIsLeaf;
+        std::vector<Transform<float>> mLocal, mWorld;
+        std::vector<BoundingSphere> mModelBound, mWorldBound;
+        std::vector<uint8_t> mDirty;
+        std::unordered_map<Spatial const*, int> mIndices;
+
+        // The parent of the scene root, when the root is not the root of
+        // its own scene.  Its world transform is read by Update, but its
+        // bound is not updated.
+        Spatial* mRootParent;
+        int mFirstDirty;
+    };
+}
@@ -0,0 +1,316 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#include "FrameBenchmark.h"
+#include "Profiler.h"
+#include <Mathematics/Logger.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+using namespace gte;
+
+char const* FrameBenchmark::msStageName[NUM_STAGES + 1] =
+{
+    "cull",
+    "pvw_update",
+    "constant_upload",
+    "draw_submission",
+    "present",
+    "total"
+};
+
+FrameBenchmark::Options::Options()
+    :
+    numFrames(0),
+    output("benchmark.json")
+{
+}
+
+bool FrameBenchmark::ParseCommandLine(int argc, char const* argv[], Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--benchmark")
+        {
+            char* last = nullptr;
+            long numFrames = (i + 1 < argc ? std::strtol(argv[i + 1], &last, 10) : 0);
+            if (numFrames <= 0 || *last != '\0')
+            {
+                LogWarning("--benchmark expects a positive number of frames");
+                return false;
+            }
+            options.numFrames = static_cast<unsigned int>(numFrames);
+            ++i;
+        }
+        else if (argument == "--output")
+        {
+            if (i + 1 == argc)
+            {
+                LogWarning("--output expects a file name");
+                return false;
+            }
+            options.output = argv[++i];
+        }
+        else if (argument == "--trace")
+        {
+            if (i + 1 == argc)
+            {
+                LogWarning("--trace expects a file name");
+                return false;
+            }
+            options.trace = argv[++i];
+        }
+        else
+        {
+            options.arguments.push_back(argument);
+        }
+    }
+    return true;
+}
+
+FrameBenchmark::FrameBenchmark()
+    :
+    mRunning(false),
+    mNumFrames(0),
+    mCenter{ 0.0f, 0.0f, 0.0f, 1.0f },
+    mRadius(1.0f),
+    mHeight(0.0f),
+    mDepth(0)
+{
+}
+
+void FrameBenchmark::Start(unsigned int numFrames, unsigned int xSize, unsigned int ySize,
+    Vector4<float> const& center, float radius, float height)
+{
+    mRunning = (numFrames > 0);
+    mNumFrames = numFrames;
+    mCenter = center;
+    mRadius = radius;
+    mHeight = height;
+    mTarget = std::make_shared<DrawTarget>(1, DF_R8G8B8A8_UNORM, xSize, ySize,
+        false, false, DF_D24_UNORM_S8_UINT, false);
+    mFrames.clear();
+    mFrames.reserve(numFrames);
+}
+
+bool FrameBenchmark::MoveCamera(Camera& camera) const
+{
+    if (!mRunning)
+    {
+        return false;
+    }
+
+    float const angle = 6.2831853f * static_cast<float>(mFrames.size()) / static_cast<float>(mNumFrames);
+    Vector4<float> position = mCenter;
+    position[0] += mRadius * std::sin(angle);
+    position[1] += mHeight;
+    position[2] += mRadius * std::cos(angle);
+
+    Vector4<float> dVector = mCenter - position;
+    Normalize(dVector);
+    Vector4<float> rVector = Cross(dVector, Vector4<float>{ 0.0f, 1.0f, 0.0f, 0.0f });
+    Normalize(rVector);
+    Vector4<float> uVector = Cross(rVector, dVector);
+    camera.SetFrame(position, dVector, uVector, rVector);
+    return true;
+}
+
+void FrameBenchmark::BeginFrame(std::shared_ptr<GraphicsEngine> const& engine)
+{
+    if (mRunning)
+    {
+        engine->Enable(mTarget);
+        mCurrent.fill(Clock::duration::zero());
+        mDepth = 0;
+        mFrameStart = Clock::now();
+    }
+}
+
+void FrameBenchmark::Begin(Stage stage)
+{
+    bool const profile = Profiler::IsEnabled();
+    if ((mRunning || profile) && mDepth < NUM_STAGES)
+    {
+        auto now = Clock::now();
+        if (mRunning && mDepth > 0)
+        {
+            mCurrent[mStack[mDepth - 1]] += now - mStageStart;
+        }
+        mStack[mDepth] = stage;
+        mStackBegin[mDepth] = (profile ? Profiler::Now() : NOT_PROFILED);
+        ++mDepth;
+        mStageStart = now;
+    }
+}
+
+void FrameBenchmark::End()
+{
+    if (mDepth > 0)
+    {
+        --mDepth;
+        if (mRunning)
+        {
+            auto now = Clock::now();
+            mCurrent[mStack[mDepth]] += now - mStageStart;
+            mStageStart = now;
+        }
+        if (mStackBegin[mDepth] != NOT_PROFILED)
+        {
+            Profiler::Record(msStageName[mStack[mDepth]], mStackBegin[mDepth], Profiler::Now());
+        }
+    }
+}
+
+void FrameBenchmark::Present(std::shared_ptr<GraphicsEngine> const& engine)
+{
+    if (mRunning)
+    {
+        engine->Disable(mTarget);
+    }
+
+    Begin(PRESENT);
+    engine->DisplayColorBuffer(0);
+    End();
+    if (!mRunning)
+    {
+        return;
+    }
+
+    FrameTimes times;
+    for (int i = 0; i < NUM_STAGES; ++i)
+    {
+        times[i] = std::chrono::duration<double, std::milli>(mCurrent[i]).count();
+    }
+    times[NUM_STAGES] = std::chrono::duration<double, std::milli>(Clock::now() - mFrameStart).count();
+    mFrames.push_back(times);
+
+    if (mFrames.size() == mNumFrames)
+    {
+        mRunning = false;
+        mTarget = nullptr;
+    }
+}
+
+FrameBenchmark::Summary FrameBenchmark::Summarize(int column) const
+{
+    std::vector<double> values(mFrames.size());
+    for (size_t i = 0; i < mFrames.size(); ++i)
+    {
+        values[i] = mFrames[i][column];
+    }
+    std::sort(values.begin(), values.end());
+
+    // Nearest-rank percentiles.
+    auto percentile = [&values](double p)
+    {
+        size_t rank = static_cast<size_t>(std::ceil(p * values.size()));
+        return values[rank > 0 ? rank - 1 : 0];
+    };
+
+    Summary summary = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    if (!values.empty())
+    {
+        for (auto value : values)
+        {
+            summary.mean += value;
+        }
+        summary.mean /= static_cast<double>(values.size());
+        summary.p50 = percentile(0.50);
+        summary.p90 = percentile(0.90);
+        summary.p95 = percentile(0.95);
+        summary.p99 = percentile(0.99);
+        summary.max = values.back();
+    }
+    return summary;
+}
+
+bool FrameBenchmark::Save(std::string const& filename, std::string const& sample) const
+{
+    std::ofstream output(filename);
+    if (!output)
+    {
+        LogWarning("Cannot write benchmark results to " + filename);
+        return false;
+    }
+
+    bool isCSV = (filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".csv") == 0);
+    return isCSV ? SaveCSV(output) : SaveJSON(output, sample);
+}
+
+bool FrameBenchmark::SaveJSON(std::ofstream& output, std::string const& sample) const
+{
+    output << "{\n  \"sample\": \"" << sample << "\",\n  \"unit\": \"ms\",\n";
+    output << "  \"frames\": " << mFrames.size() << ",\n  \"summary\": {\n";
+    for (int i = 0; i <= NUM_STAGES; ++i)
+    {
+        Summary s = Summarize(i);
+        output << "    \"" << msStageName[i] << "\": { \"mean\": " << s.mean
+            << ", \"p50\": " << s.p50 << ", \"p90\": " << s.p90 << ", \"p95\": " << s.p95
+            << ", \"p99\": " << s.p99 << ", \"max\": " << s.max << " }"
+            << (i < NUM_STAGES ? ",\n" : "\n");
+    }
+    output << "  },\n  \"stages\": [";
+    for (int i = 0; i <= NUM_STAGES; ++i)
+    {
+        output << "\"" << msStageName[i] << "\"" << (i < NUM_STAGES ? ", " : "");
+    }
+    output << "],\n  \"times\": [\n";
+    for (size_t f = 0; f < mFrames.size(); ++f)
+    {
+        output << "    [";
+        for (int i = 0; i <= NUM_STAGES; ++i)
+        {
+            output << mFrames[f][i] << (i < NUM_STAGES ? ", " : "");
+        }
+        output << (f + 1 < mFrames.size() ? "],\n" : "]\n");
+    }
+    output << "  ]\n}\n";
+    return static_cast<bool>(output);
+}
+
+bool FrameBenchmark::SaveCSV(std::ofstream& output) const
+{
+    // One row per frame, then one row per statistic with the statistic's
+    // name in the frame column.
+    output << "frame";
+    for (int i = 0; i <= NUM_STAGES; ++i)
+    {
+        output << "," << msStageName[i] << "_ms";
+    }
+    output << "\n";
+
+    for (size_t f = 0; f < mFrames.size(); ++f)
+    {
+        output << f;
+        for (int i = 0; i <= NUM_STAGES; ++i)
+        {
+            output << "," << mFrames[f][i];
+        }
+        output << "\n";
+    }
+
+    std::array<Summary, NUM_STAGES + 1> summaries;
+    for (int i = 0; i <= NUM_STAGES; ++i)
+    {
+        summaries[i] = Summarize(i);
+    }
+    char const* statName[6] = { "mean", "p50", "p90", "p95", "p99", "max" };
+    double Summary::* stat[6] = { &Summary::mean, &Summary::p50, &Summary::p90,
+        &Summary::p95, &Summary::p99, &Summary::max };
+    for (int s = 0; s < 6; ++s)
+    {
+        output << statName[s];
+        for (int i = 0; i <= NUM_STAGES; ++i)
+        {
+            output << "," << summaries[i].*stat[s];
+        }
+        output << "\n";
+    }
+    return static_cast<bool>(output);
+}
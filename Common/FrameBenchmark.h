@@ -0,0 +1,127 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#pragma once
+
+#include <Graphics/Camera.h>
+#include <Graphics/DrawTarget.h>
+#include <Graphics/GraphicsEngine.h>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace gte
+{
+    class FrameBenchmark
+    {
+    public:
+        // The CPU time of a frame is split into these stages.  The times
+        // are exclusive: a stage that begins while another is running
+        // pauses the outer one, so a constant upload inside the PVW update
+        // is not counted twice.  When the Profiler is enabled, the stages
+        // are also recorded as trace events, with or without a run.
+        enum Stage
+        {
+            CULL,
+            PVW_UPDATE,
+            CONSTANT_UPLOAD,
+            DRAW_SUBMISSION,
+            PRESENT,
+            NUM_STAGES
+        };
+
+        // Command line of the samples:  [--benchmark <frames> [--output
+        // <file>]] [--trace <file>].  The output is CSV when the file name
+        // ends in ".csv" and JSON otherwise.  A trace file name enables the
+        // Profiler; the sample writes the trace when it exits.  Arguments
+        // that are not benchmark options are returned in 'arguments'.
+        // ParseCommandLine returns false for a malformed command line.
+        struct Options
+        {
+            Options();
+
+            unsigned int numFrames;
+            std::string output;
+            std::string trace;
+            std::vector<std::string> arguments;
+        };
+
+        static bool ParseCommandLine(int argc, char const* argv[], Options& options);
+
+        // Construction.  Until Start is called, the timing functions do
+        // nothing and Present only displays the color buffer.
+        FrameBenchmark();
+
+        // Start a run of numFrames frames.  The frames are drawn to an
+        // offscreen draw target of the window size, so a run does not need
+        // a visible window.  The camera circles the y-axis through 'center'
+        // at distance 'radius', 'height' units above the center, and looks
+        // at the center; one orbit takes the whole run.
+        void Start(unsigned int numFrames, unsigned int xSize, unsigned int ySize,
+            Vector4<float> const& center, float radius, float height);
+
+        inline bool IsRunning() const
+        {
+            return mRunning;
+        }
+
+        // Move the camera to its place on the path for the current frame.
+        // Returns false (and leaves the camera alone) when not running.
+        bool MoveCamera(Camera& camera) const;
+
+        // Frame structure:
+        //   benchmark.BeginFrame(engine);
+        //   benchmark.Begin(FrameBenchmark::CULL); ... benchmark.End();
+        //   ...
+        //   benchmark.Present(engine);  // instead of DisplayColorBuffer(0)
+        void BeginFrame(std::shared_ptr<GraphicsEngine> const& engine);
+        void Begin(Stage stage);
+        void End();
+        void Present(std::shared_ptr<GraphicsEngine> const& engine);
+
+        // Write the per-frame times and the percentiles in milliseconds.
+        bool Save(std::string const& filename, std::string const& sample) const;
+
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        // The begin time of a stage that started while the Profiler was
+        // disabled.
+        static uint64_t const NOT_PROFILED = UINT64_MAX;
+
+        // The stage times and the total time of a frame.
+        typedef std::array<double, NUM_STAGES + 1> FrameTimes;
+
+        struct Summary
+        {
+            double mean, p50, p90, p95, p99, max;
+        };
+
+        Summary Summarize(int column) const;
+        bool SaveJSON(std::ofstream& output, std::string const& sample) const;
+        bool SaveCSV(std::ofstream& output) const;
+
+        static char const* msStageName[NUM_STAGES + 1];
+
+        bool mRunning;
+        unsigned int mNumFrames;
+        Vector4<float> mCenter;
+        float mRadius, mHeight;
+        std::shared_ptr<DrawTarget> mTarget;
+
+        std::vector<FrameTimes> mFrames;
+        std::array<Clock::duration, NUM_STAGES> mCurrent;
+        std::array<Stage, NUM_STAGES> mStack;
+        std::array<uint64_t, NUM_STAGES> mStackBegin;
+        int mDepth;
+        Clock::time_point mFrameStart, mStageStart;
+    };
+}
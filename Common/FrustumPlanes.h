@@ -0,0 +1,127 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#pragma once
+
+#include <Graphics/BoundingSphere.h>
+#include <Graphics/Camera.h>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+namespace gte
+{
+    // The six camera frustum planes in the form used by Culler.  Each plane
+    // is stored as (normal, constant) with the normal pointing into the
+    // frustum, so the signed distance of point P is Dot(normal, P) -
+    // constant.  The culling helpers of the samples share this class so that
+    // they all reject exactly the bounds that Culler rejects.
+    class FrustumPlanes
+    {
+    public:
+        enum
+        {
+            NUM_PLANES = 6,
+            ALL_PLANES = (1u << NUM_PLANES) - 1
+        };
+
+        FrustumPlanes()
+        {
+            for (auto& plane : mPlanes)
+            {
+                plane.fill(0.0f);
+            }
+        }
+
+        // The plane construction of Culler::PushPlanes (near, far, bottom,
+        // top, left, right).
+        void Compute(std::shared_ptr<Camera> const& camera)
+        {
+            Vector4<float> P = camera->GetPosition();
+            Vector4<float> D = camera->GetDVector();
+            Vector4<float> U = camera->GetUVector();
+            Vector4<float> R = camera->GetRVector();
+            float dirDotEye = Dot(P, D);
+
+            float const* frustum = camera->GetFrustum();
+            float dMin = frustum[Camera::VF_DMIN];
+            float dMax = frustum[Camera::VF_DMAX];
+            float dMinSqr = dMin * dMin;
+            float uMin = frustum[Camera::VF_UMIN];
+            float uMax = frustum[Camera::VF_UMAX];
+            float rMin = frustum[Camera::VF_RMIN];
+            float rMax = frustum[Camera::VF_RMAX];
+
+            mPlanes[0] = { D[0], D[1], D[2], dirDotEye + dMin };
+            mPlanes[1] = { -D[0], -D[1], -D[2], -(dirDotEye + dMax) };
+
+            float invLength = 1.0f / std::sqrt(dMinSqr + uMin * uMin);
+            Set(2, P, (-uMin * invLength) * D + (dMin * invLength) * U);
+
+            invLength = 1.0f / std::sqrt(dMinSqr + uMax * uMax);
+            Set(3, P, (uMax * invLength) * D - (dMin * invLength) * U);
+
+            invLength = 1.0f / std::sqrt(dMinSqr + rMin * rMin);
+            Set(4, P, (-rMin * invLength) * D + (dMin * invLength) * R);
+
+            invLength = 1.0f / std::sqrt(dMinSqr + rMax * rMax);
+            Set(5, P, (rMax * invLength) * D - (dMin * invLength) * R);
+        }
+
+        inline std::array<float, 4> const& operator[](int i) const
+        {
+            return mPlanes[i];
+        }
+
+        // The test of Culler::IsVisible for a sphere (center, radius).  Only
+        // the planes whose bits are set in planeMask are tested.  A plane
+        // whose positive side contains the sphere is removed from the mask,
+        // so descendants of a node need not test it again.  A zero radius
+        // marks a dummy bound and is never visible.
+        inline bool IsVisible(std::array<float, 4> const& sphere, uint32_t& planeMask) const
+        {
+            if (sphere[3] == 0.0f)
+            {
+                return false;
+            }
+
+            for (int i = 0; i < NUM_PLANES; ++i)
+            {
+                uint32_t bit = (1u << i);
+                if (planeMask & bit)
+                {
+                    auto const& plane = mPlanes[i];
+                    float distance = plane[0] * sphere[0] + plane[1] * sphere[1]
+                        + plane[2] * sphere[2] - plane[3];
+                    if (distance <= -sphere[3])
+                    {
+                        return false;
+                    }
+                    if (distance >= sphere[3])
+                    {
+                        planeMask &= ~bit;
+                    }
+                }
+            }
+            return true;
+        }
+
+        inline bool IsVisible(BoundingSphere const& bound, uint32_t& planeMask) const
+        {
+            Vector4<float> center = bound.GetCenter();
+            return IsVisible({ center[0], center[1], center[2], bound.GetRadius() }, planeMask);
+        }
+
+    private:
+        inline void Set(int i, Vector4<float> const& P, Vector4<float> const& N)
+        {
+            mPlanes[i] = { N[0], N[1], N[2], Dot(P, N) };
+        }
+
+        std::array<std::array<float, 4>, NUM_PLANES> mPlanes;
+    };
+}
@@ -0,0 +1,948 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#include "GLTFLoader.h"
+#include <Mathematics/Logger.h>
+#include <Mathematics/Quaternion.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+using namespace gte;
+
+namespace
+{
+    // glTF constants.
+    enum
+    {
+        GLB_MAGIC = 0x46546C67,  // "glTF"
+        GLB_CHUNK_JSON = 0x4E4F534A,
+        GLB_CHUNK_BIN = 0x004E4942,
+
+        COMPONENT_UNSIGNED_BYTE = 5121,
+        COMPONENT_UNSIGNED_SHORT = 5123,
+        COMPONENT_UNSIGNED_INT = 5125,
+        COMPONENT_FLOAT = 5126,
+
+        MODE_TRIANGLES = 4,
+        MAX_NODE_DEPTH = 256
+    };
+
+    uint32_t ReadUInt32(char const* data)
+    {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    unsigned int GetComponentSize(unsigned int componentType)
+    {
+        switch (componentType)
+        {
+        case 5120: case COMPONENT_UNSIGNED_BYTE: return 1;
+        case 5122: case COMPONENT_UNSIGNED_SHORT: return 2;
+        case COMPONENT_UNSIGNED_INT: case COMPONENT_FLOAT: return 4;
+        }
+        return 0;
+    }
+
+    // Read an optional size member, which is 'defaultValue' when absent.
+    // The return value is false for a member that is not a valid size.
+    bool GetSize(Json const& object, char const* key, size_t defaultValue, size_t& value)
+    {
+        value = defaultValue;
+        return !object.Has(key) || object[key].GetIndex(value);
+    }
+
+    unsigned int GetNumComponents(std::string const& type)
+    {
+        if (type == "SCALAR") return 1;
+        if (type == "VEC2") return 2;
+        if (type == "VEC3") return 3;
+        if (type == "VEC4" || type == "MAT2") return 4;
+        if (type == "MAT3") return 9;
+        if (type == "MAT4") return 16;
+        return 0;
+    }
+
+    // Relative URIs are percent-encoded; file names with spaces are common.
+    std::string DecodeURI(std::string const& uri)
+    {
+        std::string path;
+        for (size_t i = 0; i < uri.size(); ++i)
+        {
+            if (uri[i] == '%' && i + 2 < uri.size()
+                && std::isxdigit(static_cast<unsigned char>(uri[i + 1]))
+                && std::isxdigit(static_cast<unsigned char>(uri[i + 2])))
+            {
+                path += static_cast<char>(std::stoi(uri.substr(i + 1, 2), nullptr, 16));
+                i += 2;
+            }
+            else
+            {
+                path += uri[i];
+            }
+        }
+        return path;
+    }
+
+    bool DecodeBase64(char const* text, size_t length, std::vector<char>& bytes)
+    {
+        bytes.clear();
+        bytes.reserve(length / 4 * 3);
+        uint32_t accumulator = 0;
+        int bits = 0;
+        for (size_t i = 0; i < length; ++i)
+        {
+            char c = text[i];
+            uint32_t value;
+            if (c >= 'A' && c <= 'Z') value = c - 'A';
+            else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+            else if (c >= '0' && c <= '9') value = c - '0' + 52;
+            else if (c == '+') value = 62;
+            else if (c == '/') value = 63;
+            else if (c == '=') break;
+            else return false;
+
+            accumulator = (accumulator << 6) | value;
+            bits += 6;
+            if (bits >= 8)
+            {
+                bits -= 8;
+                bytes.push_back(static_cast<char>((accumulator >> bits) & 0xFF));
+            }
+        }
+        return true;
+    }
+}
+
+GLTFLoader::GLTFLoader()
+    :
+    mBinaryChunk(nullptr, 0),
+    mAborted(false),
+    mNumVisuals(0),
+    mNumZeroCopyBuffers(0)
+{
+}
+
+std::shared_ptr<Node> GLTFLoader::Load(std::string const& filename,
+    VisualCallback const& onVisual)
+{
+    if (!Open(filename))
+    {
+        return nullptr;
+    }
+    mOnVisual = onVisual;
+
+    auto scene = std::make_shared<Node>();
+    for (auto root : GetRootNodes())
+    {
+        auto child = CreateSpatial(root, 0, nullptr);
+        if (mAborted)
+        {
+            return nullptr;
+        }
+        if (child)
+        {
+            scene->AttachChild(child);
+        }
+    }
+    CreateSkins();
+
+    // The decoded document is no longer needed; the buffers are.
+    mDocument = Json();
+    mMeshes.clear();
+    mNodes.clear();
+    mOnVisual = nullptr;
+    return scene;
+}
+
+bool GLTFLoader::Open(std::string const& filename)
+{
+    Clear();
+    if (!LoadDocument(filename) || !LoadBuffers())
+    {
+        return false;
+    }
+
+    size_t const numMeshes = mDocument["meshes"].GetSize();
+    mMeshes.resize(numMeshes);
+    mMeshLoaded.assign(numMeshes, false);
+    mNodeVisited.assign(mDocument["nodes"].GetSize(), false);
+    mNodes.assign(mDocument["nodes"].GetSize(), nullptr);
+    mSkins.assign(mDocument["skins"].GetSize(), Skin());
+    return true;
+}
+
+std::shared_ptr<Node> GLTFLoader::CreateHierarchy(
+    std::vector<std::vector<std::shared_ptr<Node>>>& meshParents)
+{
+    meshParents.clear();
+    meshParents.resize(mDocument["meshes"].GetSize());
+
+    auto scene = std::make_shared<Node>();
+    for (auto root : GetRootNodes())
+    {
+        auto child = CreateSpatial(root, 0, &meshParents);
+        if (child)
+        {
+            scene->AttachChild(child);
+        }
+    }
+    CreateSkins();
+    mNodes.clear();
+    return scene;
+}
+
+int GLTFLoader::GetSkin(Node const* meshParent) const
+{
+    auto element = mNodeSkins.find(meshParent);
+    return (element != mNodeSkins.end() ? element->second : -1);
+}
+
+std::vector<size_t> GLTFLoader::GetRootNodes() const
+{
+    // The default scene, else the first one.  A document without scenes
+    // shows every node that is not the child of another node.
+    std::vector<size_t> roots;
+    Json const& scenes = mDocument["scenes"];
+    if (scenes.GetSize() > 0)
+    {
+        size_t scene = 0;
+        if (!GetSize(mDocument, "scene", 0, scene) || scene >= scenes.GetSize())
+        {
+            LogWarning("Invalid default scene; showing the first one");
+            scene = 0;
+        }
+        Json const& nodes = scenes[scene]["nodes"];
+        for (size_t i = 0; i < nodes.GetSize(); ++i)
+        {
+            size_t node = 0;
+            if (nodes[i].GetIndex(node))
+            {
+                roots.push_back(node);
+            }
+            else
+            {
+                LogWarning("Skipping invalid root node reference " + std::to_string(i));
+            }
+        }
+        return roots;
+    }
+
+    size_t const numNodes = mDocument["nodes"].GetSize();
+    std::vector<bool> isChild(numNodes, false);
+    for (size_t i = 0; i < numNodes; ++i)
+    {
+        Json const& children = mDocument["nodes"][i]["children"];
+        for (size_t j = 0; j < children.GetSize(); ++j)
+        {
+            size_t child = 0;
+            if (children[j].GetIndex(child) && child < numNodes)
+            {
+                isChild[child] = true;
+            }
+        }
+    }
+    for (size_t i = 0; i < numNodes; ++i)
+    {
+        if (!isChild[i])
+        {
+            roots.push_back(i);
+        }
+    }
+    return roots;
+}
+
+void GLTFLoader::Clear()
+{
+    mDocument = Json();
+    mDirectory.clear();
+    mFiles.clear();
+    mDecoded.clear();
+    mBuffers.clear();
+    mBinaryChunk = std::make_pair(nullptr, 0);
+    mMeshes.clear();
+    mMeshLoaded.clear();
+    mNodeVisited.clear();
+    mNodes.clear();
+    mSkins.clear();
+    mNodeSkins.clear();
+    mOnVisual = nullptr;
+    mAborted = false;
+    mNumVisuals = 0;
+    mNumZeroCopyBuffers = 0;
+}
+
+bool GLTFLoader::LoadDocument(std::string const& filename)
+{
+    size_t slash = filename.find_last_of("/\\");
+    mDirectory = (slash != std::string::npos ? filename.substr(0, slash + 1) : "");
+
+    auto file = std::make_unique<MappedFile>();
+    if (!file->Open(filename))
+    {
+        LogError("Cannot open file " + filename);
+        return false;
+    }
+
+    char const* json = file->GetData();
+    char const* jsonEnd = json + file->GetSize();
+    if (file->GetSize() >= 12 && ReadUInt32(json) == GLB_MAGIC)
+    {
+        // A .glb file is a 12-byte header followed by a JSON chunk and an
+        // optional binary chunk, each with an 8-byte chunk header.
+        char* data = file->GetData();
+        size_t size = std::min<size_t>(ReadUInt32(data + 8), file->GetSize());
+        if (ReadUInt32(data + 4) != 2 || size < 20)
+        {
+            LogError("Unsupported glb container in " + filename);
+            return false;
+        }
+
+        size_t offset = 12;
+        json = jsonEnd = nullptr;
+        while (offset + 8 <= size)
+        {
+            size_t length = ReadUInt32(data + offset);
+            uint32_t type = ReadUInt32(data + offset + 4);
+            offset += 8;
+            if (length > size - offset)
+            {
+                LogError("Truncated glb chunk in " + filename);
+                return false;
+            }
+            if (type == GLB_CHUNK_JSON && !json)
+            {
+                json = data + offset;
+                jsonEnd = json + length;
+            }
+            else if (type == GLB_CHUNK_BIN && !mBinaryChunk.first)
+            {
+                mBinaryChunk = std::make_pair(data + offset, length);
+            }
+            offset += (length + 3) & ~size_t(3);
+        }
+
+        if (!json)
+        {
+            LogError("Missing JSON chunk in " + filename);
+            return false;
+        }
+    }
+
+    std::string error;
+    if (!Json::Parse(json, jsonEnd, mDocument, error))
+    {
+        LogError("Invalid JSON in " + filename + ": " + error);
+        return false;
+    }
+
+    std::string const& version = mDocument["asset"]["version"].GetString();
+    if (version.empty() || version[0] != '2')
+    {
+        LogError("Unsupported glTF version in " + filename);
+        return false;
+    }
+
+    // A .gltf file is not referenced after parsing, but the mapping of a
+    // .glb file holds the binary chunk.
+    if (mBinaryChunk.first)
+    {
+        mFiles.push_back(std::move(file));
+    }
+    return true;
+}
+
+bool GLTFLoader::LoadBuffers()
+{
+    Json const& buffers = mDocument["buffers"];
+    mBuffers.resize(buffers.GetSize(), std::make_pair(nullptr, 0));
+    for (size_t i = 0; i < buffers.GetSize(); ++i)
+    {
+        Json const& buffer = buffers[i];
+        size_t byteLength = 0;
+        if (!buffer["byteLength"].GetIndex(byteLength))
+        {
+            LogError("Buffer " + std::to_string(i) + " has an invalid byteLength");
+            return false;
+        }
+        std::string const& uri = buffer["uri"].GetString();
+
+        std::pair<char*, size_t> range(nullptr, 0);
+        if (uri.empty())
+        {
+            // Only the first buffer of a .glb file may omit its uri.
+            if (i == 0 && mBinaryChunk.first)
+            {
+                range = mBinaryChunk;
+            }
+        }
+        else if (uri.compare(0, 5, "data:") == 0)
+        {
+            size_t comma = uri.find(',');
+            if (comma == std::string::npos || uri.rfind(";base64", comma) == std::string::npos)
+            {
+                LogError("Unsupported data uri in buffer " + std::to_string(i));
+                return false;
+            }
+            mDecoded.emplace_back();
+            auto& bytes = mDecoded.back();
+            if (!DecodeBase64(uri.data() + comma + 1, uri.size() - comma - 1, bytes))
+            {
+                LogError("Invalid base64 data in buffer " + std::to_string(i));
+                return false;
+            }
+            range = std::make_pair(bytes.data(), bytes.size());
+        }
+        else
+        {
+            auto file = std::make_unique<MappedFile>();
+            std::string path = mDirectory + DecodeURI(uri);
+            if (!file->Open(path))
+            {
+                LogError("Cannot open buffer file " + path);
+                return false;
+            }
+            range = std::make_pair(file->GetData(), file->GetSize());
+            mFiles.push_back(std::move(file));
+        }
+
+        if (!range.first || range.second < byteLength)
+        {
+            LogError("Buffer " + std::to_string(i) + " is missing or too short");
+            return false;
+        }
+        mBuffers[i] = std::make_pair(range.first, byteLength);
+    }
+    return true;
+}
+
+bool GLTFLoader::GetAccessor(Json const& reference, Accessor& accessor) const
+{
+    // The numbers of the files are untrusted input, so each is checked
+    // before it is converted.
+    size_t index = 0, viewIndex = 0, buffer = 0;
+    if (!reference.GetIndex(index))
+    {
+        return false;
+    }
+    Json const& json = mDocument["accessors"][index];
+    if (!json.IsObject() || json.Has("sparse") || !json["bufferView"].GetIndex(viewIndex))
+    {
+        return false;
+    }
+    Json const& view = mDocument["bufferViews"][viewIndex];
+    if (!view.IsObject() || !view["buffer"].GetIndex(buffer) || buffer >= mBuffers.size())
+    {
+        return false;
+    }
+
+    unsigned int const maxUInt = std::numeric_limits<unsigned int>::max();
+    size_t count = 0, componentType = 0, viewOffset = 0, viewLength = 0, offset = 0, stride = 0;
+    if (!json["count"].GetIndex(count) || !json["componentType"].GetIndex(componentType)
+        || !view["byteLength"].GetIndex(viewLength) || !GetSize(view, "byteOffset", 0, viewOffset)
+        || !GetSize(json, "byteOffset", 0, offset) || !GetSize(view, "byteStride", 0, stride)
+        || count > maxUInt || componentType > maxUInt || stride > maxUInt)
+    {
+        return false;
+    }
+
+    accessor.count = static_cast<unsigned int>(count);
+    accessor.componentType = static_cast<unsigned int>(componentType);
+    accessor.numComponents = GetNumComponents(json["type"].GetString());
+    unsigned int elementSize = accessor.numComponents * GetComponentSize(accessor.componentType);
+    if (accessor.count == 0 || elementSize == 0)
+    {
+        return false;
+    }
+    accessor.stride = (stride != 0 ? static_cast<unsigned int>(stride) : elementSize);
+
+    // Every element must lie inside the view and the view inside the
+    // buffer.  The tests are arranged so that no sum or product wraps.
+    size_t const bufferLength = mBuffers[buffer].second;
+    if (accessor.stride < elementSize || viewLength < elementSize
+        || offset > viewLength - elementSize
+        || accessor.count - 1 > (viewLength - elementSize - offset) / accessor.stride
+        || viewOffset > bufferLength || viewLength > bufferLength - viewOffset)
+    {
+        return false;
+    }
+
+    accessor.data = mBuffers[buffer].first + viewOffset + offset;
+    return true;
+}
+
+bool GLTFLoader::GetPrimitives(size_t mesh, std::vector<Primitive>*& primitives)
+{
+    if (mesh >= mMeshes.size())
+    {
+        return false;
+    }
+
+    primitives = &mMeshes[mesh];
+    if (!mMeshLoaded[mesh])
+    {
+        mMeshLoaded[mesh] = true;
+        CreatePrimitives(mesh, *primitives);
+    }
+    return true;
+}
+
+bool GLTFLoader::CreatePrimitives(size_t index, std::vector<Primitive>& primitives)
+{
+    // Only the document and the buffers are read here, so calls for
+    // different meshes may run on different threads.
+    if (index >= GetNumMeshes())
+    {
+        return false;
+    }
+
+    Json const& json = mDocument["meshes"][index]["primitives"];
+    for (size_t i = 0; i < json.GetSize(); ++i)
+    {
+        Json const& primitive = json[i];
+        std::string where = "mesh " + std::to_string(index) + " primitive " + std::to_string(i);
+        if (primitive["mode"].GetInteger(MODE_TRIANGLES) != MODE_TRIANGLES)
+        {
+            LogWarning("Skipping non-triangle " + where);
+            continue;
+        }
+
+        Accessor positions;
+        if (!GetAccessor(primitive["attributes"]["POSITION"], positions)
+            || positions.componentType != COMPONENT_FLOAT || positions.numComponents != 3)
+        {
+            LogWarning("Skipping " + where + " without float3 positions");
+            continue;
+        }
+
+        Primitive result;
+        Json const& attributes = primitive["attributes"];
+        if (attributes.Has("JOINTS_0") && attributes.Has("WEIGHTS_0"))
+        {
+            Accessor joints, weights;
+            if (!GetAccessor(attributes["JOINTS_0"], joints)
+                || !GetAccessor(attributes["WEIGHTS_0"], weights)
+                || !(result.vbuffer = CreateSkinnedVertexBuffer(positions, joints, weights)))
+            {
+                LogWarning("Skipping " + where + " with invalid joints or weights");
+                continue;
+            }
+        }
+        else
+        {
+            result.vbuffer = CreateVertexBuffer(positions);
+        }
+
+        if (primitive.Has("indices"))
+        {
+            Accessor indices;
+            if (!GetAccessor(primitive["indices"], indices)
+                || indices.numComponents != 1 || indices.count % 3 != 0)
+            {
+                LogWarning("Skipping " + where + " with invalid indices");
+                continue;
+            }
+            result.ibuffer = CreateIndexBuffer(indices);
+            if (!result.ibuffer)
+            {
+                LogWarning("Skipping " + where + " with invalid indices");
+                continue;
+            }
+        }
+        else
+        {
+            // Without indices, the vertices are drawn in order.
+            result.ibuffer = std::make_shared<IndexBuffer>(IP_TRIMESH, positions.count / 3);
+        }
+        primitives.push_back(result);
+    }
+    return true;
+}
+
+std::shared_ptr<VertexBuffer> GLTFLoader::CreateVertexBuffer(Accessor const& positions)
+{
+    VertexFormat vformat;
+    vformat.Bind(VA_POSITION, DF_R32G32B32_FLOAT, 0);
+    unsigned int const vertexSize = vformat.GetVertexSize();
+
+    if (positions.stride == vertexSize)
+    {
+        auto vbuffer = std::make_shared<VertexBuffer>(vformat, positions.count, false);
+        vbuffer->SetData(positions.data);
+        ++mNumZeroCopyBuffers;
+        return vbuffer;
+    }
+
+    // Interleaved attributes; gather the positions.
+    auto vbuffer = std::make_shared<VertexBuffer>(vformat, positions.count);
+    char* target = vbuffer->GetData();
+    char const* source = positions.data;
+    for (unsigned int i = 0; i < positions.count; ++i)
+    {
+        std::memcpy(target, source, vertexSize);
+        target += vertexSize;
+        source += positions.stride;
+    }
+    return vbuffer;
+}
+
+std::shared_ptr<VertexBuffer> GLTFLoader::CreateSkinnedVertexBuffer(Accessor const& positions,
+    Accessor const& joints, Accessor const& weights) const
+{
+    if (joints.count != positions.count || weights.count != positions.count
+        || joints.numComponents != 4 || weights.numComponents != 4
+        || (joints.componentType != COMPONENT_UNSIGNED_BYTE
+            && joints.componentType != COMPONENT_UNSIGNED_SHORT)
+        || (weights.componentType != COMPONENT_FLOAT
+            && weights.componentType != COMPONENT_UNSIGNED_BYTE
+            && weights.componentType != COMPONENT_UNSIGNED_SHORT))
+    {
+        return nullptr;
+    }
+
+    // The joints and weights are widened to floats, which every vertex
+    // shader model reads, and the vertices are always copied.
+    VertexFormat vformat;
+    vformat.Bind(VA_POSITION, DF_R32G32B32_FLOAT, 0);
+    vformat.Bind(VA_BLENDINDICES, DF_R32G32B32A32_FLOAT, 0);
+    vformat.Bind(VA_BLENDWEIGHT, DF_R32G32B32A32_FLOAT, 0);
+    auto vbuffer = std::make_shared<VertexBuffer>(vformat, positions.count);
+    float* target = vbuffer->Get<float>();
+    for (unsigned int i = 0; i < positions.count; ++i, target += 11)
+    {
+        std::memcpy(target, positions.data + static_cast<size_t>(i) * positions.stride,
+            3 * sizeof(float));
+
+        char const* joint = joints.data + static_cast<size_t>(i) * joints.stride;
+        char const* weight = weights.data + static_cast<size_t>(i) * weights.stride;
+        for (int c = 0; c < 4; ++c)
+        {
+            if (joints.componentType == COMPONENT_UNSIGNED_BYTE)
+            {
+                target[3 + c] = static_cast<float>(static_cast<uint8_t>(joint[c]));
+            }
+            else
+            {
+                uint16_t value;
+                std::memcpy(&value, joint + 2 * c, sizeof(value));
+                target[3 + c] = static_cast<float>(value);
+            }
+
+            // Integer weights are normalized.
+            if (weights.componentType == COMPONENT_FLOAT)
+            {
+                std::memcpy(&target[7 + c], weight + 4 * c, sizeof(float));
+            }
+            else if (weights.componentType == COMPONENT_UNSIGNED_BYTE)
+            {
+                target[7 + c] = static_cast<uint8_t>(weight[c]) / 255.0f;
+            }
+            else
+            {
+                uint16_t value;
+                std::memcpy(&value, weight + 2 * c, sizeof(value));
+                target[7 + c] = value / 65535.0f;
+            }
+        }
+    }
+    return vbuffer;
+}
+
+std::shared_ptr<IndexBuffer> GLTFLoader::CreateIndexBuffer(Accessor const& indices)
+{
+    unsigned int const numTriangles = indices.count / 3;
+    unsigned int const indexSize = GetComponentSize(indices.componentType);
+    if (indices.componentType == COMPONENT_UNSIGNED_INT
+        || indices.componentType == COMPONENT_UNSIGNED_SHORT)
+    {
+        if (indices.stride == indexSize)
+        {
+            auto ibuffer = std::make_shared<IndexBuffer>(IP_TRIMESH, numTriangles, indexSize, false);
+            ibuffer->SetData(indices.data);
+            ++mNumZeroCopyBuffers;
+            return ibuffer;
+        }
+
+        auto ibuffer = std::make_shared<IndexBuffer>(IP_TRIMESH, numTriangles, indexSize);
+        char* target = ibuffer->GetData();
+        for (unsigned int i = 0; i < indices.count; ++i, target += indexSize)
+        {
+            std::memcpy(target, indices.data + static_cast<size_t>(i) * indices.stride, indexSize);
+        }
+        return ibuffer;
+    }
+
+    if (indices.componentType == COMPONENT_UNSIGNED_BYTE)
+    {
+        // Graphics APIs have no 8-bit index format; widen to 16 bits.
+        auto ibuffer = std::make_shared<IndexBuffer>(IP_TRIMESH, numTriangles, sizeof(uint16_t));
+        auto* target = ibuffer->Get<uint16_t>();
+        for (unsigned int i = 0; i < indices.count; ++i)
+        {
+            target[i] = static_cast<uint8_t>(indices.data[static_cast<size_t>(i) * indices.stride]);
+        }
+        return ibuffer;
+    }
+
+    return nullptr;
+}
+
+std::shared_ptr<Visual> GLTFLoader::CreateVisual(Primitive const& primitive, int skin)
+{
+    auto visual = std::make_shared<Visual>(primitive.vbuffer, primitive.ibuffer);
+    visual->UpdateModelBound();
+    if (mOnVisual && !mOnVisual(visual))
+    {
+        mAborted = true;
+        return nullptr;
+    }
+    ++mNumVisuals;
+
+    if (skin >= 0 && primitive.vbuffer->GetFormat().GetIndex(VA_BLENDINDICES, 0) >= 0)
+    {
+        mSkins[skin].visuals.push_back(visual);
+    }
+    return visual;
+}
+
+int GLTFLoader::GetNodeSkin(Json const& node) const
+{
+    if (!node.Has("skin") || !node.Has("mesh"))
+    {
+        return -1;
+    }
+    size_t skin = 0;
+    return (node["skin"].GetIndex(skin) && skin < mSkins.size() ? static_cast<int>(skin) : -1);
+}
+
+void GLTFLoader::CreateSkins()
+{
+    Json const& skins = mDocument["skins"];
+    for (size_t i = 0; i < mSkins.size(); ++i)
+    {
+        Skin& skin = mSkins[i];
+        Json const& joints = skins[i]["joints"];
+        for (size_t j = 0; j < joints.GetSize(); ++j)
+        {
+            size_t node = 0;
+            if (!joints[j].GetIndex(node) || node >= mNodes.size() || !mNodes[node])
+            {
+                LogWarning("Skin " + std::to_string(i) + " references a missing joint");
+                skin.joints.clear();
+                break;
+            }
+            skin.joints.push_back(mNodes[node]);
+        }
+
+        skin.inverseBindMatrices.assign(skin.joints.size(), Matrix4x4<float>::Identity());
+        if (skin.joints.empty() || !skins[i].Has("inverseBindMatrices"))
+        {
+            continue;
+        }
+
+        Accessor matrices;
+        if (!GetAccessor(skins[i]["inverseBindMatrices"], matrices)
+            || matrices.componentType != COMPONENT_FLOAT || matrices.numComponents != 16
+            || matrices.count < skin.joints.size())
+        {
+            LogWarning("Skin " + std::to_string(i) + " has invalid inverse bind matrices");
+            skin.joints.clear();
+            skin.inverseBindMatrices.clear();
+            continue;
+        }
+
+        // Column-major matrices that multiply column vectors, as in
+        // SetTransform.
+        for (size_t j = 0; j < skin.joints.size(); ++j)
+        {
+            float values[16];
+            std::memcpy(values, matrices.data + j * matrices.stride, sizeof(values));
+            Matrix4x4<float>& M = skin.inverseBindMatrices[j];
+            for (int r = 0; r < 4; ++r)
+            {
+                for (int c = 0; c < 4; ++c)
+                {
+#if defined(GTE_USE_VEC_MAT)
+                    M(c, r) = values[4 * c + r];
+#else
+                    M(r, c) = values[4 * c + r];
+#endif
+                }
+            }
+        }
+    }
+}
+
+std::shared_ptr<Spatial> GLTFLoader::CreateSpatial(size_t index, int depth,
+    std::vector<std::vector<std::shared_ptr<Node>>>* meshParents)
+{
+    // glTF requires the nodes to form a forest; a node reached twice or a
+    // runaway depth means the file is malformed, and the repeated
+    // reference is dropped rather than recursing forever.
+    size_t const i = index;
+    if (i >= mNodeVisited.size() || mNodeVisited[i] || depth > MAX_NODE_DEPTH)
+    {
+        LogWarning("Skipping invalid node reference " + std::to_string(index));
+        return nullptr;
+    }
+    mNodeVisited[i] = true;
+
+    Json const& json = mDocument["nodes"][i];
+    Json const& children = json["children"];
+    int const skin = GetNodeSkin(json);
+
+    // When the meshes are decoded elsewhere, a mesh node is always a Node
+    // and the mesh is recorded for it.
+    if (meshParents)
+    {
+        auto node = std::make_shared<Node>();
+        SetTransform(json, *node);
+        mNodes[i] = node;
+        if (json.Has("mesh"))
+        {
+            size_t mesh = 0;
+            if (json["mesh"].GetIndex(mesh) && mesh < meshParents->size())
+            {
+                (*meshParents)[mesh].push_back(node);
+                if (skin >= 0)
+                {
+                    mNodeSkins[node.get()] = skin;
+                }
+            }
+            else
+            {
+                LogWarning("Skipping invalid mesh reference of node " + std::to_string(index));
+            }
+        }
+        for (size_t j = 0; j < children.GetSize(); ++j)
+        {
+            size_t childIndex = 0;
+            if (!children[j].GetIndex(childIndex))
+            {
+                LogWarning("Skipping invalid child reference of node " + std::to_string(index));
+                continue;
+            }
+            auto child = CreateSpatial(childIndex, depth + 1, meshParents);
+            if (child)
+            {
+                node->AttachChild(child);
+            }
+        }
+        return node;
+    }
+
+    std::vector<Primitive>* primitives = nullptr;
+    size_t mesh = 0;
+    if (json.Has("mesh") && (!json["mesh"].GetIndex(mesh) || !GetPrimitives(mesh, primitives)))
+    {
+        LogWarning("Skipping invalid mesh reference of node " + std::to_string(index));
+    }
+
+    // A mesh node with one primitive and no children becomes the Visual
+    // itself, which keeps the scene graph shallow for flat assets.
+    if (primitives && primitives->size() == 1 && children.GetSize() == 0)
+    {
+        auto visual = CreateVisual(primitives->front(), skin);
+        if (visual)
+        {
+            SetTransform(json, *visual);
+            mNodes[i] = visual;
+        }
+        return visual;
+    }
+
+    auto node = std::make_shared<Node>();
+    SetTransform(json, *node);
+    mNodes[i] = node;
+    if (primitives)
+    {
+        for (auto const& primitive : *primitives)
+        {
+            auto visual = CreateVisual(primitive, skin);
+            if (!visual)
+            {
+                return nullptr;
+            }
+            node->AttachChild(visual);
+        }
+    }
+
+    for (size_t j = 0; j < children.GetSize(); ++j)
+    {
+        size_t childIndex = 0;
+        if (!children[j].GetIndex(childIndex))
+        {
+            LogWarning("Skipping invalid child reference of node " + std::to_string(index));
+            continue;
+        }
+        auto child = CreateSpatial(childIndex, depth + 1, nullptr);
+        if (mAborted)
+        {
+            return nullptr;
+        }
+        if (child)
+        {
+            node->AttachChild(child);
+        }
+    }
+    return node;
+}
+
+void GLTFLoader::SetTransform(Json const& node, Spatial& spatial) const
+{
+    Json const& matrix = node["matrix"];
+    if (matrix.GetSize() == 16)
+    {
+        // glTF stores column-major matrices that multiply column vectors.
+        Matrix4x4<float> M;
+        for (int r = 0; r < 4; ++r)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+#if defined(GTE_USE_VEC_MAT)
+                M(c, r) = static_cast<float>(matrix[4 * c + r].GetNumber());
+#else
+                M(r, c) = static_cast<float>(matrix[4 * c + r].GetNumber());
+#endif
+            }
+        }
+        spatial.localTransform.SetMatrix(M);
+        return;
+    }
+
+    Json const& translation = node["translation"];
+    if (translation.GetSize() == 3)
+    {
+        spatial.localTransform.SetTranslation(
+            static_cast<float>(translation[0].GetNumber()),
+            static_cast<float>(translation[1].GetNumber()),
+            static_cast<float>(translation[2].GetNumber()));
+    }
+
+    // glTF and GTE both order quaternion components as (x, y, z, w).
+    Json const& rotation = node["rotation"];
+    if (rotation.GetSize() == 4)
+    {
+        spatial.localTransform.SetRotation(Quaternion<float>(
+            static_cast<float>(rotation[0].GetNumber()),
+            static_cast<float>(rotation[1].GetNumber()),
+            static_cast<float>(rotation[2].GetNumber()),
+            static_cast<float>(rotation[3].GetNumber(1.0))));
+    }
+
+    Json const& scale = node["scale"];
+    if (scale.GetSize() == 3)
+    {
+        spatial.localTransform.SetScale(
+            static_cast<float>(scale[0].GetNumber(1.0)),
+            static_cast<float>(scale[1].GetNumber(1.0)),
+            static_cast<float>(scale[2].GetNumber(1.0)));
+    }
+}
@@ -0,0 +1,155 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#pragma once
+
+#include <Graphics/IndexBuffer.h>
+#include <Graphics/Node.h>
+#include <Graphics/VertexBuffer.h>
+#include <Graphics/Visual.h>
+#include <Mathematics/Matrix4x4.h>
+#include "Json.h"
+#include "MappedFile.h"
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace gte
+{
+    class GLTFLoader
+    {
+    public:
+        // Construction.  The loader reads glTF 2.0 scenes from .gltf files
+        // (with external or embedded buffers) and from .glb files, and
+        // builds a Node hierarchy whose Visuals have VA_POSITION vertex
+        // buffers and triangle index buffers.  The vertex buffers of
+        // skinned primitives (JOINTS_0 and WEIGHTS_0) also have float4
+        // VA_BLENDINDICES and VA_BLENDWEIGHT attributes.  Binary buffers
+        // are memory mapped, and when an accessor is tightly packed the
+        // vertex or index buffer uses the mapped bytes as its storage.  The
+        // loader owns the mappings, so it must outlive the scene it loaded.
+        GLTFLoader();
+
+        // The callback is invoked for every Visual that is created, before
+        // it is attached to its parent; the application attaches its effect
+        // there and subscribes the world transform for PVW updates.  When
+        // the callback returns false, loading stops.  Several nodes may
+        // reference one glTF mesh; their Visuals then share the vertex and
+        // index buffers.  Load returns null on failure and reports the
+        // reason with LogError.
+        typedef std::function<bool(std::shared_ptr<Visual> const&)> VisualCallback;
+
+        std::shared_ptr<Node> Load(std::string const& filename,
+            VisualCallback const& onVisual = nullptr);
+
+        // Release the document and the mapped files.
+        void Clear();
+
+        // The steps of Load, for loaders that decode meshes on other
+        // threads.  Open parses the document and maps the buffers.
+        // CreateHierarchy builds the Nodes of the default scene with their
+        // transforms but without Visuals, and records for every glTF mesh
+        // the Nodes that reference it.  After that, CreatePrimitives may be
+        // called concurrently for different meshes.
+        struct Primitive
+        {
+            std::shared_ptr<VertexBuffer> vbuffer;
+            std::shared_ptr<IndexBuffer> ibuffer;
+        };
+
+        bool Open(std::string const& filename);
+        std::shared_ptr<Node> CreateHierarchy(std::vector<std::vector<std::shared_ptr<Node>>>& meshParents);
+        bool CreatePrimitives(size_t mesh, std::vector<Primitive>& primitives);
+
+        // The skins of the document, after Load or CreateHierarchy.  The
+        // joints are the Spatials of the joint nodes, and the inverse bind
+        // matrices (identities when the file has none) are in the GTE
+        // matrix convention.  Load lists the skinned Visuals of each skin;
+        // after CreateHierarchy, GetSkin returns the skin of a node in
+        // meshParents, or -1, so that the caller can list them.  A skin
+        // whose joints are missing has no joints.
+        struct Skin
+        {
+            std::vector<std::shared_ptr<Spatial>> joints;
+            std::vector<Matrix4x4<float>> inverseBindMatrices;
+            std::vector<std::shared_ptr<Visual>> visuals;
+        };
+
+        inline std::vector<Skin> const& GetSkins() const
+        {
+            return mSkins;
+        }
+
+        int GetSkin(Node const* meshParent) const;
+
+        inline size_t GetNumMeshes() const
+        {
+            return mDocument["meshes"].GetSize();
+        }
+
+        // Statistics for the most recent Load call.
+        inline unsigned int GetNumVisuals() const
+        {
+            return mNumVisuals;
+        }
+
+        inline unsigned int GetNumZeroCopyBuffers() const
+        {
+            return mNumZeroCopyBuffers.load();
+        }
+
+    private:
+        struct Accessor
+        {
+            char* data;
+            unsigned int count;
+            unsigned int componentType;
+            unsigned int numComponents;
+            unsigned int stride;
+        };
+
+        bool LoadDocument(std::string const& filename);
+        bool LoadBuffers();
+        bool GetAccessor(Json const& reference, Accessor& accessor) const;
+        bool GetPrimitives(size_t mesh, std::vector<Primitive>*& primitives);
+        std::shared_ptr<VertexBuffer> CreateVertexBuffer(Accessor const& positions);
+        std::shared_ptr<VertexBuffer> CreateSkinnedVertexBuffer(Accessor const& positions,
+            Accessor const& joints, Accessor const& weights) const;
+        std::shared_ptr<IndexBuffer> CreateIndexBuffer(Accessor const& indices);
+        std::shared_ptr<Visual> CreateVisual(Primitive const& primitive, int skin);
+        int GetNodeSkin(Json const& node) const;
+        void CreateSkins();
+        std::vector<size_t> GetRootNodes() const;
+        std::shared_ptr<Spatial> CreateSpatial(size_t index, int depth,
+            std::vector<std::vector<std::shared_ptr<Node>>>* meshParents);
+        void SetTransform(Json const& node, Spatial& spatial) const;
+
+        Json mDocument;
+        std::string mDirectory;
+        std::vector<std::unique_ptr<MappedFile>> mFiles;
+        std::vector<std::vector<char>> mDecoded;
+        std::vector<std::pair<char*, size_t>> mBuffers;
+        std::pair<char*, size_t> mBinaryChunk;
+
+        std::vector<std::vector<Primitive>> mMeshes;
+        std::vector<bool> mMeshLoaded;
+        std::vector<bool> mNodeVisited;
+
+        // The Spatial created for each glTF node, to find the joints.
+        std::vector<std::shared_ptr<Spatial>> mNodes;
+        std::vector<Skin> mSkins;
+        std::map<Node const*, int> mNodeSkins;
+        VisualCallback mOnVisual;
+        bool mAborted;
+
+        unsigned int mNumVisuals;
+        std::atomic<unsigned int> mNumZeroCopyBuffers;
+    };
+}
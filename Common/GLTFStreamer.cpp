@@ -0,0 +1,211 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#include "GLTFStreamer.h"
+#include "Profiler.h"
+#include <algorithm>
+using namespace gte;
+
+GLTFStreamer::~GLTFStreamer()
+{
+    Cancel();
+}
+
+GLTFStreamer::GLTFStreamer(unsigned int numThreads, size_t queueCapacity)
+    :
+    mNextMesh(0),
+    mNumThreads(numThreads > 0 ? numThreads :
+        std::max(1u, std::thread::hardware_concurrency() - 1)),
+    mCapacity(std::max<size_t>(queueCapacity, 1)),
+    mCancel(false),
+    mLoaderState(IDLE),
+    mNumVisuals(0)
+{
+}
+
+void GLTFStreamer::Start(std::string const& filename)
+{
+    Cancel();
+    mCancel = false;
+    mLoaderState = LOADING;
+    mNumVisuals = 0;
+    mSkins.clear();
+    mLoaderThread = std::thread(&GLTFStreamer::LoaderThread, this, filename);
+}
+
+void GLTFStreamer::Cancel()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mCancel = true;
+    }
+    mNotFull.notify_all();
+    if (mLoaderThread.joinable())
+    {
+        mLoaderThread.join();
+    }
+
+    // The objects still queued belong to the cancelled scene.
+    std::lock_guard<std::mutex> lock(mMutex);
+    mQueue.clear();
+    mLoaderState = IDLE;
+}
+
+size_t GLTFStreamer::Update(std::shared_ptr<Node> const& root,
+    GLTFLoader::VisualCallback const& onVisual, size_t maxItems)
+{
+    GTE_PROFILE_SCOPE("GLTFStreamer::Update");
+    // Take the items under the lock and attach them outside of it, so the
+    // decoders are never blocked by the callback.
+    mPending.clear();
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        size_t numItems = std::min(maxItems, mQueue.size());
+        for (size_t i = 0; i < numItems; ++i)
+        {
+            mPending.push_back(std::move(mQueue.front()));
+            mQueue.pop_front();
+        }
+    }
+    if (mPending.empty())
+    {
+        return 0;
+    }
+    mNotFull.notify_all();
+
+    for (auto& item : mPending)
+    {
+        if (!item.parent)
+        {
+            root->AttachChild(item.child);
+            item.child->Update();
+            continue;
+        }
+
+        auto visual = std::static_pointer_cast<Visual>(item.child);
+        if (onVisual && !onVisual(visual))
+        {
+            continue;
+        }
+        item.parent->AttachChild(visual);
+        visual->Update();
+        ++mNumVisuals;
+        if (item.skin >= 0)
+        {
+            mSkins[item.skin].visuals.push_back(visual);
+        }
+    }
+
+    size_t numAttached = mPending.size();
+    mPending.clear();
+    return numAttached;
+}
+
+GLTFStreamer::State GLTFStreamer::GetState() const
+{
+    State state = static_cast<State>(mLoaderState.load());
+    if (state == FINISHED || state == FAILED)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mQueue.empty())
+        {
+            return LOADING;
+        }
+    }
+    return state;
+}
+
+void GLTFStreamer::LoaderThread(std::string filename)
+{
+    Profiler::SetThreadName("GLTFStreamer loader");
+    {
+        GTE_PROFILE_SCOPE("GLTFLoader::Open");
+        if (!mLoader.Open(filename))
+        {
+            mLoaderState = FAILED;
+            return;
+        }
+    }
+
+    // The hierarchy is queued first so that every Visual finds its parent
+    // already attached to the application's scene.
+    std::shared_ptr<Node> scene;
+    {
+        GTE_PROFILE_SCOPE("GLTFLoader::CreateHierarchy");
+        scene = mLoader.CreateHierarchy(mMeshParents);
+    }
+    mSkins = mLoader.GetSkins();
+    if (!Push({ nullptr, scene, -1 }))
+    {
+        return;
+    }
+
+    mNextMesh = 0;
+    mDecoders.clear();
+    for (unsigned int i = 0; i < mNumThreads; ++i)
+    {
+        mDecoders.emplace_back(&GLTFStreamer::DecoderThread, this);
+    }
+    for (auto& decoder : mDecoders)
+    {
+        decoder.join();
+    }
+    mDecoders.clear();
+    mMeshParents.clear();
+
+    if (!mCancel)
+    {
+        mLoaderState = FINISHED;
+    }
+}
+
+void GLTFStreamer::DecoderThread()
+{
+    Profiler::SetThreadName("GLTFStreamer decoder");
+    std::vector<GLTFLoader::Primitive> primitives;
+    size_t const numMeshes = mMeshParents.size();
+    while (!mCancel)
+    {
+        size_t mesh = mNextMesh.fetch_add(1);
+        if (mesh >= numMeshes)
+        {
+            return;
+        }
+
+        GTE_PROFILE_SCOPE("DecodeMesh");
+        primitives.clear();
+        mLoader.CreatePrimitives(mesh, primitives);
+
+        // Nodes that reference the same mesh share its buffers.
+        for (auto const& parent : mMeshParents[mesh])
+        {
+            int const skin = mLoader.GetSkin(parent.get());
+            for (auto const& primitive : primitives)
+            {
+                auto visual = std::make_shared<Visual>(primitive.vbuffer, primitive.ibuffer);
+                visual->UpdateModelBound();
+                bool const skinned = (primitive.vbuffer->GetFormat().GetIndex(VA_BLENDINDICES, 0) >= 0);
+                if (!Push({ parent, visual, skinned ? skin : -1 }))
+                {
+                    return;
+                }
+            }
+        }
+    }
+}
+
+bool GLTFStreamer::Push(Item&& item)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mNotFull.wait(lock, [this]() { return mCancel || mQueue.size() < mCapacity; });
+    if (mCancel)
+    {
+        return false;
+    }
+    mQueue.push_back(std::move(item));
+    return true;
+}
@@ -0,0 +1,106 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#pragma once
+
+#include "GLTFLoader.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace gte
+{
+    class GLTFStreamer
+    {
+    public:
+        // Construction.  The streamer loads a glTF scene in the background:
+        // a loader thread parses the document and builds the Node
+        // hierarchy, then numThreads decoder threads (the number of
+        // hardware threads minus one when 0) turn the meshes into Visuals.
+        // Finished objects go into a queue of at most queueCapacity items;
+        // the decoders wait when it is full, which bounds the memory of a
+        // scene that decodes faster than the application consumes it.
+        ~GLTFStreamer();
+        GLTFStreamer(unsigned int numThreads = 0, size_t queueCapacity = 256);
+
+        // Start loading 'filename'.  A load in progress is cancelled first.
+        void Start(std::string const& filename);
+        void Cancel();
+
+        // Call once per frame on the render thread.  Up to maxItems queued
+        // objects are attached: first the hierarchy under 'root', then the
+        // Visuals under their glTF nodes.  The callback is invoked for every
+        // Visual before it is attached (to set its effect and subscribe its
+        // world transform), and each attached Visual is updated so that its
+        // world transform and the bounds of its ancestors are current.  The
+        // return value is the number of objects attached.
+        size_t Update(std::shared_ptr<Node> const& root,
+            GLTFLoader::VisualCallback const& onVisual, size_t maxItems = 64);
+
+        enum State
+        {
+            IDLE,
+            LOADING,
+            FINISHED,
+            FAILED
+        };
+
+        // The state reaches FINISHED or FAILED only after Update has
+        // attached every queued object.
+        State GetState() const;
+
+        inline size_t GetNumVisuals() const
+        {
+            return mNumVisuals;
+        }
+
+        // The skins of the scene, available once the hierarchy is attached.
+        // Update appends the skinned Visuals it attaches to the visuals of
+        // their skins.
+        inline std::vector<GLTFLoader::Skin> const& GetSkins() const
+        {
+            return mSkins;
+        }
+
+    private:
+        // A null parent marks the root of the loaded hierarchy.  The skin is
+        // -1 for Visuals that are not skinned.
+        struct Item
+        {
+            std::shared_ptr<Node> parent;
+            std::shared_ptr<Spatial> child;
+            int skin;
+        };
+
+        void LoaderThread(std::string filename);
+        void DecoderThread();
+        bool Push(Item&& item);
+
+        GLTFLoader mLoader;
+        std::vector<std::vector<std::shared_ptr<Node>>> mMeshParents;
+        std::atomic<size_t> mNextMesh;
+        unsigned int mNumThreads;
+
+        std::thread mLoaderThread;
+        std::vector<std::thread> mDecoders;
+
+        mutable std::mutex mMutex;
+        std::condition_variable mNotFull;
+        std::deque<Item> mQueue;
+        size_t mCapacity;
+        std::vector<Item> mPending;
+
+        // Written by the loader thread before it queues the hierarchy, and
+        // read and changed by Update only after it has taken the hierarchy.
+        std::vector<GLTFLoader::Skin> mSkins;
+
+        std::atomic<bool> mCancel;
+        std::atomic<int> mLoaderState;
+        size_t mNumVisuals;
+    };
+}
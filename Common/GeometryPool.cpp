@@ -0,0 +1,172 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#include "GeometryPool.h"
+#include <Mathematics/Logger.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+using namespace gte;
+
+namespace
+{
+    bool SameFormat(VertexFormat const& format0, VertexFormat const& format1)
+    {
+        if (format0.GetNumAttributes() != format1.GetNumAttributes()
+            || format0.GetVertexSize() != format1.GetVertexSize())
+        {
+            return false;
+        }
+
+        for (int i = 0; i < format0.GetNumAttributes(); ++i)
+        {
+            VASemantic semantic0 = VA_NO_SEMANTIC, semantic1 = VA_NO_SEMANTIC;
+            DFType type0 = DF_UNKNOWN, type1 = DF_UNKNOWN;
+            unsigned int unit0 = 0, unit1 = 0, offset0 = 0, offset1 = 0;
+            format0.GetAttribute(i, semantic0, type0, unit0, offset0);
+            format1.GetAttribute(i, semantic1, type1, unit1, offset1);
+            if (semantic0 != semantic1 || type0 != type1 || unit0 != unit1 || offset0 != offset1)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+GeometryPool::GeometryPool(VertexFormat const& vformat, unsigned int verticesPerPage)
+    :
+    mFormat(vformat),
+    mVerticesPerPage(std::max(verticesPerPage, 1u)),
+    mSealed(false),
+    mNumHits(0)
+{
+}
+
+std::shared_ptr<Visual> GeometryPool::Create(std::string const& key, Generator const& generator)
+{
+    auto element = mMeshes.find(key);
+    if (element != mMeshes.end())
+    {
+        ++mNumHits;
+    }
+    else
+    {
+        auto generated = (generator ? generator() : nullptr);
+        auto vbuffer = (generated ? generated->GetVertexBuffer() : nullptr);
+        auto ibuffer = (generated ? generated->GetIndexBuffer() : nullptr);
+        if (!vbuffer || !ibuffer || !vbuffer->GetData() || ibuffer->GetPrimitiveType() != IP_TRIMESH)
+        {
+            LogError("Mesh " + key + " is not a triangle mesh");
+            return nullptr;
+        }
+        if (!SameFormat(vbuffer->GetFormat(), mFormat))
+        {
+            LogError("Mesh " + key + " does not have the vertex format of the pool");
+            return nullptr;
+        }
+
+        // An index buffer without indices draws the vertices in order.
+        size_t const indexSize = (ibuffer->IsIndexed() ? ibuffer->GetElementSize() : 0);
+        if (indexSize != 0 && indexSize != sizeof(uint16_t) && indexSize != sizeof(uint32_t))
+        {
+            LogError("Mesh " + key + " has indices of an unsupported size");
+            return nullptr;
+        }
+
+        unsigned int const numVertices = vbuffer->GetNumElements();
+        unsigned int const numIndices = 3 * ibuffer->GetNumPrimitives();
+        unsigned int const stride = mFormat.GetVertexSize();
+        char const* indices = ibuffer->GetData();
+        std::vector<uint32_t> pooledIndices(numIndices);
+        for (unsigned int i = 0; i < numIndices; ++i)
+        {
+            uint32_t v = i;
+            if (indexSize == sizeof(uint32_t))
+            {
+                v = reinterpret_cast<uint32_t const*>(indices)[i];
+            }
+            else if (indexSize == sizeof(uint16_t))
+            {
+                v = reinterpret_cast<uint16_t const*>(indices)[i];
+            }
+
+            if (v >= numVertices)
+            {
+                LogError("Mesh " + key + " has an index out of range");
+                return nullptr;
+            }
+            pooledIndices[i] = v;
+        }
+
+        Mesh mesh;
+        unsigned int first = 0;
+        mesh.vbuffer = Allocate(numVertices, first);
+        char* target = mesh.vbuffer->GetData() + static_cast<size_t>(first) * stride;
+        std::memcpy(target, vbuffer->GetData(), static_cast<size_t>(numVertices) * stride);
+
+        // GL45Engine draws indexed primitives without a base vertex, so the
+        // indices address the page rather than the mesh.
+        mesh.ibuffer = std::make_shared<IndexBuffer>(IP_TRIMESH, numIndices / 3, sizeof(uint32_t));
+        auto* target32 = mesh.ibuffer->Get<uint32_t>();
+        for (unsigned int i = 0; i < numIndices; ++i)
+        {
+            target32[i] = first + pooledIndices[i];
+        }
+
+        int position = mFormat.GetIndex(VA_POSITION, 0);
+        if (position >= 0)
+        {
+            mesh.modelBound.ComputeFromData(static_cast<int>(numVertices),
+                static_cast<int>(stride), target + mFormat.GetOffset(position));
+        }
+
+        element = mMeshes.insert(std::make_pair(key, std::move(mesh))).first;
+    }
+
+    auto visual = std::make_shared<Visual>(element->second.vbuffer, element->second.ibuffer);
+    visual->modelBound = element->second.modelBound;
+    return visual;
+}
+
+void GeometryPool::Seal()
+{
+    mSealed = true;
+}
+
+void GeometryPool::Clear()
+{
+    mPages.clear();
+    mSealed = false;
+    mMeshes.clear();
+    mNumHits = 0;
+}
+
+std::shared_ptr<VertexBuffer> GeometryPool::Allocate(unsigned int numVertices, unsigned int& first)
+{
+    // A mesh goes into the last page when it fits; the earlier pages are
+    // nearly full, and searching them would scatter the meshes that are
+    // created together.
+    if (!mSealed && !mPages.empty())
+    {
+        auto const& page = mPages.back();
+        unsigned int used = page->GetNumActiveElements();
+        if (numVertices <= page->GetNumElements() - used)
+        {
+            first = used;
+            page->SetNumActiveElements(used + numVertices);
+            return page;
+        }
+    }
+
+    auto page = std::make_shared<VertexBuffer>(mFormat, std::max(numVertices, mVerticesPerPage));
+    page->SetNumActiveElements(numVertices);
+    mPages.push_back(page);
+    mSealed = false;
+    first = 0;
+    return page;
+}
@@ -0,0 +1,86 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#pragma once
+
+#include <Graphics/Visual.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace gte
+{
+    class GeometryPool
+    {
+    public:
+        // Construction.  The pool packs the vertices of many meshes into a
+        // few vertex buffers (pages) of verticesPerPage vertices; a mesh
+        // with more vertices gets a page of its own.  Every distinct mesh
+        // has a 32-bit index buffer whose indices address its page, so an
+        // ordinary Visual draws it, and the Visuals of one mesh share the
+        // page and the index buffer, which InstancedBatcher relies on.
+        GeometryPool(VertexFormat const& vformat, unsigned int verticesPerPage = 65536);
+
+        // Return a new Visual for the mesh named 'key', which should spell
+        // out the generator and its parameters, for example "sphere 16 16
+        // 1".  The generator runs only for the first request of a key; its
+        // vertices and indices are copied into the pool and the generated
+        // Visual is released.  The model bound of the returned Visual is
+        // set.  Do not call UpdateModelBound on it, which would measure the
+        // whole page.  Create returns null, and reports the reason with
+        // LogError, when the generated mesh is not a triangle mesh with the
+        // vertex format of the pool.
+        typedef std::function<std::shared_ptr<Visual>()> Generator;
+
+        std::shared_ptr<Visual> Create(std::string const& key, Generator const& generator);
+
+        // A page is uploaded on the first draw of one of its meshes and not
+        // updated afterwards.  Call Seal once the meshes that are about to
+        // be drawn exist, so that later meshes start a new page.
+        void Seal();
+
+        void Clear();
+
+        // Statistics.
+        inline size_t GetNumPages() const
+        {
+            return mPages.size();
+        }
+
+        inline size_t GetNumMeshes() const
+        {
+            return mMeshes.size();
+        }
+
+        // The number of Create calls that reused a mesh.
+        inline size_t GetNumHits() const
+        {
+            return mNumHits;
+        }
+
+    private:
+        struct Mesh
+        {
+            std::shared_ptr<VertexBuffer> vbuffer;
+            std::shared_ptr<IndexBuffer> ibuffer;
+            BoundingSphere modelBound;
+        };
+
+        // Return a page with room for numVertices vertices and the index
+        // of its first free vertex.
+        std::shared_ptr<VertexBuffer> Allocate(unsigned int numVertices, unsigned int& first);
+
+        VertexFormat mFormat;
+        unsigned int mVerticesPerPage;
+        std::vector<std::shared_ptr<VertexBuffer>> mPages;
+        bool mSealed;
+        std::map<std::string, Mesh> mMeshes;
+        size_t mNumHits;
+    };
+}
@@ -0,0 +1,219 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#include "InstancedBatcher.h"
+#include "EffectCache.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+using namespace gte;
+
+InstancedBatcher::InstancedBatcher(std::shared_ptr<VisualProgram> const& program,
+    unsigned int minInstances)
+    :
+    mProgram(program),
+    mPVMatrix(std::make_shared<ConstantBuffer>(sizeof(Matrix4x4<float>), true)),
+    mMinInstances(minInstances),
+    mNumDrawCalls(0),
+    mNumInstancedVisuals(0)
+{
+    mProgram->GetVertexShader()->Set("PVMatrix", mPVMatrix);
+}
+
+void InstancedBatcher::Begin()
+{
+    for (auto group : mActive)
+    {
+        group->members.clear();
+    }
+    mActive.clear();
+}
+
+bool InstancedBatcher::Add(Visual* visual)
+{
+    Key key(visual->GetVertexBuffer().get(), visual->GetIndexBuffer().get());
+    auto element = mGroups.find(key);
+    Group* group;
+    if (element != mGroups.end())
+    {
+        group = element->second.get();
+    }
+    else
+    {
+        group = CreateGroup(visual);
+        mGroups[key].reset(group);
+    }
+
+    if (!group)
+    {
+        return false;
+    }
+
+    if (group->members.empty())
+    {
+        mActive.push_back(group);
+    }
+    group->members.push_back(visual);
+    return true;
+}
+
+void InstancedBatcher::End(std::shared_ptr<GraphicsEngine> const& engine,
+    Matrix4x4<float> const& pvMatrix)
+{
+    mNumDrawCalls = 0;
+    mNumInstancedVisuals = 0;
+
+    bool pvMatrixUpdated = false;
+    auto const& vshader = mProgram->GetVertexShader();
+    for (auto group : mActive)
+    {
+        unsigned int numInstances = static_cast<unsigned int>(group->members.size());
+        if (numInstances < mMinInstances)
+        {
+            for (auto visual : group->members)
+            {
+                EffectCache::Bind(visual);
+                engine->Draw(visual);
+                ++mNumDrawCalls;
+            }
+            continue;
+        }
+
+        if (!pvMatrixUpdated)
+        {
+            *mPVMatrix->Get<Matrix4x4<float>>() = pvMatrix;
+            engine->Update(mPVMatrix);
+            pvMatrixUpdated = true;
+        }
+
+        Reserve(*group, numInstances);
+        auto* worldMatrices = group->worldMatrices->Get<Matrix4x4<float>>();
+        for (auto visual : group->members)
+        {
+            *worldMatrices++ = visual->worldTransform.GetHMatrix();
+        }
+        group->worldMatrices->SetNumActiveElements(numInstances);
+        engine->Update(group->worldMatrices);
+
+        group->visual->GetVertexBuffer()->SetNumActiveElements(numInstances * group->numIndices);
+        group->visual->GetIndexBuffer()->SetNumActivePrimitives(numInstances * group->numIndices / 3);
+
+        // The groups share the program, so the mesh bindings of the vertex
+        // shader are switched before each draw.
+        vshader->Set("InstanceParameters", group->parameters);
+        vshader->Set("Positions", group->positions);
+        vshader->Set("Indices", group->indices);
+        vshader->Set("WorldMatrices", group->worldMatrices);
+        engine->Draw(group->visual.get());
+
+        ++mNumDrawCalls;
+        mNumInstancedVisuals += numInstances;
+    }
+}
+
+void InstancedBatcher::Clear()
+{
+    mActive.clear();
+    mGroups.clear();
+}
+
+InstancedBatcher::Group* InstancedBatcher::CreateGroup(Visual* visual)
+{
+    auto const& vbuffer = visual->GetVertexBuffer();
+    auto const& ibuffer = visual->GetIndexBuffer();
+    if (!vbuffer || !ibuffer || !vbuffer->GetData() || !ibuffer->GetData())
+    {
+        return nullptr;
+    }
+
+    if (ibuffer->GetPrimitiveType() != IP_TRIMESH || ibuffer->GetElementSize() != sizeof(uint32_t))
+    {
+        return nullptr;
+    }
+
+    VertexFormat const& vformat = vbuffer->GetFormat();
+    int index = vformat.GetIndex(VA_POSITION, 0);
+    if (index < 0)
+    {
+        return nullptr;
+    }
+    DFType type = vformat.GetType(index);
+    if (type != DF_R32G32B32_FLOAT && type != DF_R32G32B32A32_FLOAT)
+    {
+        return nullptr;
+    }
+
+    // The mesh may occupy a range of a vertex buffer that it shares with
+    // other meshes (GeometryPool), so only the referenced vertices are
+    // copied and the indices are rebased to the first of them.
+    unsigned int const numIndices = ibuffer->GetNumElements();
+    auto const* meshIndices = ibuffer->Get<uint32_t>();
+    if (numIndices == 0)
+    {
+        return nullptr;
+    }
+    auto bounds = std::minmax_element(meshIndices, meshIndices + numIndices);
+    uint32_t const minIndex = *bounds.first;
+    uint32_t const maxIndex = *bounds.second;
+    if (maxIndex >= vbuffer->GetNumElements())
+    {
+        return nullptr;
+    }
+
+    auto group = new Group();
+
+    // The positions are widened to float4 so that the structured buffer
+    // has the same layout in HLSL and in GLSL std430.
+    unsigned int const numVertices = maxIndex - minIndex + 1;
+    unsigned int const stride = vformat.GetVertexSize();
+    char const* source = vbuffer->GetData() + static_cast<size_t>(minIndex) * stride
+        + vformat.GetOffset(index);
+    group->positions = std::make_shared<StructuredBuffer>(numVertices, sizeof(Vector4<float>));
+    auto* positions = group->positions->Get<Vector4<float>>();
+    for (unsigned int i = 0; i < numVertices; ++i, source += stride)
+    {
+        float xyz[3];
+        std::memcpy(xyz, source, sizeof(xyz));
+        positions[i] = { xyz[0], xyz[1], xyz[2], 1.0f };
+    }
+
+    group->numIndices = numIndices;
+    group->indices = std::make_shared<StructuredBuffer>(numIndices, sizeof(uint32_t));
+    auto* indices = group->indices->Get<uint32_t>();
+    for (unsigned int i = 0; i < numIndices; ++i)
+    {
+        indices[i] = meshIndices[i] - minIndex;
+    }
+
+    group->parameters = std::make_shared<ConstantBuffer>(sizeof(Vector4<uint32_t>), false);
+    *group->parameters->Get<uint32_t>() = group->numIndices;
+
+    group->capacity = 0;
+    return group;
+}
+
+void InstancedBatcher::Reserve(Group& group, unsigned int numInstances)
+{
+    if (numInstances <= group.capacity)
+    {
+        return;
+    }
+
+    unsigned int capacity = std::max(group.capacity, 16u);
+    while (capacity < numInstances)
+    {
+        capacity *= 2;
+    }
+    group.capacity = capacity;
+
+    group.worldMatrices = std::make_shared<StructuredBuffer>(capacity, sizeof(Matrix4x4<float>));
+    group.worldMatrices->SetUsage(Resource::DYNAMIC_UPDATE);
+
+    auto vbuffer = std::make_shared<VertexBuffer>(capacity * group.numIndices);
+    auto ibuffer = std::make_shared<IndexBuffer>(IP_TRIMESH, capacity * group.numIndices / 3);
+    group.visual = std::make_shared<Visual>(vbuffer, ibuffer, std::make_shared<VisualEffect>(mProgram));
+}
@@ -0,0 +1,98 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#pragma once
+
+#include <Graphics/ConstantBuffer.h>
+#include <Graphics/GraphicsEngine.h>
+#include <Graphics/StructuredBuffer.h>
+#include <Graphics/Visual.h>
+#include <Graphics/VisualEffect.h>
+#include <Mathematics/Matrix4x4.h>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace gte
+{
+    class InstancedBatcher
+    {
+    public:
+        // Construction.  The program must have a WireMeshInstanced vertex
+        // shader and have WireParameters already set.  The
+        // batcher groups the visuals of a frame by the vertex and index
+        // buffer they reference and draws each group with one call.  A
+        // group with fewer than minInstances visible members is drawn with
+        // the effects of its visuals instead.
+        InstancedBatcher(std::shared_ptr<VisualProgram> const& program,
+            unsigned int minInstances = 2);
+
+        // Per-frame use:
+        //   batcher.Begin();
+        //   for (auto visual : visibleSet)
+        //   {
+        //       if (!batcher.Add(visual)) { draw visual yourself }
+        //   }
+        //   batcher.End(engine, camera->GetProjectionViewMatrix());
+        // Add rejects visuals whose geometry the instanced vertex shader
+        // cannot read: the positions must be 3 or 4 floats and the
+        // primitives must be a triangle mesh with 32-bit indices.
+        void Begin();
+        bool Add(Visual* visual);
+        void End(std::shared_ptr<GraphicsEngine> const& engine, Matrix4x4<float> const& pvMatrix);
+
+        // Release the groups, for example after the scene was rebuilt.
+        void Clear();
+
+        // Statistics for the most recent End call.
+        inline unsigned int GetNumDrawCalls() const
+        {
+            return mNumDrawCalls;
+        }
+
+        inline unsigned int GetNumInstancedVisuals() const
+        {
+            return mNumInstancedVisuals;
+        }
+
+    private:
+        struct Group
+        {
+            // The mesh, copied once into structured buffers.
+            std::shared_ptr<StructuredBuffer> positions;
+            std::shared_ptr<StructuredBuffer> indices;
+            std::shared_ptr<ConstantBuffer> parameters;
+            unsigned int numIndices;
+
+            // The world matrices of the visible members, grown on demand.
+            // The vertex and index buffers carry no data; they only set the
+            // number of vertices that the draw call generates.
+            std::shared_ptr<StructuredBuffer> worldMatrices;
+            std::shared_ptr<Visual> visual;
+            unsigned int capacity;
+
+            std::vector<Visual*> members;
+        };
+
+        typedef std::pair<VertexBuffer const*, IndexBuffer const*> Key;
+
+        Group* CreateGroup(Visual* visual);
+        void Reserve(Group& group, unsigned int numInstances);
+
+        std::shared_ptr<VisualProgram> mProgram;
+        std::shared_ptr<ConstantBuffer> mPVMatrix;
+        unsigned int mMinInstances;
+
+        // A null group records geometry that was rejected, so it is not
+        // examined again every frame.
+        std::map<Key, std::unique_ptr<Group>> mGroups;
+        std::vector<Group*> mActive;
+
+        unsigned int mNumDrawCalls;
+        unsigned int mNumInstancedVisuals;
+    };
+}
@@ -0,0 +1,456 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#include "Json.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+using namespace gte;
+
+class Json::Parser
+{
+public:
+    Parser(char const* begin, char const* end)
+        :
+        mBegin(begin),
+        mCurrent(begin),
+        mEnd(end)
+    {
+    }
+
+    bool ParseDocument(Json& value, std::string& error)
+    {
+        SkipWhitespace();
+        if (ParseValue(value, 0))
+        {
+            SkipWhitespace();
+            if (mCurrent == mEnd)
+            {
+                return true;
+            }
+            mError = "unexpected characters after the document";
+        }
+        error = mError + " at offset " + std::to_string(mCurrent - mBegin);
+        return false;
+    }
+
+private:
+    enum { MAX_DEPTH = 256 };
+
+    void SkipWhitespace()
+    {
+        while (mCurrent < mEnd && (*mCurrent == ' ' || *mCurrent == '\t'
+            || *mCurrent == '\n' || *mCurrent == '\r'))
+        {
+            ++mCurrent;
+        }
+    }
+
+    bool Fail(char const* message)
+    {
+        mError = message;
+        return false;
+    }
+
+    bool Match(char const* literal)
+    {
+        char const* p = mCurrent;
+        for (; *literal; ++literal, ++p)
+        {
+            if (p == mEnd || *p != *literal)
+            {
+                return false;
+            }
+        }
+        mCurrent = p;
+        return true;
+    }
+
+    bool ParseValue(Json& value, int depth)
+    {
+        if (depth > MAX_DEPTH)
+        {
+            return Fail("nesting too deep");
+        }
+        if (mCurrent == mEnd)
+        {
+            return Fail("unexpected end of input");
+        }
+
+        switch (*mCurrent)
+        {
+        case '{':
+            return ParseObject(value, depth);
+        case '[':
+            return ParseArray(value, depth);
+        case '"':
+            value.mType = JSON_STRING;
+            return ParseString(value.mString);
+        case 't':
+            if (Match("true"))
+            {
+                value.mType = JSON_BOOLEAN;
+                value.mBoolean = true;
+                return true;
+            }
+            break;
+        case 'f':
+            if (Match("false"))
+            {
+                value.mType = JSON_BOOLEAN;
+                value.mBoolean = false;
+                return true;
+            }
+            break;
+        case 'n':
+            if (Match("null"))
+            {
+                value.mType = JSON_NULL;
+                return true;
+            }
+            break;
+        default:
+            return ParseNumber(value);
+        }
+        return Fail("invalid literal");
+    }
+
+    bool ParseObject(Json& value, int depth)
+    {
+        value.mType = JSON_OBJECT;
+        ++mCurrent;
+        SkipWhitespace();
+        if (mCurrent < mEnd && *mCurrent == '}')
+        {
+            ++mCurrent;
+            return true;
+        }
+
+        for (;;)
+        {
+            SkipWhitespace();
+            if (mCurrent == mEnd || *mCurrent != '"')
+            {
+                return Fail("expected a member name");
+            }
+            value.mObject.emplace_back();
+            auto& member = value.mObject.back();
+            if (!ParseString(member.first))
+            {
+                return false;
+            }
+
+            SkipWhitespace();
+            if (mCurrent == mEnd || *mCurrent != ':')
+            {
+                return Fail("expected ':'");
+            }
+            ++mCurrent;
+            SkipWhitespace();
+            if (!ParseValue(member.second, depth + 1))
+            {
+                return false;
+            }
+
+            SkipWhitespace();
+            if (mCurrent < mEnd && *mCurrent == ',')
+            {
+                ++mCurrent;
+                continue;
+            }
+            if (mCurrent < mEnd && *mCurrent == '}')
+            {
+                ++mCurrent;
+                return true;
+            }
+            return Fail("expected ',' or '}'");
+        }
+    }
+
+    bool ParseArray(Json& value, int depth)
+    {
+        value.mType = JSON_ARRAY;
+        ++mCurrent;
+        SkipWhitespace();
+        if (mCurrent < mEnd && *mCurrent == ']')
+        {
+            ++mCurrent;
+            return true;
+        }
+
+        for (;;)
+        {
+            SkipWhitespace();
+            value.mArray.emplace_back();
+            if (!ParseValue(value.mArray.back(), depth + 1))
+            {
+                return false;
+            }
+
+            SkipWhitespace();
+            if (mCurrent < mEnd && *mCurrent == ',')
+            {
+                ++mCurrent;
+                continue;
+            }
+            if (mCurrent < mEnd && *mCurrent == ']')
+            {
+                ++mCurrent;
+                return true;
+            }
+            return Fail("expected ',' or ']'");
+        }
+    }
+
+    bool ParseHex4(uint32_t& code)
+    {
+        if (mEnd - mCurrent < 4)
+        {
+            return Fail("truncated \\u escape");
+        }
+        code = 0;
+        for (int i = 0; i < 4; ++i, ++mCurrent)
+        {
+            char c = *mCurrent;
+            code <<= 4;
+            if (c >= '0' && c <= '9')
+            {
+                code |= static_cast<uint32_t>(c - '0');
+            }
+            else if (c >= 'a' && c <= 'f')
+            {
+                code |= static_cast<uint32_t>(c - 'a' + 10);
+            }
+            else if (c >= 'A' && c <= 'F')
+            {
+                code |= static_cast<uint32_t>(c - 'A' + 10);
+            }
+            else
+            {
+                return Fail("invalid \\u escape");
+            }
+        }
+        return true;
+    }
+
+    static void AppendUTF8(uint32_t code, std::string& text)
+    {
+        if (code < 0x80)
+        {
+            text += static_cast<char>(code);
+        }
+        else if (code < 0x800)
+        {
+            text += static_cast<char>(0xC0 | (code >> 6));
+            text += static_cast<char>(0x80 | (code & 0x3F));
+        }
+        else if (code < 0x10000)
+        {
+            text += static_cast<char>(0xE0 | (code >> 12));
+            text += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            text += static_cast<char>(0x80 | (code & 0x3F));
+        }
+        else
+        {
+            text += static_cast<char>(0xF0 | (code >> 18));
+            text += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            text += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            text += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    bool ParseString(std::string& text)
+    {
+        ++mCurrent;
+        text.clear();
+        while (mCurrent < mEnd)
+        {
+            char c = *mCurrent++;
+            if (c == '"')
+            {
+                return true;
+            }
+            if (c != '\\')
+            {
+                text += c;
+                continue;
+            }
+
+            if (mCurrent == mEnd)
+            {
+                break;
+            }
+            c = *mCurrent++;
+            switch (c)
+            {
+            case '"':  text += '"'; break;
+            case '\\': text += '\\'; break;
+            case '/':  text += '/'; break;
+            case 'b':  text += '\b'; break;
+            case 'f':  text += '\f'; break;
+            case 'n':  text += '\n'; break;
+            case 'r':  text += '\r'; break;
+            case 't':  text += '\t'; break;
+            case 'u':
+            {
+                uint32_t code;
+                if (!ParseHex4(code))
+                {
+                    return false;
+                }
+                if (code >= 0xD800 && code < 0xDC00)
+                {
+                    uint32_t low;
+                    if (!Match("\\u") || !ParseHex4(low) || low < 0xDC00 || low >= 0xE000)
+                    {
+                        return Fail("invalid surrogate pair");
+                    }
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                }
+                AppendUTF8(code, text);
+                break;
+            }
+            default:
+                return Fail("invalid escape");
+            }
+        }
+        return Fail("unterminated string");
+    }
+
+    bool ParseNumber(Json& value)
+    {
+        // strtod accepts more than JSON does (hex, inf, leading '+'), so
+        // the token is validated against the JSON grammar first.
+        char const* p = mCurrent;
+        if (p < mEnd && *p == '-')
+        {
+            ++p;
+        }
+        if (p == mEnd || *p < '0' || *p > '9')
+        {
+            return Fail("invalid value");
+        }
+        while (p < mEnd && ((*p >= '0' && *p <= '9') || *p == '.' || *p == 'e'
+            || *p == 'E' || *p == '+' || *p == '-'))
+        {
+            ++p;
+        }
+
+        std::string token(mCurrent, p);
+        char* last = nullptr;
+        value.mNumber = std::strtod(token.c_str(), &last);
+        if (last != token.c_str() + token.size() || !std::isfinite(value.mNumber))
+        {
+            return Fail("invalid number");
+        }
+        value.mType = JSON_NUMBER;
+        mCurrent = p;
+        return true;
+    }
+
+    char const* mBegin;
+    char const* mCurrent;
+    char const* mEnd;
+    std::string mError;
+};
+
+Json::Json()
+    :
+    mType(JSON_NULL),
+    mBoolean(false),
+    mNumber(0.0)
+{
+}
+
+bool Json::Parse(char const* begin, char const* end, Json& value, std::string& error)
+{
+    value = Json();
+    Parser parser(begin, end);
+    return parser.ParseDocument(value, error);
+}
+
+bool Json::GetBoolean(bool defaultValue) const
+{
+    return mType == JSON_BOOLEAN ? mBoolean : defaultValue;
+}
+
+double Json::GetNumber(double defaultValue) const
+{
+    return mType == JSON_NUMBER ? mNumber : defaultValue;
+}
+
+int Json::GetInteger(int defaultValue) const
+{
+    // The comparisons are false for NaN.
+    if (mType == JSON_NUMBER
+        && mNumber > static_cast<double>(std::numeric_limits<int>::min()) - 1.0
+        && mNumber < static_cast<double>(std::numeric_limits<int>::max()) + 1.0)
+    {
+        return static_cast<int>(mNumber);
+    }
+    return defaultValue;
+}
+
+bool Json::GetIndex(size_t& index) const
+{
+    // The maximum of size_t might not be a double, so the bound is the
+    // power of 2 above it, which is.
+    double const bound = 2.0 * static_cast<double>(std::numeric_limits<size_t>::max() / 2 + 1);
+    if (mType == JSON_NUMBER && mNumber >= 0.0 && mNumber < bound && std::floor(mNumber) == mNumber)
+    {
+        index = static_cast<size_t>(mNumber);
+        return true;
+    }
+    return false;
+}
+
+std::string const& Json::GetString() const
+{
+    static std::string const empty;
+    return mType == JSON_STRING ? mString : empty;
+}
+
+size_t Json::GetSize() const
+{
+    if (mType == JSON_ARRAY)
+    {
+        return mArray.size();
+    }
+    if (mType == JSON_OBJECT)
+    {
+        return mObject.size();
+    }
+    return 0;
+}
+
+Json const& Json::operator[](size_t i) const
+{
+    static Json const null;
+    return (mType == JSON_ARRAY && i < mArray.size()) ? mArray[i] : null;
+}
+
+Json const& Json::operator[](std::string const& key) const
+{
+    static Json const null;
+    if (mType == JSON_OBJECT)
+    {
+        for (auto const& member : mObject)
+        {
+            if (member.first == key)
+            {
+                return member.second;
+            }
+        }
+    }
+    return null;
+}
+
+bool Json::Has(std::string const& key) const
+{
+    return !(*this)[key].IsNull();
+}
@@ -0,0 +1,100 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace gte
+{
+    // A small JSON document model, enough for reading glTF.  Lookups of
+    // missing members or out-of-range elements return a shared null value,
+    // so nested queries such as json["accessors"][i]["count"] need no
+    // intermediate checks.
+    class Json
+    {
+    public:
+        enum Type
+        {
+            JSON_NULL,
+            JSON_BOOLEAN,
+            JSON_NUMBER,
+            JSON_STRING,
+            JSON_ARRAY,
+            JSON_OBJECT
+        };
+
+        Json();
+
+        // Parse the text [begin,end).  On failure the function returns
+        // false and 'error' describes the problem and its byte offset.
+        static bool Parse(char const* begin, char const* end, Json& value, std::string& error);
+
+        inline Type GetType() const
+        {
+            return mType;
+        }
+
+        inline bool IsNull() const
+        {
+            return mType == JSON_NULL;
+        }
+
+        inline bool IsNumber() const
+        {
+            return mType == JSON_NUMBER;
+        }
+
+        inline bool IsString() const
+        {
+            return mType == JSON_STRING;
+        }
+
+        inline bool IsArray() const
+        {
+            return mType == JSON_ARRAY;
+        }
+
+        inline bool IsObject() const
+        {
+            return mType == JSON_OBJECT;
+        }
+
+        // The accessors return 'defaultValue' when the type does not match.
+        // GetInteger truncates toward zero and also returns 'defaultValue'
+        // for a number outside the range of int.
+        bool GetBoolean(bool defaultValue = false) const;
+        double GetNumber(double defaultValue = 0.0) const;
+        int GetInteger(int defaultValue = 0) const;
+        std::string const& GetString() const;
+
+        // Set 'index' and return true for a number that is a nonnegative
+        // integer representable as size_t.  Otherwise 'index' is unchanged
+        // and the return value is false.  Counts, sizes and references of
+        // untrusted documents are read with this.
+        bool GetIndex(size_t& index) const;
+
+        // The number of elements of an array or members of an object.
+        size_t GetSize() const;
+
+        Json const& operator[](size_t i) const;
+        Json const& operator[](std::string const& key) const;
+        bool Has(std::string const& key) const;
+
+    private:
+        class Parser;
+
+        Type mType;
+        bool mBoolean;
+        double mNumber;
+        std::string mString;
+        std::vector<Json> mArray;
+        std::vector<std::pair<std::string, Json>> mObject;
+    };
+}
@@ -0,0 +1,91 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#pragma once
+
+#include <Graphics/KeyframeController.h>
+#include <Graphics/Spatial.h>
+#include <memory>
+#include <vector>
+
+namespace gte
+{
+    class KeyframeBatch
+    {
+    public:
+        // Construction.  The batch evaluates the keyframe tracks of many
+        // objects together instead of one KeyframeController per object.
+        // The keys of all tracks are stored per channel (translation,
+        // rotation, scale) in structure-of-arrays form.  Each track caches
+        // its current key in each channel, as KeyframeController does, so
+        // finding the keys costs O(1) while time moves forward.  The
+        // interpolation then runs as one loop per channel over all tracks,
+        // which the compiler vectorizes, and the results are written to the
+        // local transforms of the objects.
+        KeyframeBatch();
+
+        // Copy the keys and the timing members (minTime, maxTime, phase,
+        // frequency, repeat) of a controller into a new track that drives
+        // 'target'.  The controller is not attached to anything, and later
+        // changes to it do not affect the track.  Returns the track index.
+        int Add(std::shared_ptr<KeyframeController> const& controller, Spatial* target);
+
+        void Clear();
+
+        inline int GetNumTracks() const
+        {
+            return static_cast<int>(mTargets.size());
+        }
+
+        // Set the local transforms of the targets for 'applicationTime'.
+        // The channels a track has no keys for are left unchanged.
+        void Update(double applicationTime);
+
+    private:
+        enum
+        {
+            TRANSLATION,
+            ROTATION,
+            SCALE,
+            NUM_CHANNELS
+        };
+
+        struct Timing
+        {
+            double minTime, maxTime, phase, frequency;
+            Controller::RepeatType repeat;
+        };
+
+        // The arrays indexed by 'j' have one element per track that has
+        // keys in the channel.  Component c of key k is values[c][k]; the
+        // keys of a track start at keyBegin[j].
+        struct Channel
+        {
+            int numComponents;
+            std::vector<int> tracks, keyBegin, numKeys, lastIndex;
+            std::vector<float> times;
+            std::vector<float> values[4];
+
+            // The two keys around the control time and the interpolation
+            // parameter, gathered per Update, and the interpolated values.
+            std::vector<float> normTime;
+            std::vector<float> key0[4], key1[4], result[4];
+        };
+
+        // Returns the index of the first key of the track in 'channel'; the
+        // caller fills in the values.
+        int AddKeys(Channel& channel, int track, int numKeys, float const* times);
+        void Gather(Channel& channel);
+        static void Lerp(Channel& channel);
+        static void Slerp(Channel& channel);
+
+        std::vector<Timing> mTimings;
+        std::vector<Spatial*> mTargets;
+        std::vector<float> mControlTimes;
+        Channel mChannels[NUM_CHANNELS];
+    };
+}
@@ -0,0 +1,71 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#pragma once
+
+namespace gte
+{
+    // The key search of KeyframeController::GetKeyInfo, shared by the
+    // keyframe helpers of the samples.  The keys i0 and i1 bracket ctrlTime
+    // in the increasing 'times' and normTime in [0,1] is its position
+    // between them.  'lastIndex' is the cached key; the search walks from
+    // it, so it takes one step per key passed and is O(1) while the time
+    // moves forward.
+    inline void GetKeyInfo(float ctrlTime, int numTimes, float const* times, int& lastIndex,
+        float& normTime, int& i0, int& i1)
+    {
+        if (ctrlTime <= times[0])
+        {
+            normTime = 0.0f;
+            lastIndex = 0;
+            i0 = 0;
+            i1 = 0;
+            return;
+        }
+
+        if (ctrlTime >= times[numTimes - 1])
+        {
+            normTime = 0.0f;
+            lastIndex = numTimes - 1;
+            i0 = lastIndex;
+            i1 = lastIndex;
+            return;
+        }
+
+        int nextIndex;
+        if (ctrlTime > times[lastIndex])
+        {
+            nextIndex = lastIndex + 1;
+            while (ctrlTime >= times[nextIndex])
+            {
+                lastIndex = nextIndex;
+                ++nextIndex;
+            }
+            i0 = lastIndex;
+            i1 = nextIndex;
+            normTime = (ctrlTime - times[i0]) / (times[i1] - times[i0]);
+        }
+        else if (ctrlTime < times[lastIndex])
+        {
+            nextIndex = lastIndex - 1;
+            while (ctrlTime <= times[nextIndex])
+            {
+                lastIndex = nextIndex;
+                --nextIndex;
+            }
+            i0 = nextIndex;
+            i1 = lastIndex;
+            normTime = (ctrlTime - times[i0]) / (times[i1] - times[i0]);
+        }
+        else
+        {
+            normTime = 0.0f;
+            i0 = lastIndex;
+            i1 = lastIndex;
+        }
+    }
+}
@@ -0,0 +1,227 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#include "LODSelector.h"
+#include <Mathematics/Logger.h>
+#include <Mathematics/Vector3.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+using namespace gte;
+
+LODSelector::LODSelector(float minEdgePixels, float hysteresis)
+    :
+    mMinEdgePixels(minEdgePixels),
+    mHysteresis(hysteresis),
+    mNumTriangles(0),
+    mNumLevelChanges(0)
+{
+}
+
+int LODSelector::AddChain(std::vector<std::shared_ptr<Visual>> const& levels)
+{
+    if (levels.empty())
+    {
+        LogWarning("A level of detail chain needs at least one level");
+        return -1;
+    }
+
+    std::vector<Level> chain(levels.size());
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        if (!levels[i] || !MeasureLevel(*levels[i], chain[i]))
+        {
+            LogWarning("Level " + std::to_string(i) + " is not a triangle mesh with float positions");
+            return -1;
+        }
+    }
+
+    mChains.push_back(std::move(chain));
+    return static_cast<int>(mChains.size()) - 1;
+}
+
+bool LODSelector::Add(Visual* visual, int chain)
+{
+    if (!visual || chain < 0 || chain >= static_cast<int>(mChains.size()))
+    {
+        return false;
+    }
+
+    auto element = mMemberOfVisual.find(visual);
+    if (element == mMemberOfVisual.end())
+    {
+        mMemberOfVisual[visual] = mMembers.size();
+        mMembers.push_back({ visual, chain, 0 });
+    }
+    else
+    {
+        mMembers[element->second].chain = chain;
+        mMembers[element->second].level = 0;
+    }
+
+    Level const& finest = mChains[chain][0];
+    visual->SetVertexBuffer(finest.vbuffer);
+    visual->SetIndexBuffer(finest.ibuffer);
+    return true;
+}
+
+void LODSelector::Clear()
+{
+    mChains.clear();
+    mMembers.clear();
+    mMemberOfVisual.clear();
+    mNumTriangles = 0;
+    mNumLevelChanges = 0;
+}
+
+void LODSelector::Select(std::shared_ptr<Camera> const& camera,
+    int viewportHeight, VisibleSet const& visibleSet)
+{
+    mNumTriangles = 0;
+    mNumLevelChanges = 0;
+    if (!camera || mMembers.empty())
+    {
+        return;
+    }
+
+    // A length L at view depth d covers L * pixelsPerUnit / d pixels, or
+    // L * pixelsPerUnit pixels for a parallel projection.
+    float const* frustum = camera->GetFrustum();
+    float dMin = frustum[Camera::VF_DMIN];
+    float uExtent = frustum[Camera::VF_UMAX] - frustum[Camera::VF_UMIN];
+    bool perspective = camera->IsPerspective();
+    float pixelsPerUnit = static_cast<float>(viewportHeight) / uExtent;
+    if (perspective)
+    {
+        pixelsPerUnit *= dMin;
+    }
+
+    Vector4<float> P = camera->GetPosition();
+    Vector4<float> D = camera->GetDVector();
+    float const finer = mMinEdgePixels * (1.0f + mHysteresis);
+
+    for (auto visual : visibleSet)
+    {
+        auto element = mMemberOfVisual.find(visual);
+        if (element == mMemberOfVisual.end())
+        {
+            continue;
+        }
+
+        Member& member = mMembers[element->second];
+        std::vector<Level> const& chain = mChains[member.chain];
+
+        // The world bound measures the scale of the world transform, and
+        // its nearest point the depth at which the edges are longest.
+        float radius = visual->worldBound.GetRadius();
+        float modelRadius = visual->modelBound.GetRadius();
+        float scale = (modelRadius > 0.0f ? radius / modelRadius : 1.0f);
+        float pixels = pixelsPerUnit * scale;
+        if (perspective)
+        {
+            float depth = Dot(D, visual->worldBound.GetCenter() - P) - radius;
+            pixels /= std::max(depth, dMin);
+        }
+
+        int level = member.level;
+        while (level > 0 && chain[level - 1].edgeLength * pixels >= finer)
+        {
+            --level;
+        }
+        while (level + 1 < static_cast<int>(chain.size())
+            && chain[level].edgeLength * pixels < mMinEdgePixels)
+        {
+            ++level;
+        }
+
+        if (level != member.level)
+        {
+            member.level = level;
+            visual->SetVertexBuffer(chain[level].vbuffer);
+            visual->SetIndexBuffer(chain[level].ibuffer);
+            ++mNumLevelChanges;
+        }
+        mNumTriangles += chain[level].numTriangles;
+    }
+}
+
+int LODSelector::GetLevel(Visual const* visual) const
+{
+    auto element = mMemberOfVisual.find(visual);
+    return (element != mMemberOfVisual.end() ? mMembers[element->second].level : -1);
+}
+
+bool LODSelector::MeasureLevel(Visual const& visual, Level& level)
+{
+    level.vbuffer = visual.GetVertexBuffer();
+    level.ibuffer = visual.GetIndexBuffer();
+    if (!level.vbuffer || !level.ibuffer || !level.vbuffer->GetData()
+        || level.ibuffer->GetPrimitiveType() != IP_TRIMESH)
+    {
+        return false;
+    }
+
+    VertexFormat const& vformat = level.vbuffer->GetFormat();
+    int index = vformat.GetIndex(VA_POSITION, 0);
+    if (index < 0)
+    {
+        return false;
+    }
+    DFType type = vformat.GetType(index);
+    if (type != DF_R32G32B32_FLOAT && type != DF_R32G32B32A32_FLOAT)
+    {
+        return false;
+    }
+
+    unsigned int const numVertices = level.vbuffer->GetNumElements();
+    unsigned int const stride = vformat.GetVertexSize();
+    char const* positions = level.vbuffer->GetData() + vformat.GetOffset(index);
+    auto position = [&](uint32_t v)
+    {
+        float xyz[3];
+        std::memcpy(xyz, positions + static_cast<size_t>(v) * stride, sizeof(xyz));
+        return Vector3<float>{ xyz[0], xyz[1], xyz[2] };
+    };
+
+    // An index buffer without indices draws the vertices in order.
+    IndexBuffer const& ibuffer = *level.ibuffer;
+    size_t const indexSize = (ibuffer.IsIndexed() ? ibuffer.GetElementSize() : 0);
+    if (indexSize != 0 && indexSize != sizeof(uint16_t) && indexSize != sizeof(uint32_t))
+    {
+        return false;
+    }
+    auto vertex = [&](uint32_t i)
+    {
+        if (indexSize == sizeof(uint32_t))
+        {
+            return reinterpret_cast<uint32_t const*>(ibuffer.GetData())[i];
+        }
+        if (indexSize == sizeof(uint16_t))
+        {
+            return static_cast<uint32_t>(reinterpret_cast<uint16_t const*>(ibuffer.GetData())[i]);
+        }
+        return i;
+    };
+
+    level.numTriangles = ibuffer.GetNumPrimitives();
+    double sum = 0.0;
+    for (uint32_t t = 0; t < level.numTriangles; ++t)
+    {
+        uint32_t v[3] = { vertex(3 * t), vertex(3 * t + 1), vertex(3 * t + 2) };
+        if (v[0] >= numVertices || v[1] >= numVertices || v[2] >= numVertices)
+        {
+            return false;
+        }
+
+        Vector3<float> p[3] = { position(v[0]), position(v[1]), position(v[2]) };
+        sum += Length(p[1] - p[0]) + Length(p[2] - p[1]) + Length(p[0] - p[2]);
+    }
+    level.edgeLength = (level.numTriangles > 0 ?
+        static_cast<float>(sum / (3.0 * level.numTriangles)) : 0.0f);
+    return true;
+}
@@ -0,0 +1,91 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#pragma once
+
+#include <Graphics/Camera.h>
+#include <Graphics/Culler.h>
+#include <Graphics/Visual.h>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace gte
+{
+    class LODSelector
+    {
+    public:
+        // Construction.  A Visual draws the finest of its levels whose edges
+        // project to at least minEdgePixels pixels; in a wireframe view a
+        // denser tessellation only draws lines over lines.  A level becomes
+        // finer only once the edges of the finer level are (1 + hysteresis)
+        // times that long, so a Visual near a boundary does not alternate
+        // between two levels from frame to frame.
+        LODSelector(float minEdgePixels = 1.0f, float hysteresis = 0.25f);
+
+        // A chain of levels ordered from finest to coarsest, for example the
+        // MeshFactory tessellations of one shape.  Only the vertex and index
+        // buffers of the levels are used, and the Visuals of a chain share
+        // them, so InstancedBatcher still draws a level of many Visuals
+        // together.  The edge length of a level is the mean length of its
+        // triangle edges.  AddChain returns the index of the chain, or -1
+        // when a level is not a triangle mesh with float3 or float4
+        // positions.
+        int AddChain(std::vector<std::shared_ptr<Visual>> const& levels);
+
+        // The Visual starts at the finest level of the chain.  Its model
+        // bound is left alone, so the levels should have nearly the same
+        // bound, as the tessellations of a shape do.
+        bool Add(Visual* visual, int chain);
+
+        void Clear();
+
+        // Call after culling.  Only the Visuals of the visible set that were
+        // added change level; the others keep the level they had when they
+        // were last visible.  The viewport height is in pixels.
+        void Select(std::shared_ptr<Camera> const& camera,
+            int viewportHeight, VisibleSet const& visibleSet);
+
+        // The level a Visual draws, or -1 when it was not added.
+        int GetLevel(Visual const* visual) const;
+
+        // Statistics for the most recent Select call.
+        inline unsigned int GetNumTriangles() const
+        {
+            return mNumTriangles;
+        }
+
+        inline unsigned int GetNumLevelChanges() const
+        {
+            return mNumLevelChanges;
+        }
+
+    private:
+        struct Level
+        {
+            std::shared_ptr<VertexBuffer> vbuffer;
+            std::shared_ptr<IndexBuffer> ibuffer;
+            float edgeLength;
+            unsigned int numTriangles;
+        };
+
+        struct Member
+        {
+            Visual* visual;
+            int chain;
+            int level;
+        };
+
+        static bool MeasureLevel(Visual const& visual, Level& level);
+
+        float mMinEdgePixels, mHysteresis;
+        std::vector<std::vector<Level>> mChains;
+        std::vector<Member> mMembers;
+        std::unordered_map<Visual const*, size_t> mMemberOfVisual;
+        unsigned int mNumTriangles, mNumLevelChanges;
+    };
+}
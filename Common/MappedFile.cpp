@@ -0,0 +1,136 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#include "MappedFile.h"
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+using namespace gte;
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+MappedFile::MappedFile()
+    :
+    mData(nullptr),
+    mSize(0)
+#if defined(_WIN32)
+    ,
+    mFile(INVALID_HANDLE_VALUE),
+    mMapping(nullptr)
+#endif
+{
+}
+
+#if defined(_WIN32)
+
+bool MappedFile::Open(std::string const& filename)
+{
+    Close();
+
+    mFile = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (mFile == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(mFile, &size) || size.QuadPart == 0)
+    {
+        Close();
+        return false;
+    }
+
+    mMapping = CreateFileMappingA(mFile, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    if (!mMapping)
+    {
+        Close();
+        return false;
+    }
+
+    mData = static_cast<char*>(MapViewOfFile(mMapping, FILE_MAP_COPY, 0, 0, 0));
+    if (!mData)
+    {
+        Close();
+        return false;
+    }
+    mSize = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (mData)
+    {
+        UnmapViewOfFile(mData);
+        mData = nullptr;
+    }
+    if (mMapping)
+    {
+        CloseHandle(mMapping);
+        mMapping = nullptr;
+    }
+    if (mFile != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(mFile);
+        mFile = INVALID_HANDLE_VALUE;
+    }
+    mSize = 0;
+}
+
+#else
+
+bool MappedFile::Open(std::string const& filename)
+{
+    Close();
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    // The descriptor is not needed once the mapping exists.
+    struct stat status;
+    if (fstat(fd, &status) != 0 || status.st_size <= 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(status.st_size);
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+
+    mData = static_cast<char*>(data);
+    mSize = size;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (mData)
+    {
+        munmap(mData, mSize);
+        mData = nullptr;
+    }
+    mSize = 0;
+}
+
+#endif
@@ -0,0 +1,50 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace gte
+{
+    class MappedFile
+    {
+    public:
+        // Construction and destruction.  The file is mapped copy-on-write:
+        // the pages are read from disk on first access and are private to
+        // the process, so a resource may point into the mapping as its
+        // system-memory storage even if it later writes to that storage.
+        ~MappedFile();
+        MappedFile();
+
+        MappedFile(MappedFile const&) = delete;
+        MappedFile& operator=(MappedFile const&) = delete;
+
+        // Open fails for missing or empty files.
+        bool Open(std::string const& filename);
+        void Close();
+
+        inline char* GetData() const
+        {
+            return mData;
+        }
+
+        inline size_t GetSize() const
+        {
+            return mSize;
+        }
+
+    private:
+        char* mData;
+        size_t mSize;
+#if defined(_WIN32)
+        void* mFile;
+        void* mMapping;
+#endif
+    };
+}
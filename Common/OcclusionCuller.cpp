@@ -0,0 +1,542 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#include "OcclusionCuller.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+using namespace gte;
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define OCCLUSION_CULLER_SSE
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // The entry in row r and column c of the matrix that multiplies column
+    // vectors, whichever convention the engine was built with.
+    inline float Entry(Matrix4x4<float> const& M, int r, int c)
+    {
+#if defined(GTE_USE_VEC_MAT)
+        return M(c, r);
+#else
+        return M(r, c);
+#endif
+    }
+
+    float const INFINITE_DEPTH = std::numeric_limits<float>::max();
+    uint32_t const NO_NEIGHBOR = std::numeric_limits<uint32_t>::max();
+
+    // Positive when c is left of the line from a to b in screen space.
+    inline float Side(float const* a, float const* b, float const* c)
+    {
+        return (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+    }
+}
+
+OcclusionCuller::OcclusionCuller(int width, int height)
+    :
+    mWidth((std::max(width, 1) + 3) & ~3),
+    mHeight(std::max(height, 1)),
+    mNumOccluderTriangles(0),
+    mNumOccluded(0)
+{
+    int w = mWidth, h = mHeight;
+    while (true)
+    {
+        mLevels.push_back({ w, h, std::vector<float>(static_cast<size_t>(w) * h, INFINITE_DEPTH) });
+        if (w == 1 && h == 1)
+        {
+            break;
+        }
+        w = (w + 1) / 2;
+        h = (h + 1) / 2;
+    }
+}
+
+bool OcclusionCuller::AddOccluder(Visual* visual)
+{
+    if (!visual || !GetMesh(*visual))
+    {
+        return false;
+    }
+    mOccluders.insert(visual);
+    return true;
+}
+
+void OcclusionCuller::Clear()
+{
+    mOccluders.clear();
+    mMeshes.clear();
+    mVisibleSet.clear();
+    mNumOccluderTriangles = 0;
+    mNumOccluded = 0;
+}
+
+void OcclusionCuller::Cull(std::shared_ptr<Camera> const& camera, VisibleSet const& visibleSet)
+{
+    mNumOccluderTriangles = 0;
+    mNumOccluded = 0;
+    mVisibleSet.clear();
+    if (!camera)
+    {
+        mVisibleSet = visibleSet;
+        return;
+    }
+
+    Matrix4x4<float> const& pvMatrix = camera->GetProjectionViewMatrix();
+    Vector4<float> P = camera->GetPosition();
+    Vector4<float> D = camera->GetDVector();
+    Vector4<float> U = camera->GetUVector();
+    Vector4<float> R = camera->GetRVector();
+    float dMin = camera->GetFrustum()[Camera::VF_DMIN];
+
+    std::fill(mLevels[0].depth.begin(), mLevels[0].depth.end(), INFINITE_DEPTH);
+    bool anyOccluder = false;
+    for (auto visual : visibleSet)
+    {
+        if (mOccluders.find(visual) != mOccluders.end())
+        {
+            Mesh const* mesh = GetMesh(*visual);
+            if (mesh)
+            {
+                DrawOccluder(*visual, *mesh, pvMatrix, P, D, dMin);
+                anyOccluder = true;
+            }
+        }
+    }
+    if (!anyOccluder)
+    {
+        mVisibleSet = visibleSet;
+        return;
+    }
+    BuildPyramid();
+
+    mVisibleSet.reserve(visibleSet.size());
+    for (auto visual : visibleSet)
+    {
+        if (IsOccluded(*visual, pvMatrix, P, D, U, R, dMin))
+        {
+            ++mNumOccluded;
+        }
+        else
+        {
+            mVisibleSet.push_back(visual);
+        }
+    }
+}
+
+OcclusionCuller::Mesh const* OcclusionCuller::GetMesh(Visual const& visual)
+{
+    auto const& vbuffer = visual.GetVertexBuffer();
+    auto const& ibuffer = visual.GetIndexBuffer();
+    Key key(vbuffer.get(), ibuffer.get());
+    auto element = mMeshes.find(key);
+    if (element != mMeshes.end())
+    {
+        return element->second.get();
+    }
+    element = mMeshes.insert(std::make_pair(key, std::unique_ptr<Mesh>())).first;
+
+    if (!vbuffer || !ibuffer || !vbuffer->GetData() || ibuffer->GetPrimitiveType() != IP_TRIMESH)
+    {
+        return nullptr;
+    }
+
+    VertexFormat const& vformat = vbuffer->GetFormat();
+    int index = vformat.GetIndex(VA_POSITION, 0);
+    if (index < 0)
+    {
+        return nullptr;
+    }
+    DFType type = vformat.GetType(index);
+    if (type != DF_R32G32B32_FLOAT && type != DF_R32G32B32A32_FLOAT)
+    {
+        return nullptr;
+    }
+
+    // An index buffer without indices draws the vertices in order.
+    size_t const indexSize = (ibuffer->IsIndexed() ? ibuffer->GetElementSize() : 0);
+    if (indexSize != 0 && indexSize != sizeof(uint16_t) && indexSize != sizeof(uint32_t))
+    {
+        return nullptr;
+    }
+
+    unsigned int const numVertices = vbuffer->GetNumElements();
+    unsigned int const numIndices = 3 * ibuffer->GetNumPrimitives();
+    char const* indices = ibuffer->GetData();
+    auto mesh = std::make_unique<Mesh>();
+    mesh->indices.resize(numIndices);
+    uint32_t minIndex = std::numeric_limits<uint32_t>::max(), maxIndex = 0;
+    for (unsigned int i = 0; i < numIndices; ++i)
+    {
+        uint32_t v = i;
+        if (indexSize == sizeof(uint32_t))
+        {
+            v = reinterpret_cast<uint32_t const*>(indices)[i];
+        }
+        else if (indexSize == sizeof(uint16_t))
+        {
+            v = reinterpret_cast<uint16_t const*>(indices)[i];
+        }
+
+        if (v >= numVertices)
+        {
+            return nullptr;
+        }
+        mesh->indices[i] = v;
+        minIndex = std::min(minIndex, v);
+        maxIndex = std::max(maxIndex, v);
+    }
+    if (numIndices == 0)
+    {
+        return nullptr;
+    }
+
+    // The mesh may occupy a range of a shared vertex buffer.
+    unsigned int const stride = vformat.GetVertexSize();
+    char const* source = vbuffer->GetData() + static_cast<size_t>(minIndex) * stride
+        + vformat.GetOffset(index);
+    mesh->positions.resize(3 * static_cast<size_t>(maxIndex - minIndex + 1));
+    for (size_t i = 0; i < mesh->positions.size(); i += 3, source += stride)
+    {
+        std::memcpy(&mesh->positions[i], source, 3 * sizeof(float));
+    }
+    for (auto& v : mesh->indices)
+    {
+        v -= minIndex;
+    }
+
+    // An edge has a neighbor when exactly two triangles have it.  The
+    // edges are matched by the positions of their vertices.
+    std::map<std::array<float, 3>, uint32_t> vertexAt;
+    std::vector<uint32_t> weld(mesh->positions.size() / 3);
+    for (uint32_t v = 0; v < weld.size(); ++v)
+    {
+        float const* p = &mesh->positions[3 * static_cast<size_t>(v)];
+        weld[v] = vertexAt.insert(std::make_pair(std::array<float, 3>{ p[0], p[1], p[2] }, v)).first->second;
+    }
+    std::vector<std::array<uint32_t, 3>> edges;
+    edges.reserve(numIndices);
+    for (uint32_t i = 0; i < numIndices; ++i)
+    {
+        uint32_t a = weld[mesh->indices[i]];
+        uint32_t b = weld[mesh->indices[i % 3 == 2 ? i - 2 : i + 1]];
+        if (a != b)
+        {
+            edges.push_back({ std::min(a, b), std::max(a, b), i });
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    mesh->neighbors.assign(numIndices, NO_NEIGHBOR);
+    auto opposite = [&mesh](uint32_t i)
+    {
+        return mesh->indices[i % 3 == 0 ? i + 2 : i - 1];
+    };
+    for (size_t i = 0, j = 0; i < edges.size(); i = j)
+    {
+        while (j < edges.size() && edges[j][0] == edges[i][0] && edges[j][1] == edges[i][1])
+        {
+            ++j;
+        }
+        if (j - i == 2)
+        {
+            mesh->neighbors[edges[i][2]] = opposite(edges[i + 1][2]);
+            mesh->neighbors[edges[i + 1][2]] = opposite(edges[i][2]);
+        }
+    }
+
+    element->second = std::move(mesh);
+    return element->second.get();
+}
+
+void OcclusionCuller::DrawOccluder(Visual const& visual, Mesh const& mesh,
+    Matrix4x4<float> const& pvMatrix, Vector4<float> const& P, Vector4<float> const& D, float dMin)
+{
+    Matrix4x4<float> const& wMatrix = visual.worldTransform.GetHMatrix();
+#if defined(GTE_USE_VEC_MAT)
+    Matrix4x4<float> pvwMatrix = wMatrix * pvMatrix;
+#else
+    Matrix4x4<float> pvwMatrix = pvMatrix * wMatrix;
+#endif
+
+    // The view depth of a model position is Dot(D, W * position - P).
+    float depthRow[4];
+    for (int c = 0; c < 4; ++c)
+    {
+        depthRow[c] = D[0] * Entry(wMatrix, 0, c) + D[1] * Entry(wMatrix, 1, c)
+            + D[2] * Entry(wMatrix, 2, c);
+    }
+    depthRow[3] -= Dot(D, P);
+
+    // Each vertex becomes (x, y, depth) with x and y in pixels.
+    float const halfWidth = 0.5f * static_cast<float>(mWidth);
+    float const halfHeight = 0.5f * static_cast<float>(mHeight);
+    size_t const numVertices = mesh.positions.size() / 3;
+    mScreen.resize(3 * numVertices);
+    for (size_t v = 0; v < numVertices; ++v)
+    {
+        float const* p = &mesh.positions[3 * v];
+        float clip[4];
+        for (int r = 0; r < 4; ++r)
+        {
+            clip[r] = Entry(pvwMatrix, r, 0) * p[0] + Entry(pvwMatrix, r, 1) * p[1]
+                + Entry(pvwMatrix, r, 2) * p[2] + Entry(pvwMatrix, r, 3);
+        }
+        float depth = depthRow[0] * p[0] + depthRow[1] * p[1] + depthRow[2] * p[2] + depthRow[3];
+
+        float* s = &mScreen[3 * v];
+        if (depth >= dMin && clip[3] > 0.0f)
+        {
+            s[0] = halfWidth * (1.0f + clip[0] / clip[3]);
+            s[1] = halfHeight * (1.0f - clip[1] / clip[3]);
+            s[2] = depth;
+        }
+        else
+        {
+            s[2] = -1.0f;
+        }
+    }
+
+    size_t const numTriangles = mesh.indices.size() / 3;
+    for (size_t t = 0; t < numTriangles; ++t)
+    {
+        float const* v0 = &mScreen[3 * mesh.indices[3 * t]];
+        float const* v1 = &mScreen[3 * mesh.indices[3 * t + 1]];
+        float const* v2 = &mScreen[3 * mesh.indices[3 * t + 2]];
+        if (v0[2] < 0.0f || v1[2] < 0.0f || v2[2] < 0.0f)
+        {
+            continue;
+        }
+
+        // An edge is on the outline of the occluder unless the neighbor
+        // across it is drawn and lies on its other side.
+        float const* v[3] = { v0, v1, v2 };
+        bool outline[3];
+        for (int i = 0; i < 3; ++i)
+        {
+            uint32_t neighbor = mesh.neighbors[3 * t + i];
+            outline[i] = true;
+            if (neighbor != NO_NEIGHBOR && mScreen[3 * neighbor + 2] >= 0.0f)
+            {
+                float const* a = v[i];
+                float const* b = v[(i + 1) % 3];
+                outline[i] = (Side(a, b, v[(i + 2) % 3]) * Side(a, b, &mScreen[3 * neighbor]) >= 0.0f);
+            }
+        }
+        DrawTriangle(v0, v1, v2, std::max(std::max(v0[2], v1[2]), v2[2]), outline);
+    }
+    mNumOccluderTriangles += static_cast<unsigned int>(numTriangles);
+}
+
+void OcclusionCuller::DrawTriangle(float const* v0, float const* v1, float const* v2, float depth,
+    bool const outline[3])
+{
+    // Both windings are drawn; the edge functions are made nonnegative
+    // inside the triangle.
+    float area = (v1[0] - v0[0]) * (v2[1] - v0[1]) - (v1[1] - v0[1]) * (v2[0] - v0[0]);
+    if (area == 0.0f)
+    {
+        return;
+    }
+    bool shrink[3] = { outline[0], outline[1], outline[2] };
+    if (area < 0.0f)
+    {
+        // The edges v0v1 and v2v0 trade places.
+        std::swap(v1, v2);
+        std::swap(shrink[0], shrink[2]);
+    }
+
+    float xMin = std::min(std::min(v0[0], v1[0]), v2[0]);
+    float xMax = std::max(std::max(v0[0], v1[0]), v2[0]);
+    float yMin = std::min(std::min(v0[1], v1[1]), v2[1]);
+    float yMax = std::max(std::max(v0[1], v1[1]), v2[1]);
+    int x0 = std::max(static_cast<int>(std::floor(xMin)), 0);
+    int x1 = std::min(static_cast<int>(std::floor(xMax)), mWidth - 1);
+    int y0 = std::max(static_cast<int>(std::floor(yMin)), 0);
+    int y1 = std::min(static_cast<int>(std::floor(yMax)), mHeight - 1);
+    if (x0 > x1 || y0 > y1)
+    {
+        return;
+    }
+
+    // E(x, y) = A * x + B * y + C for the edges v0v1, v1v2 and v2v0,
+    // evaluated at pixel centers.  Coverage is conservative on the outline
+    // of the occluder: a texel is written only when its whole square is
+    // inside the outline edges.  The smallest value of an edge function on
+    // the square is at one of its corners, (|A| + |B|) / 2 below the value
+    // at the center, so C is lowered by that much.  The edges inside the
+    // occluder keep the center test, which the neighbor across them
+    // complements.
+    float const* p[3] = { v0, v1, v2 };
+    float A[3], B[3], C[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        float const* a = p[i];
+        float const* b = p[(i + 1) % 3];
+        A[i] = a[1] - b[1];
+        B[i] = b[0] - a[0];
+        C[i] = -(A[i] * a[0] + B[i] * a[1]);
+        if (shrink[i])
+        {
+            C[i] -= 0.5f * (std::fabs(A[i]) + std::fabs(B[i]));
+        }
+    }
+
+    std::vector<float>& buffer = mLevels[0].depth;
+#if defined(OCCLUSION_CULLER_SSE)
+    // Four pixels of a row at a time; a row starts at a multiple of 4, and
+    // the width is one, so the quads never straddle rows.
+    __m128 const zero = _mm_setzero_ps();
+    __m128 const z = _mm_set1_ps(depth);
+    __m128 const offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+    __m128 const stepA0 = _mm_set1_ps(A[0]), stepA1 = _mm_set1_ps(A[1]), stepA2 = _mm_set1_ps(A[2]);
+    int const xStart = x0 & ~3;
+    for (int y = y0; y <= y1; ++y)
+    {
+        float fy = static_cast<float>(y) + 0.5f;
+        __m128 fx = _mm_add_ps(_mm_set1_ps(static_cast<float>(xStart)), offsets);
+        __m128 e0 = _mm_add_ps(_mm_mul_ps(stepA0, fx), _mm_set1_ps(B[0] * fy + C[0]));
+        __m128 e1 = _mm_add_ps(_mm_mul_ps(stepA1, fx), _mm_set1_ps(B[1] * fy + C[1]));
+        __m128 e2 = _mm_add_ps(_mm_mul_ps(stepA2, fx), _mm_set1_ps(B[2] * fy + C[2]));
+        __m128 const step0 = _mm_mul_ps(stepA0, _mm_set1_ps(4.0f));
+        __m128 const step1 = _mm_mul_ps(stepA1, _mm_set1_ps(4.0f));
+        __m128 const step2 = _mm_mul_ps(stepA2, _mm_set1_ps(4.0f));
+        float* row = &buffer[static_cast<size_t>(y) * mWidth];
+        for (int x = xStart; x <= x1; x += 4)
+        {
+            __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)),
+                _mm_cmpge_ps(e2, zero));
+            if (_mm_movemask_ps(inside) != 0)
+            {
+                __m128 old = _mm_loadu_ps(row + x);
+                __m128 nearer = _mm_min_ps(old, z);
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+            }
+            e0 = _mm_add_ps(e0, step0);
+            e1 = _mm_add_ps(e1, step1);
+            e2 = _mm_add_ps(e2, step2);
+        }
+    }
+#else
+    for (int y = y0; y <= y1; ++y)
+    {
+        float fy = static_cast<float>(y) + 0.5f;
+        float* row = &buffer[static_cast<size_t>(y) * mWidth];
+        for (int x = x0; x <= x1; ++x)
+        {
+            float fx = static_cast<float>(x) + 0.5f;
+            if (A[0] * fx + B[0] * fy + C[0] >= 0.0f
+                && A[1] * fx + B[1] * fy + C[1] >= 0.0f
+                && A[2] * fx + B[2] * fy + C[2] >= 0.0f)
+            {
+                row[x] = std::min(row[x], depth);
+            }
+        }
+    }
+#endif
+}
+
+void OcclusionCuller::BuildPyramid()
+{
+    for (size_t k = 1; k < mLevels.size(); ++k)
+    {
+        Level const& fine = mLevels[k - 1];
+        Level& coarse = mLevels[k];
+        for (int y = 0; y < coarse.height; ++y)
+        {
+            int fy0 = 2 * y, fy1 = std::min(2 * y + 1, fine.height - 1);
+            for (int x = 0; x < coarse.width; ++x)
+            {
+                int fx0 = 2 * x, fx1 = std::min(2 * x + 1, fine.width - 1);
+                float const* row0 = &fine.depth[static_cast<size_t>(fy0) * fine.width];
+                float const* row1 = &fine.depth[static_cast<size_t>(fy1) * fine.width];
+                coarse.depth[static_cast<size_t>(y) * coarse.width + x] =
+                    std::max(std::max(row0[fx0], row0[fx1]), std::max(row1[fx0], row1[fx1]));
+            }
+        }
+    }
+}
+
+bool OcclusionCuller::IsOccluded(Visual const& visual, Matrix4x4<float> const& pvMatrix,
+    Vector4<float> const& P, Vector4<float> const& D, Vector4<float> const& U,
+    Vector4<float> const& R, float dMin) const
+{
+    Vector4<float> center = visual.worldBound.GetCenter();
+    float radius = visual.worldBound.GetRadius();
+    float nearest = Dot(D, center - P) - radius;
+    if (nearest < dMin)
+    {
+        return false;
+    }
+
+    // The screen rectangle of the cube around the bound whose faces are
+    // perpendicular to the camera axes contains the projection of the
+    // bound.
+    float const halfWidth = 0.5f * static_cast<float>(mWidth);
+    float const halfHeight = 0.5f * static_cast<float>(mHeight);
+    float xMin = INFINITE_DEPTH, xMax = -INFINITE_DEPTH;
+    float yMin = INFINITE_DEPTH, yMax = -INFINITE_DEPTH;
+    for (int i = 0; i < 8; ++i)
+    {
+        Vector4<float> corner = center
+            + ((i & 1) ? radius : -radius) * R
+            + ((i & 2) ? radius : -radius) * U
+            + ((i & 4) ? radius : -radius) * D;
+        float clip[4];
+        for (int r = 0; r < 4; ++r)
+        {
+            clip[r] = Entry(pvMatrix, r, 0) * corner[0] + Entry(pvMatrix, r, 1) * corner[1]
+                + Entry(pvMatrix, r, 2) * corner[2] + Entry(pvMatrix, r, 3);
+        }
+        if (clip[3] <= 0.0f)
+        {
+            return false;
+        }
+        float x = halfWidth * (1.0f + clip[0] / clip[3]);
+        float y = halfHeight * (1.0f - clip[1] / clip[3]);
+        xMin = std::min(xMin, x);
+        xMax = std::max(xMax, x);
+        yMin = std::min(yMin, y);
+        yMax = std::max(yMax, y);
+    }
+    if (xMin < 0.0f || yMin < 0.0f || xMax >= static_cast<float>(mWidth)
+        || yMax >= static_cast<float>(mHeight))
+    {
+        return false;
+    }
+    // The texels that the rectangle touches, partly or not.  Only texels
+    // entirely inside an occluder hold its depth, so a bound that reaches
+    // past the outline meets a far texel.
+    int x0 = static_cast<int>(xMin), x1 = static_cast<int>(xMax);
+    int y0 = static_cast<int>(yMin), y1 = static_cast<int>(yMax);
+
+    // The finest level at which the rectangle covers at most 4x4 texels.
+    // Fewer, coarser texels are cheaper to read but are more likely to
+    // include the far depth around the edges of an occluder.
+    size_t k = 0;
+    while (k + 1 < mLevels.size() && ((x1 >> k) - (x0 >> k) > 3 || (y1 >> k) - (y0 >> k) > 3))
+    {
+        ++k;
+    }
+
+    Level const& level = mLevels[k];
+    for (int y = (y0 >> k); y <= (y1 >> k); ++y)
+    {
+        for (int x = (x0 >> k); x <= (x1 >> k); ++x)
+        {
+            if (level.depth[static_cast<size_t>(y) * level.width + x] >= nearest)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
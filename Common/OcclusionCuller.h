@@ -0,0 +1,119 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#pragma once
+
+#include <Graphics/Camera.h>
+#include <Graphics/Culler.h>
+#include <Graphics/Visual.h>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+namespace gte
+{
+    class OcclusionCuller
+    {
+    public:
+        // Construction.  The occluders are rasterized on the CPU into a
+        // width-by-height depth buffer (the width is rounded up to a
+        // multiple of 4), so the culler needs no graphics engine.  The
+        // buffer holds view depths; a texel covered by no occluder is
+        // infinitely far.
+        OcclusionCuller(int width = 256, int height = 128);
+
+        // Designate a Visual as an occluder.  Its triangles, with the
+        // vertex and index buffers it has when Cull is called, are drawn
+        // into the depth buffer when it is in the visible set.  Add
+        // returns false for geometry that is not a triangle mesh with float
+        // positions.
+        bool AddOccluder(Visual* visual);
+
+        // Forget the occluders and their triangles, for example after the
+        // scene was rebuilt.
+        void Clear();
+
+        // Call after frustum culling.  The occluders of the visible set are
+        // rasterized, the depth buffer is reduced to a pyramid whose texels
+        // hold the farthest depth of the texels below them, and every
+        // visual whose world bound is behind the pyramid is removed.  An
+        // occluder never hides itself: each of its triangles is drawn at
+        // the depth of its farthest vertex, which is behind the nearest
+        // point of its bound.  A triangle that crosses the near plane is
+        // not drawn, and a bound that crosses it or leaves the screen is
+        // kept.  Both tests are conservative at the texel level: an
+        // occluder writes only the texels it covers entirely, and a bound
+        // is tested against every texel its screen rectangle touches, so a
+        // visual that shows by less than a texel past the outline of an
+        // occluder is kept.  Along an edge between two triangles of an
+        // occluder that are drawn on either side of it, a texel is written
+        // by the triangle that contains its center.
+        void Cull(std::shared_ptr<Camera> const& camera, VisibleSet const& visibleSet);
+
+        inline VisibleSet const& GetVisibleSet() const
+        {
+            return mVisibleSet;
+        }
+
+        // Statistics for the most recent Cull call.
+        inline unsigned int GetNumOccluderTriangles() const
+        {
+            return mNumOccluderTriangles;
+        }
+
+        inline unsigned int GetNumOccluded() const
+        {
+            return mNumOccluded;
+        }
+
+    private:
+        // The referenced vertices of a mesh and its indices, rebased to the
+        // first of them.  neighbors[3 * t + i] is the vertex opposite edge i
+        // of triangle t in the one other triangle that has the edge, if
+        // there is exactly one.  Vertices at the same position are one
+        // vertex here, so the seams of the MeshFactory meshes are closed.
+        struct Mesh
+        {
+            std::vector<float> positions;
+            std::vector<uint32_t> indices;
+            std::vector<uint32_t> neighbors;
+        };
+
+        typedef std::pair<VertexBuffer const*, IndexBuffer const*> Key;
+
+        Mesh const* GetMesh(Visual const& visual);
+        void DrawOccluder(Visual const& visual, Mesh const& mesh, Matrix4x4<float> const& pvMatrix,
+            Vector4<float> const& P, Vector4<float> const& D, float dMin);
+        void DrawTriangle(float const* v0, float const* v1, float const* v2, float depth,
+            bool const outline[3]);
+        void BuildPyramid();
+        bool IsOccluded(Visual const& visual, Matrix4x4<float> const& pvMatrix,
+            Vector4<float> const& P, Vector4<float> const& D, Vector4<float> const& U,
+            Vector4<float> const& R, float dMin) const;
+
+        int mWidth, mHeight;
+
+        // The depth buffer is level 0 of the pyramid.
+        struct Level
+        {
+            int width, height;
+            std::vector<float> depth;
+        };
+        std::vector<Level> mLevels;
+
+        std::unordered_set<Visual const*> mOccluders;
+
+        // A null mesh records geometry that was rejected.
+        std::map<Key, std::unique_ptr<Mesh>> mMeshes;
+
+        std::vector<float> mScreen;
+        VisibleSet mVisibleSet;
+        unsigned int mNumOccluderTriangles, mNumOccluded;
+    };
+}
@@ -0,0 +1,321 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#include "PVWBatch.h"
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PVW_BATCH_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define PVW_BATCH_TARGET(isa)
+#else
+#include <cpuid.h>
+#define PVW_BATCH_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+using namespace gte;
+
+namespace
+{
+    // The width of the widest kernel in floats.
+    size_t const BLOCK_SIZE = 16;
+
+    // Every kernel computes y = L*x for 'count' matrices x, where count is
+    // a multiple of BLOCK_SIZE.  L is a row-major 4x4 matrix, and element
+    // (r,c) of the x and y matrices is the array that starts at
+    // (4*r+c)*stride.  Each output array is written with one broadcast
+    // multiply and three multiply-adds per block.
+    void KernelScalar(float const* L, float const* x, float* y, size_t stride, size_t count)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            float const* x0 = x + (0 + c) * stride;
+            float const* x1 = x + (4 + c) * stride;
+            float const* x2 = x + (8 + c) * stride;
+            float const* x3 = x + (12 + c) * stride;
+            for (int r = 0; r < 4; ++r)
+            {
+                float const* row = L + 4 * r;
+                float* out = y + (4 * r + c) * stride;
+                for (size_t i = 0; i < count; ++i)
+                {
+                    out[i] = row[0] * x0[i] + row[1] * x1[i] + row[2] * x2[i] + row[3] * x3[i];
+                }
+            }
+        }
+    }
+
+#if defined(PVW_BATCH_X86)
+    PVW_BATCH_TARGET("sse")
+    void KernelSSE(float const* L, float const* x, float* y, size_t stride, size_t count)
+    {
+        for (size_t i = 0; i < count; i += 4)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                __m128 x0 = _mm_loadu_ps(x + (0 + c) * stride + i);
+                __m128 x1 = _mm_loadu_ps(x + (4 + c) * stride + i);
+                __m128 x2 = _mm_loadu_ps(x + (8 + c) * stride + i);
+                __m128 x3 = _mm_loadu_ps(x + (12 + c) * stride + i);
+                for (int r = 0; r < 4; ++r)
+                {
+                    float const* row = L + 4 * r;
+                    __m128 sum = _mm_mul_ps(_mm_set1_ps(row[0]), x0);
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(row[1]), x1));
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(row[2]), x2));
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(row[3]), x3));
+                    _mm_storeu_ps(y + (4 * r + c) * stride + i, sum);
+                }
+            }
+        }
+    }
+
+    PVW_BATCH_TARGET("avx2,fma")
+    void KernelAVX2(float const* L, float const* x, float* y, size_t stride, size_t count)
+    {
+        for (size_t i = 0; i < count; i += 8)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                __m256 x0 = _mm256_loadu_ps(x + (0 + c) * stride + i);
+                __m256 x1 = _mm256_loadu_ps(x + (4 + c) * stride + i);
+                __m256 x2 = _mm256_loadu_ps(x + (8 + c) * stride + i);
+                __m256 x3 = _mm256_loadu_ps(x + (12 + c) * stride + i);
+                for (int r = 0; r < 4; ++r)
+                {
+                    float const* row = L + 4 * r;
+                    __m256 sum = _mm256_mul_ps(_mm256_set1_ps(row[0]), x0);
+                    sum = _mm256_fmadd_ps(_mm256_set1_ps(row[1]), x1, sum);
+                    sum = _mm256_fmadd_ps(_mm256_set1_ps(row[2]), x2, sum);
+                    sum = _mm256_fmadd_ps(_mm256_set1_ps(row[3]), x3, sum);
+                    _mm256_storeu_ps(y + (4 * r + c) * stride + i, sum);
+                }
+            }
+        }
+    }
+
+    PVW_BATCH_TARGET("avx512f")
+    void KernelAVX512(float const* L, float const* x, float* y, size_t stride, size_t count)
+    {
+        for (size_t i = 0; i < count; i += 16)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                __m512 x0 = _mm512_loadu_ps(x + (0 + c) * stride + i);
+                __m512 x1 = _mm512_loadu_ps(x + (4 + c) * stride + i);
+                __m512 x2 = _mm512_loadu_ps(x + (8 + c) * stride + i);
+                __m512 x3 = _mm512_loadu_ps(x + (12 + c) * stride + i);
+                for (int r = 0; r < 4; ++r)
+                {
+                    float const* row = L + 4 * r;
+                    __m512 sum = _mm512_mul_ps(_mm512_set1_ps(row[0]), x0);
+                    sum = _mm512_fmadd_ps(_mm512_set1_ps(row[1]), x1, sum);
+                    sum = _mm512_fmadd_ps(_mm512_set1_ps(row[2]), x2, sum);
+                    sum = _mm512_fmadd_ps(_mm512_set1_ps(row[3]), x3, sum);
+                    _mm512_storeu_ps(y + (4 * r + c) * stride + i, sum);
+                }
+            }
+        }
+    }
+
+    void CPUID(unsigned int leaf, unsigned int subleaf, unsigned int reg[4])
+    {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuidex(info, static_cast<int>(leaf), static_cast<int>(subleaf));
+        for (int i = 0; i < 4; ++i)
+        {
+            reg[i] = static_cast<unsigned int>(info[i]);
+        }
+#else
+        if (!__get_cpuid_count(leaf, subleaf, &reg[0], &reg[1], &reg[2], &reg[3]))
+        {
+            reg[0] = reg[1] = reg[2] = reg[3] = 0;
+        }
+#endif
+    }
+
+    // The register state the operating system saves on context switches.
+    uint64_t XGETBV()
+    {
+#if defined(_MSC_VER)
+        return _xgetbv(0);
+#else
+        unsigned int eax, edx;
+        __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+    }
+#endif
+
+    typedef void (*KernelFunction)(float const*, float const*, float*, size_t, size_t);
+
+    KernelFunction GetKernelFunction(PVWBatch::Kernel kernel)
+    {
+        switch (kernel)
+        {
+#if defined(PVW_BATCH_X86)
+        case PVWBatch::SSE:
+            return KernelSSE;
+        case PVWBatch::AVX2:
+            return KernelAVX2;
+        case PVWBatch::AVX512:
+            return KernelAVX512;
+#endif
+        default:
+            return KernelScalar;
+        }
+    }
+}
+
+PVWBatch::PVWBatch()
+    :
+    mKernel(GetSupportedKernel()),
+    mNumMatrices(0),
+    mCapacity(0)
+{
+}
+
+void PVWBatch::Clear()
+{
+    mNumMatrices = 0;
+}
+
+size_t PVWBatch::Add(Matrix4x4<float> const& world)
+{
+    if (mNumMatrices == mCapacity)
+    {
+        Reserve(std::max(2 * mCapacity, BLOCK_SIZE));
+    }
+
+    // With GTE_USE_VEC_MAT the product w*pv is computed as the transpose
+    // of pv^T*w^T, so the kernel always multiplies by a matrix on the
+    // left; the operand is stored transposed.
+    size_t const i = mNumMatrices++;
+    for (int r = 0; r < 4; ++r)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+#if defined(GTE_USE_VEC_MAT)
+            mWorld[(4 * r + c) * mCapacity + i] = world(c, r);
+#else
+            mWorld[(4 * r + c) * mCapacity + i] = world(r, c);
+#endif
+        }
+    }
+    return i;
+}
+
+void PVWBatch::Compute(Matrix4x4<float> const& pvMatrix)
+{
+    if (mNumMatrices == 0)
+    {
+        return;
+    }
+
+    float L[16];
+    for (int r = 0; r < 4; ++r)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+#if defined(GTE_USE_VEC_MAT)
+            L[4 * r + c] = pvMatrix(c, r);
+#else
+            L[4 * r + c] = pvMatrix(r, c);
+#endif
+        }
+    }
+
+    // The lanes past mNumMatrices hold stale data; their products are
+    // computed and ignored.
+    size_t count = (mNumMatrices + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+    GetKernelFunction(mKernel)(L, mWorld.data(), mPVW.data(), mCapacity, count);
+}
+
+Matrix4x4<float> PVWBatch::GetPVW(size_t i) const
+{
+    Matrix4x4<float> pvw;
+    for (int r = 0; r < 4; ++r)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+#if defined(GTE_USE_VEC_MAT)
+            pvw(c, r) = mPVW[(4 * r + c) * mCapacity + i];
+#else
+            pvw(r, c) = mPVW[(4 * r + c) * mCapacity + i];
+#endif
+        }
+    }
+    return pvw;
+}
+
+PVWBatch::Kernel PVWBatch::GetSupportedKernel()
+{
+#if defined(PVW_BATCH_X86)
+    static Kernel const supported = []()
+    {
+        unsigned int leaf1[4], leaf7[4];
+        CPUID(0, 0, leaf1);
+        unsigned int const maxLeaf = leaf1[0];
+        CPUID(1, 0, leaf1);
+        if (maxLeaf >= 7)
+        {
+            CPUID(7, 0, leaf7);
+        }
+        else
+        {
+            leaf7[0] = leaf7[1] = leaf7[2] = leaf7[3] = 0;
+        }
+
+        // AVX registers are usable only when the operating system saves
+        // them (OSXSAVE and the XCR0 bits).
+        bool const osxsave = (leaf1[2] & (1u << 27)) != 0;
+        uint64_t const xcr0 = (osxsave ? XGETBV() : 0);
+        bool const ymm = (xcr0 & 0x06) == 0x06;
+        bool const zmm = (xcr0 & 0xE6) == 0xE6;
+
+        if (zmm && (leaf7[1] & (1u << 16)))
+        {
+            return AVX512;
+        }
+        if (ymm && (leaf7[1] & (1u << 5)) && (leaf1[2] & (1u << 12)))
+        {
+            return AVX2;
+        }
+        if (leaf1[3] & (1u << 25))
+        {
+            return SSE;
+        }
+        return SCALAR;
+    }();
+    return supported;
+#else
+    return SCALAR;
+#endif
+}
+
+void PVWBatch::SetKernel(Kernel kernel)
+{
+    mKernel = std::min(kernel, GetSupportedKernel());
+}
+
+void PVWBatch::Reserve(size_t capacity)
+{
+    std::vector<float> world(16 * capacity), pvw(16 * capacity);
+    for (size_t j = 0; j < 16; ++j)
+    {
+        std::copy(mWorld.begin() + j * mCapacity, mWorld.begin() + j * mCapacity + mNumMatrices,
+            world.begin() + j * capacity);
+    }
+    mWorld.swap(world);
+    mPVW.swap(pvw);
+    mCapacity = capacity;
+}
@@ -0,0 +1,76 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#pragma once
+
+#include <Mathematics/Matrix4x4.h>
+#include <cstddef>
+#include <vector>
+
+namespace gte
+{
+    class PVWBatch
+    {
+    public:
+        // The instruction sets of the product kernel.  The constructor
+        // selects the widest one the processor and the operating system
+        // support; SCALAR is used on processors other than x86.
+        enum Kernel
+        {
+            SCALAR,
+            SSE,
+            AVX2,
+            AVX512,
+            NUM_KERNELS
+        };
+
+        // Construction.  The batch multiplies the world matrices added
+        // since the last Clear by one projection-view matrix, in the order
+        // DoTransform uses:  pv*w with GTE_USE_MAT_VEC and w*pv with
+        // GTE_USE_VEC_MAT.  The matrices are stored structure-of-arrays,
+        // one array per matrix element, so that a SIMD lane holds one
+        // matrix.
+        PVWBatch();
+
+        void Clear();
+
+        // Returns the index of the matrix in the batch.
+        size_t Add(Matrix4x4<float> const& world);
+
+        void Compute(Matrix4x4<float> const& pvMatrix);
+
+        // The product of the i-th world matrix after Compute.
+        Matrix4x4<float> GetPVW(size_t i) const;
+
+        inline size_t GetNumMatrices() const
+        {
+            return mNumMatrices;
+        }
+
+        // The best kernel available at run time, and the one in use.
+        // SetKernel is for comparing the kernels; a kernel the processor
+        // does not support is replaced by the best one that it does.
+        static Kernel GetSupportedKernel();
+
+        inline Kernel GetKernel() const
+        {
+            return mKernel;
+        }
+
+        void SetKernel(Kernel kernel);
+
+    private:
+        // Element (r,c) of the kernel operand is at mWorld[(4*r+c)*mCapacity
+        // + i]; the result is stored the same way in mPVW.  The capacity is
+        // a multiple of the widest kernel so that no kernel has a tail loop.
+        void Reserve(size_t capacity);
+
+        Kernel mKernel;
+        size_t mNumMatrices, mCapacity;
+        std::vector<float> mWorld, mPVW;
+    };
+}
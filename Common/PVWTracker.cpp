@@ -0,0 +1,243 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#include "PVWTracker.h"
+#include <algorithm>
+using namespace gte;
+
+PVWTracker::PVWTracker()
+    :
+    mCameraVersion(0),
+    mInvalidateAll(false)
+{
+}
+
+PVWTracker::PVWTracker(std::shared_ptr<Camera> const& camera, BufferUpdater const& updater)
+    :
+    mCamera(camera),
+    mUpdater(updater),
+    mCameraVersion(0),
+    mInvalidateAll(true)
+{
+}
+
+void PVWTracker::Set(std::shared_ptr<Camera> const& camera, BufferUpdater const& updater)
+{
+    mCamera = camera;
+    mUpdater = updater;
+    mInvalidateAll = true;
+}
+
+bool PVWTracker::Subscribe(Matrix4x4<float> const& worldMatrix,
+    std::shared_ptr<ConstantBuffer> const& cbuffer, Motion motion,
+    std::string const& pvwMatrixName)
+{
+    if (!cbuffer || !cbuffer->HasMember(pvwMatrixName))
+    {
+        return false;
+    }
+
+    Subscription subscription;
+    subscription.worldMatrix = &worldMatrix;
+    subscription.cbuffer = cbuffer;
+    subscription.pvwMatrixName = pvwMatrixName;
+    subscription.ring = nullptr;
+    subscription.slot = 0;
+    return Insert(subscription, motion);
+}
+
+bool PVWTracker::Subscribe(Matrix4x4<float> const& worldMatrix,
+    std::shared_ptr<ConstantRing> const& ring, unsigned int slot, Motion motion)
+{
+    if (!ring || slot >= ring->GetNumSlots())
+    {
+        return false;
+    }
+
+    Subscription subscription;
+    subscription.worldMatrix = &worldMatrix;
+    subscription.ring = ring.get();
+    subscription.slot = slot;
+    if (!Insert(subscription, motion))
+    {
+        return false;
+    }
+
+    if (std::find(mRings.begin(), mRings.end(), ring) == mRings.end())
+    {
+        mRings.push_back(ring);
+    }
+    return true;
+}
+
+bool PVWTracker::Insert(Subscription& subscription, Motion motion)
+{
+    Matrix4x4<float> const* worldMatrix = subscription.worldMatrix;
+    if (mLocations.find(worldMatrix) != mLocations.end())
+    {
+        return false;
+    }
+
+    auto& subscriptions = mSubscriptions[motion];
+    subscription.world = *worldMatrix;
+    subscription.worldVersion = 1;
+    subscription.computedWorldVersion = 0;
+    subscription.computedCameraVersion = 0;
+    mLocations.insert(std::make_pair(worldMatrix, Location{ motion, subscriptions.size() }));
+    subscriptions.push_back(std::move(subscription));
+    if (motion == STATIC)
+    {
+        mInvalidated.push_back(worldMatrix);
+    }
+    return true;
+}
+
+bool PVWTracker::Unsubscribe(Matrix4x4<float> const& worldMatrix)
+{
+    auto location = mLocations.find(&worldMatrix);
+    if (location == mLocations.end())
+    {
+        return false;
+    }
+
+    // Move the last subscription into the hole.  A pending invalidation of
+    // the removed matrix is skipped by Update because the matrix is no
+    // longer found.
+    auto& subscriptions = mSubscriptions[location->second.motion];
+    size_t index = location->second.index;
+    if (index + 1 < subscriptions.size())
+    {
+        subscriptions[index] = std::move(subscriptions.back());
+        mLocations[subscriptions[index].worldMatrix].index = index;
+    }
+    subscriptions.pop_back();
+    mLocations.erase(location);
+    return true;
+}
+
+void PVWTracker::UnsubscribeAll()
+{
+    for (auto& subscriptions : mSubscriptions)
+    {
+        subscriptions.clear();
+    }
+    mLocations.clear();
+    mInvalidated.clear();
+    mRings.clear();
+}
+
+void PVWTracker::Invalidate(Matrix4x4<float> const& worldMatrix)
+{
+    auto location = mLocations.find(&worldMatrix);
+    if (location != mLocations.end())
+    {
+        ++mSubscriptions[location->second.motion][location->second.index].worldVersion;
+        if (location->second.motion == STATIC)
+        {
+            mInvalidated.push_back(&worldMatrix);
+        }
+    }
+}
+
+void PVWTracker::InvalidateAll()
+{
+    mInvalidateAll = true;
+}
+
+size_t PVWTracker::Update()
+{
+    if (!mCamera)
+    {
+        return 0;
+    }
+
+    Matrix4x4<float> const& pvMatrix = mCamera->GetProjectionViewMatrix();
+    bool const cameraChanged = (mInvalidateAll || pvMatrix != mPVMatrix);
+    if (cameraChanged)
+    {
+        mPVMatrix = pvMatrix;
+        ++mCameraVersion;
+        mInvalidateAll = false;
+    }
+
+    mDirty.clear();
+    mBatch.Clear();
+    for (auto& subscription : mSubscriptions[DYNAMIC])
+    {
+        if (*subscription.worldMatrix != subscription.world)
+        {
+            subscription.world = *subscription.worldMatrix;
+            ++subscription.worldVersion;
+        }
+        Gather(subscription);
+    }
+
+    // When the camera is unchanged, only the invalidated STATIC
+    // subscriptions are visited.
+    auto& statics = mSubscriptions[STATIC];
+    if (cameraChanged)
+    {
+        for (auto& subscription : statics)
+        {
+            Gather(subscription);
+        }
+    }
+    else
+    {
+        for (auto worldMatrix : mInvalidated)
+        {
+            auto location = mLocations.find(worldMatrix);
+            if (location != mLocations.end() && location->second.motion == STATIC)
+            {
+                Gather(statics[location->second.index]);
+            }
+        }
+    }
+    mInvalidated.clear();
+
+    // Multiply, then upload in one pass after all the matrix products.
+    mBatch.Compute(mPVMatrix);
+    for (size_t i = 0; i < mDirty.size(); ++i)
+    {
+        Subscription* subscription = mDirty[i];
+        if (subscription->ring)
+        {
+            subscription->ring->Set(subscription->slot, mBatch.GetPVW(i));
+        }
+        else
+        {
+            subscription->cbuffer->SetMember(subscription->pvwMatrixName, mBatch.GetPVW(i));
+        }
+    }
+    for (auto subscription : mDirty)
+    {
+        if (!subscription->ring)
+        {
+            mUpdater(subscription->cbuffer);
+        }
+    }
+    for (auto const& ring : mRings)
+    {
+        ring->Commit(mUpdater);
+    }
+    return mDirty.size();
+}
+
+void PVWTracker::Gather(Subscription& subscription)
+{
+    if (subscription.computedCameraVersion == mCameraVersion
+        && subscription.computedWorldVersion == subscription.worldVersion)
+    {
+        return;
+    }
+
+    subscription.world = *subscription.worldMatrix;
+    mBatch.Add(subscription.world);
+    subscription.computedCameraVersion = mCameraVersion;
+    subscription.computedWorldVersion = subscription.worldVersion;
+    mDirty.push_back(&subscription);
+}
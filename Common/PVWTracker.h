@@ -0,0 +1,123 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#pragma once
+
+#include <Graphics/Camera.h>
+#include <Graphics/ConstantBuffer.h>
+#include <Graphics/PVWUpdater.h>
+#include "ConstantRing.h"
+#include "PVWBatch.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace gte
+{
+    class PVWTracker
+    {
+    public:
+        // Construction.  PVWTracker has the interface of PVWUpdater, but
+        // Update recomputes only the subscriptions whose projection-view-
+        // world matrix is stale and uploads the changed buffers after all
+        // of them are computed.  The camera and every world matrix carry a
+        // version stamp; a subscription remembers the versions it was last
+        // computed from.  The camera has no change notification, so its
+        // version is bumped when its projection-view matrix differs from
+        // the one of the previous Update.  The stale world matrices are
+        // multiplied in one PVWBatch.
+        PVWTracker();
+        PVWTracker(std::shared_ptr<Camera> const& camera, BufferUpdater const& updater);
+
+        void Set(std::shared_ptr<Camera> const& camera, BufferUpdater const& updater);
+
+        // The world version of a DYNAMIC subscription is bumped when its
+        // world matrix differs from the one of the last Update, which costs
+        // a comparison per frame.  A STATIC subscription is not compared;
+        // the application calls Invalidate when it moves the object.
+        enum Motion
+        {
+            DYNAMIC,
+            STATIC,
+            NUM_MOTIONS
+        };
+
+        // As with PVWUpdater, the world matrix is the key of the
+        // subscription and must live until it is unsubscribed; a matrix
+        // can be subscribed once.  A new subscription is computed by the
+        // next Update.
+        bool Subscribe(Matrix4x4<float> const& worldMatrix,
+            std::shared_ptr<ConstantBuffer> const& cbuffer, Motion motion = DYNAMIC,
+            std::string const& pvwMatrixName = "pvwMatrix");
+
+        // The PVW matrix is written to a slot of a ConstantRing, and the
+        // ring is committed at the end of Update.
+        bool Subscribe(Matrix4x4<float> const& worldMatrix,
+            std::shared_ptr<ConstantRing> const& ring, unsigned int slot,
+            Motion motion = DYNAMIC);
+
+        bool Unsubscribe(Matrix4x4<float> const& worldMatrix);
+        void UnsubscribeAll();
+
+        // Bump the world version of one subscription, or treat all of
+        // them as stale at the next Update.
+        void Invalidate(Matrix4x4<float> const& worldMatrix);
+        void InvalidateAll();
+
+        // Recompute the stale subscriptions and upload their buffers.  The
+        // return value is the number of recomputed subscriptions.
+        size_t Update();
+
+        inline size_t GetNumSubscriptions() const
+        {
+            return mSubscriptions[DYNAMIC].size() + mSubscriptions[STATIC].size();
+        }
+
+    private:
+        struct Subscription
+        {
+            Matrix4x4<float> const* worldMatrix;
+            std::shared_ptr<ConstantBuffer> cbuffer;
+            std::string pvwMatrixName;
+            ConstantRing* ring;
+            unsigned int slot;
+
+            // The world matrix of the last Update and its version, and the
+            // versions the buffer was computed from.
+            Matrix4x4<float> world;
+            uint64_t worldVersion;
+            uint64_t computedWorldVersion, computedCameraVersion;
+        };
+
+        struct Location
+        {
+            Motion motion;
+            size_t index;
+        };
+
+        // Add a stale subscription to the batch.
+        void Gather(Subscription& subscription);
+        bool Insert(Subscription& subscription, Motion motion);
+
+        std::shared_ptr<Camera> mCamera;
+        BufferUpdater mUpdater;
+        Matrix4x4<float> mPVMatrix;
+        uint64_t mCameraVersion;
+        bool mInvalidateAll;
+
+        std::vector<Subscription> mSubscriptions[NUM_MOTIONS];
+        std::unordered_map<Matrix4x4<float> const*, Location> mLocations;
+
+        // The invalidated STATIC subscriptions, and the subscriptions
+        // gathered by the current Update in the order of the batch.
+        std::vector<Matrix4x4<float> const*> mInvalidated;
+        std::vector<Subscription*> mDirty;
+        PVWBatch mBatch;
+        std::vector<std::shared_ptr<ConstantRing>> mRings;
+    };
+}
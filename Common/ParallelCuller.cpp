@@ -0,0 +1,230 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#include "ParallelCuller.h"
+#include <algorithm>
+using namespace gte;
+
+ParallelCuller::ParallelCuller(std::shared_ptr<TaskScheduler> const& scheduler)
+    :
+    mScheduler(scheduler ? scheduler : std::make_shared<TaskScheduler>()),
+    mThreadData(mScheduler->GetNumThreads()),
+    mTasksPerThread(4)
+{
+}
+
+void ParallelCuller::ComputeVisibleSet(std::shared_ptr<Camera> const& camera,
+    std::shared_ptr<Spatial> const& scene)
+{
+    mVisibleSet.clear();
+    mRanges.clear();
+    if (!camera || !scene)
+    {
+        return;
+    }
+
+    mFrustum.Compute(camera);
+
+    // The root is handled here exactly as Spatial::OnGetVisibleSet would.
+    uint32_t planeMask = FrustumPlanes::ALL_PLANES;
+    bool noCull = false;
+    Spatial* root = scene.get();
+    if (!Enter(root, planeMask, noCull))
+    {
+        return;
+    }
+    if (auto visual = dynamic_cast<Visual*>(root))
+    {
+        mVisibleSet.push_back(visual);
+        return;
+    }
+    auto node = dynamic_cast<Node*>(root);
+    if (!node)
+    {
+        return;
+    }
+
+    Partition(node, planeMask, noCull);
+
+    for (auto& data : mThreadData)
+    {
+        data.visible.clear();
+    }
+    mOutputs.resize(mRanges.size());
+    for (size_t task = 0; task < mRanges.size(); ++task)
+    {
+        mScheduler->Submit({ &ParallelCuller::CullTask, this, static_cast<int>(task) });
+    }
+    mScheduler->Wait();
+
+    size_t numVisible = 0;
+    for (auto const& output : mOutputs)
+    {
+        numVisible += output.end - output.begin;
+    }
+    mVisibleSet.reserve(numVisible);
+    for (auto const& output : mOutputs)
+    {
+        auto const& visible = mThreadData[output.thread].visible;
+        mVisibleSet.insert(mVisibleSet.end(), visible.begin() + output.begin,
+            visible.begin() + output.end);
+    }
+}
+
+bool ParallelCuller::Enter(Spatial* spatial, uint32_t& planeMask, bool& noCull) const
+{
+    if (spatial->culling == CULL_ALWAYS)
+    {
+        return false;
+    }
+    if (spatial->culling == CULL_NEVER)
+    {
+        noCull = true;
+    }
+    return noCull || mFrustum.IsVisible(spatial->worldBound, planeMask);
+}
+
+void ParallelCuller::Partition(Node* root, uint32_t planeMask, bool noCull)
+{
+    size_t const target = static_cast<size_t>(mTasksPerThread) * mScheduler->GetNumThreads();
+
+    mRanges.push_back({ root, 0, root->GetNumChildren(), planeMask, noCull });
+    for (int depth = 0; depth < MAX_EXPAND_DEPTH && mRanges.size() < target; ++depth)
+    {
+        mScratch.clear();
+        bool expanded = false;
+        for (auto const& range : mRanges)
+        {
+            if (Expand(range, target))
+            {
+                expanded = true;
+            }
+        }
+        std::swap(mRanges, mScratch);
+        if (!expanded)
+        {
+            break;
+        }
+    }
+
+    // Cut long sibling runs into chunks so that a wide, flat scene (such as
+    // the gtest grid of spheres under one node) still yields enough tasks.
+    size_t numItems = 0;
+    for (auto const& range : mRanges)
+    {
+        numItems += static_cast<size_t>(range.end - range.begin);
+    }
+    int chunk = static_cast<int>(std::max<size_t>(1, (numItems + target - 1) / target));
+
+    mScratch.clear();
+    for (auto const& range : mRanges)
+    {
+        for (int begin = range.begin; begin < range.end; begin += chunk)
+        {
+            Range piece = range;
+            piece.begin = begin;
+            piece.end = std::min(range.end, begin + chunk);
+            mScratch.push_back(piece);
+        }
+    }
+    std::swap(mRanges, mScratch);
+}
+
+bool ParallelCuller::Expand(Range const& range, size_t target)
+{
+    // A run that is already long enough to be chunked is left alone.  In a
+    // shorter run, every Node child is tested on this thread and replaced by
+    // the range of its own children, while consecutive Visual children stay
+    // together.  The order of the ranges is the depth-first order.
+    if (static_cast<size_t>(range.end - range.begin) >= target)
+    {
+        mScratch.push_back(range);
+        return false;
+    }
+
+    bool expanded = false;
+    int runBegin = range.begin;
+    for (int i = range.begin; i < range.end; ++i)
+    {
+        auto node = dynamic_cast<Node*>(range.parent->GetChild(i).get());
+        if (!node)
+        {
+            continue;
+        }
+
+        if (runBegin < i)
+        {
+            mScratch.push_back({ range.parent, runBegin, i, range.planeMask, range.noCull });
+        }
+        runBegin = i + 1;
+
+        uint32_t planeMask = range.planeMask;
+        bool noCull = range.noCull;
+        if (Enter(node, planeMask, noCull) && node->GetNumChildren() > 0)
+        {
+            mScratch.push_back({ node, 0, node->GetNumChildren(), planeMask, noCull });
+        }
+        expanded = true;
+    }
+    if (runBegin < range.end)
+    {
+        mScratch.push_back({ range.parent, runBegin, range.end, range.planeMask, range.noCull });
+    }
+    return expanded;
+}
+
+void ParallelCuller::CullRange(int task, unsigned int thread)
+{
+    Range const& range = mRanges[task];
+    ThreadData& data = mThreadData[thread];
+    TaskOutput& output = mOutputs[task];
+    output.thread = thread;
+    output.begin = data.visible.size();
+
+    for (int i = range.begin; i < range.end; ++i)
+    {
+        Spatial* child = range.parent->GetChild(i).get();
+        if (!child)
+        {
+            continue;
+        }
+
+        data.stack.push_back({ child, range.planeMask, range.noCull });
+        while (!data.stack.empty())
+        {
+            StackEntry entry = data.stack.back();
+            data.stack.pop_back();
+            if (!Enter(entry.spatial, entry.planeMask, entry.noCull))
+            {
+                continue;
+            }
+
+            if (auto visual = dynamic_cast<Visual*>(entry.spatial))
+            {
+                data.visible.push_back(visual);
+            }
+            else if (auto node = dynamic_cast<Node*>(entry.spatial))
+            {
+                for (int j = node->GetNumChildren() - 1; j >= 0; --j)
+                {
+                    Spatial* grandchild = node->GetChild(j).get();
+                    if (grandchild)
+                    {
+                        data.stack.push_back({ grandchild, entry.planeMask, entry.noCull });
+                    }
+                }
+            }
+        }
+    }
+
+    output.end = data.visible.size();
+}
+
+void ParallelCuller::CullTask(void* context, int item, unsigned int thread)
+{
+    static_cast<ParallelCuller*>(context)->CullRange(item, thread);
+}
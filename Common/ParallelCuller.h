@@ -0,0 +1,107 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#pragma once
+
+#include <Graphics/Camera.h>
+#include <Graphics/Culler.h>
+#include <Graphics/Node.h>
+#include <Graphics/Visual.h>
+#include <algorithm>
+#include "FrustumPlanes.h"
+#include "TaskScheduler.h"
+
+namespace gte
+{
+    class ParallelCuller
+    {
+    public:
+        // Construction.  The culler has the interface of Culler and produces
+        // the same visible set in the same order, but the scene graph is
+        // split into subtree tasks that are culled concurrently on the
+        // threads of a TaskScheduler.  Pass a scheduler to share its threads
+        // with other parallel stages; otherwise the culler creates its own
+        // with one thread per hardware thread.
+        virtual ~ParallelCuller() = default;
+        ParallelCuller(std::shared_ptr<TaskScheduler> const& scheduler = nullptr);
+
+        void ComputeVisibleSet(std::shared_ptr<Camera> const& camera,
+            std::shared_ptr<Spatial> const& scene);
+
+        inline VisibleSet& GetVisibleSet()
+        {
+            return mVisibleSet;
+        }
+
+        // The calling thread expands the top of the scene graph until there
+        // are about tasksPerThread * GetNumThreads() tasks.  More tasks give
+        // idle threads more to steal at the cost of more bookkeeping.
+        inline void SetTasksPerThread(unsigned int tasksPerThread)
+        {
+            mTasksPerThread = std::max(tasksPerThread, 1u);
+        }
+
+        inline unsigned int GetTasksPerThread() const
+        {
+            return mTasksPerThread;
+        }
+
+        inline size_t GetNumTasks() const
+        {
+            return mRanges.size();
+        }
+
+    private:
+        enum { MAX_EXPAND_DEPTH = 8 };
+
+        // A task culls the children [begin,end) of 'parent' with the plane
+        // state and culling mode inherited from the ancestors of 'parent'.
+        struct Range
+        {
+            Node* parent;
+            int begin, end;
+            uint32_t planeMask;
+            bool noCull;
+        };
+
+        struct StackEntry
+        {
+            Spatial* spatial;
+            uint32_t planeMask;
+            bool noCull;
+        };
+
+        // Each thread appends to its own visible list; a task remembers
+        // which slice of which list it produced so that the lists can be
+        // merged in task order, which is scene graph order.
+        struct alignas(64) ThreadData
+        {
+            std::vector<Visual*> visible;
+            std::vector<StackEntry> stack;
+        };
+
+        struct TaskOutput
+        {
+            unsigned int thread;
+            size_t begin, end;
+        };
+
+        bool Enter(Spatial* spatial, uint32_t& planeMask, bool& noCull) const;
+        void Partition(Node* root, uint32_t planeMask, bool noCull);
+        bool Expand(Range const& range, size_t target);
+        void CullRange(int task, unsigned int thread);
+        static void CullTask(void* context, int item, unsigned int thread);
+
+        std::shared_ptr<TaskScheduler> mScheduler;
+        FrustumPlanes mFrustum;
+        std::vector<Range> mRanges, mScratch;
+        std::vector<TaskOutput> mOutputs;
+        std::vector<ThreadData> mThreadData;
+        VisibleSet mVisibleSet;
+        unsigned int mTasksPerThread;
+    };
+}
@@ -0,0 +1,280 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#include "ParallelSceneUpdater.h"
+#include <algorithm>
+using namespace gte;
+
+ParallelSceneUpdater::ParallelSceneUpdater(std::shared_ptr<TaskScheduler> const& scheduler)
+    :
+    mScheduler(scheduler ? scheduler : std::make_shared<TaskScheduler>()),
+    mThreadData(mScheduler->GetNumThreads()),
+    mApplicationTime(0.0),
+    mTasksPerThread(4)
+{
+}
+
+void ParallelSceneUpdater::Update(std::shared_ptr<Spatial> const& scene, double applicationTime)
+{
+    mRanges.clear();
+    mExpanded.clear();
+    auto root = dynamic_cast<Node*>(scene.get());
+    if (!root)
+    {
+        if (scene)
+        {
+            scene->Update(applicationTime);
+        }
+        return;
+    }
+
+    mApplicationTime = applicationTime;
+    Partition(root, applicationTime);
+
+    if (mRanges.size() == 1)
+    {
+        UpdateRange(0, 0);
+    }
+    else if (mRanges.size() > 1)
+    {
+        for (size_t task = 0; task < mRanges.size(); ++task)
+        {
+            mScheduler->Submit({ &ParallelSceneUpdater::UpdateTask, this, static_cast<int>(task) });
+        }
+        mScheduler->Wait();
+    }
+
+    // The children of an expanded node are expanded after it, so the
+    // reverse order merges every child bound before its parent's.
+    for (auto node = mExpanded.rbegin(); node != mExpanded.rend(); ++node)
+    {
+        UpdateWorldBound(*node);
+    }
+
+    // Spatial::Update also propagates the bound to the ancestors of an
+    // initiator that is not the root of its scene.
+    for (Spatial* ancestor = root->GetParent(); ancestor; ancestor = ancestor->GetParent())
+    {
+        if (auto node = dynamic_cast<Node*>(ancestor))
+        {
+            UpdateWorldBound(node);
+        }
+    }
+}
+
+void ParallelSceneUpdater::UpdateNode(Node* node, double applicationTime)
+{
+    node->UpdateControllers(applicationTime);
+    UpdateWorldTransform(node);
+    mExpanded.push_back(node);
+}
+
+void ParallelSceneUpdater::Partition(Node* root, double applicationTime)
+{
+    size_t const target = static_cast<size_t>(mTasksPerThread) * mScheduler->GetNumThreads();
+
+    UpdateNode(root, applicationTime);
+    if (root->GetNumChildren() == 0)
+    {
+        return;
+    }
+
+    mRanges.push_back({ root, 0, root->GetNumChildren() });
+    for (int depth = 0; depth < MAX_EXPAND_DEPTH && mRanges.size() < target; ++depth)
+    {
+        mScratch.clear();
+        bool expanded = false;
+        for (auto const& range : mRanges)
+        {
+            if (Expand(range, target, applicationTime))
+            {
+                expanded = true;
+            }
+        }
+        std::swap(mRanges, mScratch);
+        if (!expanded)
+        {
+            break;
+        }
+    }
+
+    size_t numItems = 0;
+    for (auto const& range : mRanges)
+    {
+        numItems += static_cast<size_t>(range.end - range.begin);
+    }
+    int chunk = static_cast<int>(std::max<size_t>(1, (numItems + target - 1) / target));
+
+    mScratch.clear();
+    for (auto const& range : mRanges)
+    {
+        for (int begin = range.begin; begin < range.end; begin += chunk)
+        {
+            mScratch.push_back({ range.parent, begin, std::min(range.end, begin + chunk) });
+        }
+    }
+    std::swap(mRanges, mScratch);
+}
+
+bool ParallelSceneUpdater::Expand(Range const& range, size_t target, double applicationTime)
+{
+    // As in ParallelCuller::Expand, a Node child of a short run is updated
+    // on this thread and replaced by the range of its children.
+    if (static_cast<size_t>(range.end - range.begin) >= target)
+    {
+        mScratch.push_back(range);
+        return false;
+    }
+
+    bool expanded = false;
+    int runBegin = range.begin;
+    for (int i = range.begin; i < range.end; ++i)
+    {
+        auto node = dynamic_cast<Node*>(range.parent->GetChild(i).get());
+        if (!node)
+        {
+            continue;
+        }
+
+        if (runBegin < i)
+        {
+            mScratch.push_back({ range.parent, runBegin, i });
+        }
+        runBegin = i + 1;
+
+        UpdateNode(node, applicationTime);
+        if (node->GetNumChildren() > 0)
+        {
+            mScratch.push_back({ node, 0, node->GetNumChildren() });
+        }
+        expanded = true;
+    }
+    if (runBegin < range.end)
+    {
+        mScratch.push_back({ range.parent, runBegin, range.end });
+    }
+    return expanded;
+}
+
+void ParallelSceneUpdater::UpdateRange(int task, unsigned int thread)
+{
+    Range const& range = mRanges[task];
+    ThreadData& data = mThreadData[thread];
+    data.entries.clear();
+
+    for (int i = range.end - 1; i >= range.begin; --i)
+    {
+        Spatial* child = range.parent->GetChild(i).get();
+        if (child)
+        {
+            data.stack.push_back(child);
+        }
+    }
+    while (!data.stack.empty())
+    {
+        Spatial* spatial = data.stack.back();
+        data.stack.pop_back();
+
+        Entry entry{ spatial, dynamic_cast<Node*>(spatial), nullptr };
+        if (entry.node)
+        {
+            for (int j = entry.node->GetNumChildren() - 1; j >= 0; --j)
+            {
+                Spatial* child = entry.node->GetChild(j).get();
+                if (child)
+                {
+                    data.stack.push_back(child);
+                }
+            }
+        }
+        else
+        {
+            entry.visual = dynamic_cast<Visual*>(spatial);
+        }
+        data.entries.push_back(entry);
+    }
+
+    // Controllers.  The other Spatial types run theirs in their Update.
+    for (auto const& entry : data.entries)
+    {
+        if (entry.node || entry.visual)
+        {
+            entry.spatial->UpdateControllers(mApplicationTime);
+        }
+    }
+
+    // World transforms, parents first, and the bounds of the leaves.
+    for (auto const& entry : data.entries)
+    {
+        if (entry.node)
+        {
+            UpdateWorldTransform(entry.node);
+        }
+        else if (entry.visual)
+        {
+            UpdateWorldTransform(entry.visual);
+            if (!entry.visual->worldBoundIsCurrent)
+            {
+                entry.visual->modelBound.TransformBy(entry.visual->worldTransform,
+                    entry.visual->worldBound);
+            }
+        }
+        else
+        {
+            entry.spatial->Update(mApplicationTime, false);
+        }
+    }
+
+    // Node bounds, children first.
+    for (auto entry = data.entries.rbegin(); entry != data.entries.rend(); ++entry)
+    {
+        if (entry->node)
+        {
+            UpdateWorldBound(entry->node);
+        }
+    }
+}
+
+void ParallelSceneUpdater::UpdateTask(void* context, int item, unsigned int thread)
+{
+    static_cast<ParallelSceneUpdater*>(context)->UpdateRange(item, thread);
+}
+
+void ParallelSceneUpdater::UpdateWorldTransform(Spatial* spatial)
+{
+    if (!spatial->worldTransformIsCurrent)
+    {
+        Spatial* parent = spatial->GetParent();
+        if (parent)
+        {
+            spatial->worldTransform = parent->worldTransform * spatial->localTransform;
+        }
+        else
+        {
+            spatial->worldTransform = spatial->localTransform;
+        }
+    }
+}
+
+void ParallelSceneUpdater::UpdateWorldBound(Node* node)
+{
+    // The same merge as Node::UpdateWorldBound, in child order, so the
+    // bound is identical to the one of a serial update.
+    if (!node->worldBoundIsCurrent)
+    {
+        node->worldBound.SetCenter({ 0.0f, 0.0f, 0.0f, 1.0f });
+        node->worldBound.SetRadius(0.0f);
+        for (int i = 0; i < node->GetNumChildren(); ++i)
+        {
+            Spatial* child = node->GetChild(i).get();
+            if (child)
+            {
+                node->worldBound.GrowToContain(child->worldBound);
+            }
+        }
+    }
+}
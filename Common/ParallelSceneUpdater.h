@@ -0,0 +1,105 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#pragma once
+
+#include <Graphics/Node.h>
+#include <Graphics/Visual.h>
+#include <algorithm>
+#include "TaskScheduler.h"
+
+namespace gte
+{
+    class ParallelSceneUpdater
+    {
+    public:
+        // Construction.  Update(scene, time) computes what scene->Update(time)
+        // does:  it runs the controllers, then the world transforms from the
+        // root down, then the world bounds from the leaves up.  The scene is
+        // split into sibling subtrees the way ParallelCuller splits it, and
+        // each subtree is a task on a TaskScheduler.  A task first runs the
+        // controllers of its subtree, then propagates the transforms in one
+        // pass and merges the bounds in a second one; the bounds of the
+        // nodes above the subtrees are merged after all tasks completed.
+        // Pass a scheduler to share its threads with other parallel stages;
+        // otherwise the updater creates its own with one thread per hardware
+        // thread.
+        //
+        // Because the controllers of a subtree run before any of its world
+        // transforms are computed, a controller may change only the local
+        // state of its object (as KeyframeController and the other engine
+        // controllers do), not read the world transforms of the current
+        // frame.  Spatial types other than Node and Visual are updated with
+        // their own Update(time, false) in the transform pass.
+        ParallelSceneUpdater(std::shared_ptr<TaskScheduler> const& scheduler = nullptr);
+
+        void Update(std::shared_ptr<Spatial> const& scene, double applicationTime);
+
+        // The calling thread expands the top of the scene graph until there
+        // are about tasksPerThread * GetNumThreads() tasks.  A scene that
+        // yields one task is updated on the calling thread.
+        inline void SetTasksPerThread(unsigned int tasksPerThread)
+        {
+            mTasksPerThread = std::max(tasksPerThread, 1u);
+        }
+
+        inline unsigned int GetTasksPerThread() const
+        {
+            return mTasksPerThread;
+        }
+
+        inline size_t GetNumTasks() const
+        {
+            return mRanges.size();
+        }
+
+    private:
+        enum { MAX_EXPAND_DEPTH = 8 };
+
+        // A task updates the subtrees of the children [begin,end) of
+        // 'parent', whose world transform is already current.
+        struct Range
+        {
+            Node* parent;
+            int begin, end;
+        };
+
+        // The subtree of a task is flattened in depth-first order, so a
+        // parent precedes its children; the casts are done once per frame.
+        struct Entry
+        {
+            Spatial* spatial;
+            Node* node;
+            Visual* visual;
+        };
+
+        struct alignas(64) ThreadData
+        {
+            std::vector<Entry> entries;
+            std::vector<Spatial*> stack;
+        };
+
+        void UpdateNode(Node* node, double applicationTime);
+        void Partition(Node* root, double applicationTime);
+        bool Expand(Range const& range, size_t target, double applicationTime);
+        void UpdateRange(int task, unsigned int thread);
+        static void UpdateTask(void* context, int item, unsigned int thread);
+        static void UpdateWorldTransform(Spatial* spatial);
+        static void UpdateWorldBound(Node* node);
+
+        std::shared_ptr<TaskScheduler> mScheduler;
+        std::vector<Range> mRanges, mScratch;
+
+        // The nodes above the subtrees, in the order they were expanded,
+        // which lists every node before its children.
+        std::vector<Node*> mExpanded;
+
+        std::vector<ThreadData> mThreadData;
+        double mApplicationTime;
+        unsigned int mTasksPerThread;
+    };
+}
@@ -0,0 +1,165 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#include "Profiler.h"
+#include <Mathematics/Logger.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+using namespace gte;
+
+std::atomic<bool> Profiler::msEnabled(false);
+
+namespace
+{
+    struct Event
+    {
+        char const* name;
+        uint64_t begin, end;
+    };
+
+    // Only the owning thread writes its ring.  The head counts every event
+    // ever recorded; the slot of event i is i % RING_CAPACITY.
+    struct ThreadRing
+    {
+        ThreadRing(unsigned int inId)
+            :
+            id(inId),
+            head(0),
+            events(Profiler::RING_CAPACITY)
+        {
+        }
+
+        unsigned int id;
+        std::string name;
+        std::atomic<uint64_t> head;
+        std::vector<Event> events;
+    };
+
+    // The rings outlive their threads so that events of finished workers
+    // are still exported.
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<ThreadRing>> rings;
+    };
+
+    Registry& GetRegistry()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    ThreadRing& GetThreadRing()
+    {
+        thread_local ThreadRing* ring = nullptr;
+        if (!ring)
+        {
+            Registry& registry = GetRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            registry.rings.push_back(std::make_unique<ThreadRing>(
+                static_cast<unsigned int>(registry.rings.size())));
+            ring = registry.rings.back().get();
+        }
+        return *ring;
+    }
+
+    void WriteString(std::ofstream& output, char const* text)
+    {
+        output << '"';
+        for (; *text; ++text)
+        {
+            if (*text == '"' || *text == '\\')
+            {
+                output << '\\';
+            }
+            output << *text;
+        }
+        output << '"';
+    }
+}
+
+uint64_t Profiler::Now()
+{
+    static auto const epoch = std::chrono::steady_clock::now();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - epoch).count());
+}
+
+void Profiler::Record(char const* name, uint64_t begin, uint64_t end)
+{
+    ThreadRing& ring = GetThreadRing();
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    ring.events[head % RING_CAPACITY] = { name, begin, end };
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::SetThreadName(char const* name)
+{
+    ThreadRing& ring = GetThreadRing();
+    std::lock_guard<std::mutex> lock(GetRegistry().mutex);
+    ring.name = name;
+}
+
+bool Profiler::SaveChromeTrace(std::string const& filename)
+{
+    std::ofstream output(filename);
+    if (!output)
+    {
+        LogWarning("Cannot write trace file " + filename);
+        return false;
+    }
+
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    // Timestamps are in microseconds.
+    output.precision(3);
+    output << std::fixed << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for (auto const& ring : registry.rings)
+    {
+        if (!ring->name.empty())
+        {
+            output << (first ? "\n" : ",\n")
+                << "{\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->id
+                << ",\"name\":\"thread_name\",\"args\":{\"name\":";
+            WriteString(output, ring->name.c_str());
+            output << "}}";
+            first = false;
+        }
+
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t numEvents = std::min<uint64_t>(head, RING_CAPACITY);
+        for (uint64_t i = head - numEvents; i < head; ++i)
+        {
+            Event const& event = ring->events[i % RING_CAPACITY];
+            output << (first ? "\n" : ",\n") << "{\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->id
+                << ",\"ts\":" << static_cast<double>(event.begin) * 0.001
+                << ",\"dur\":" << static_cast<double>(event.end - event.begin) * 0.001
+                << ",\"name\":";
+            WriteString(output, event.name);
+            output << "}";
+            first = false;
+        }
+    }
+    output << "\n]}\n";
+    return static_cast<bool>(output);
+}
+
+void Profiler::Clear()
+{
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto const& ring : registry.rings)
+    {
+        ring->head.store(0, std::memory_order_relaxed);
+    }
+}
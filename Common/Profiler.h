@@ -0,0 +1,96 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Annotate the enclosing scope with a Chrome trace event.  The name must
+// have static storage duration, typically a string literal.  Defining
+// GTE_DISABLE_PROFILER removes the annotations from the build; otherwise a
+// disabled profiler costs one relaxed atomic load per scope.
+#if defined(GTE_DISABLE_PROFILER)
+#define GTE_PROFILE_SCOPE(name)
+#else
+#define GTE_PROFILE_CONCATENATE(a, b) a##b
+#define GTE_PROFILE_SCOPE_AT(name, line) gte::Profiler::Scope GTE_PROFILE_CONCATENATE(profileScope, line)(name)
+#define GTE_PROFILE_SCOPE(name) GTE_PROFILE_SCOPE_AT(name, __LINE__)
+#endif
+
+namespace gte
+{
+    class Profiler
+    {
+    public:
+        // Recording is off until Enable(true).  Every thread records into a
+        // ring buffer of its own, allocated on its first event, so the hot
+        // path takes no locks; when a ring is full the oldest events are
+        // overwritten.
+        enum { RING_CAPACITY = 65536 };
+
+        static inline void Enable(bool enable)
+        {
+            msEnabled.store(enable, std::memory_order_relaxed);
+        }
+
+        static inline bool IsEnabled()
+        {
+            return msEnabled.load(std::memory_order_relaxed);
+        }
+
+        // Nanoseconds since the first use of the profiler.
+        static uint64_t Now();
+
+        // Record an event on the calling thread.  Scope does this for the
+        // lifetime of a block; Record is for code that measures begin and
+        // end itself.
+        static void Record(char const* name, uint64_t begin, uint64_t end);
+
+        // The name shown for the calling thread in the trace viewer.
+        static void SetThreadName(char const* name);
+
+        class Scope
+        {
+        public:
+            inline Scope(char const* name)
+                :
+                mName(IsEnabled() ? name : nullptr),
+                mBegin(mName ? Now() : 0)
+            {
+            }
+
+            inline ~Scope()
+            {
+                if (mName)
+                {
+                    Record(mName, mBegin, Now());
+                }
+            }
+
+            Scope(Scope const&) = delete;
+            Scope& operator=(Scope const&) = delete;
+
+        private:
+            char const* mName;
+            uint64_t mBegin;
+        };
+
+        // Write the recorded events of all threads in the Chrome trace
+        // event format (chrome://tracing, Perfetto).  Call it when the
+        // recording threads are idle, for example after the message pump
+        // returns; events written during the export may be torn.
+        static bool SaveChromeTrace(std::string const& filename);
+
+        // Discard the recorded events.  The same restriction applies.
+        static void Clear();
+
+    private:
+        static std::atomic<bool> msEnabled;
+    };
+}
@@ -0,0 +1,632 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#include "SceneCache.h"
+#include <Mathematics/Logger.h>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <type_traits>
+#include <vector>
+using namespace gte;
+
+namespace
+{
+    // The file is a Header followed by the node records, the mesh records,
+    // the chain records, the string table and the vertex and index data;
+    // every section starts on a 16-byte boundary and is addressed by its
+    // offset from the start of the file.  The records are stored in the
+    // native byte order and layout, so a cache is only valid for the build
+    // that wrote it, which is all a startup cache needs.  The nodes are in
+    // depth-first order, so a parent always precedes its children and the
+    // root is record 0.
+    enum
+    {
+        CACHE_MAGIC = 0x43535447,  // "GTSC"
+        MAX_ATTRIBUTES = 16,
+        ALIGNMENT = 16,
+
+        RECORD_NODE = 0,
+        RECORD_VISUAL = 1,
+
+        TRANSFORM_IDENTITY = 1,
+        TRANSFORM_RS_MATRIX = 2,
+        TRANSFORM_UNIFORM_SCALE = 4
+    };
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t numNodes;
+        uint32_t numMeshes;
+        uint64_t nodes;
+        uint64_t meshes;
+        uint64_t strings;
+        uint64_t stringsSize;
+        uint32_t tag;
+        uint32_t numLevels;
+        uint64_t levels;
+    };
+
+    struct NodeRecord
+    {
+        int32_t parent;
+        uint32_t type;
+        int32_t mesh;
+        uint32_t effect;
+        uint32_t transformFlags;
+        float matrix[16];  // rotation for an RS matrix, else the matrix
+        float translation[3];
+        float scale[3];
+        float center[3];
+        float radius;
+    };
+
+    struct Attribute
+    {
+        uint32_t semantic;
+        uint32_t type;
+        uint32_t unit;
+        uint32_t offset;
+    };
+
+    struct MeshRecord
+    {
+        uint32_t numAttributes;
+        Attribute attributes[MAX_ATTRIBUTES];
+        uint32_t numVertices;
+        uint32_t vertexSize;
+        uint32_t vertexUsage;
+        uint32_t primitiveType;
+        uint32_t numPrimitives;
+        uint32_t numIndices;
+        uint32_t indexSize;  // 0 when the vertices are drawn in order
+        uint32_t indexUsage;
+        uint64_t vertices;
+        uint64_t indices;
+    };
+
+    // One mesh of a chain.  The records of a chain are consecutive, and
+    // the chains are numbered from 0 in the order of their records.
+    struct LevelRecord
+    {
+        uint32_t chain;
+        uint32_t mesh;
+        float center[3];
+        float radius;
+    };
+
+    static_assert(std::is_trivially_copyable<NodeRecord>::value
+        && std::is_trivially_copyable<MeshRecord>::value
+        && std::is_trivially_copyable<LevelRecord>::value, "records are copied as bytes");
+
+    size_t Align(size_t offset)
+    {
+        return (offset + ALIGNMENT - 1) & ~static_cast<size_t>(ALIGNMENT - 1);
+    }
+
+    // Offsets and counts come from the file, so ranges are checked without
+    // forming out-of-range pointers or overflowing.
+    bool InRange(uint64_t offset, uint64_t count, uint64_t size, uint64_t fileSize)
+    {
+        return offset <= fileSize && (size == 0 || count <= (fileSize - offset) / size);
+    }
+
+    class Writer
+    {
+    public:
+        Writer(SceneCache::EffectNamer const& namer)
+            :
+            mNamer(namer)
+        {
+            mStrings.push_back('\0');
+        }
+
+        uint32_t AddString(std::string const& text)
+        {
+            auto inserted = mStringOffsets.insert(std::make_pair(text,
+                static_cast<uint32_t>(mStrings.size())));
+            if (inserted.second)
+            {
+                mStrings.insert(mStrings.end(), text.begin(), text.end());
+                mStrings.push_back('\0');
+            }
+            return inserted.first->second;
+        }
+
+        void AddSpatial(Spatial& spatial, int32_t parent)
+        {
+            auto* node = dynamic_cast<Node*>(&spatial);
+            auto const* visual = dynamic_cast<Visual const*>(&spatial);
+            int32_t mesh = (visual ? AddMesh(*visual) : -1);
+            if (!node && mesh < 0)
+            {
+                LogWarning("Scene cache skips an object that is not a Node or a Visual with vertex data");
+                return;
+            }
+
+            NodeRecord record;
+            std::memset(&record, 0, sizeof(record));
+            record.parent = parent;
+            record.type = (node ? RECORD_NODE : RECORD_VISUAL);
+            record.mesh = mesh;
+            SetTransform(spatial.localTransform, record);
+            if (visual)
+            {
+                Vector4<float> center = visual->modelBound.GetCenter();
+                for (int i = 0; i < 3; ++i)
+                {
+                    record.center[i] = center[i];
+                }
+                record.radius = visual->modelBound.GetRadius();
+                record.effect = AddString(mNamer ? mNamer(*visual) : "");
+            }
+
+            int32_t index = static_cast<int32_t>(mNodes.size());
+            mNodes.push_back(record);
+            if (node)
+            {
+                for (int i = 0; i < node->GetNumChildren(); ++i)
+                {
+                    auto child = node->GetChild(i);
+                    if (child)
+                    {
+                        AddSpatial(*child, index);
+                    }
+                }
+            }
+        }
+
+        bool AddChains(SceneCache::Chains const& chains)
+        {
+            for (size_t c = 0; c < chains.size(); ++c)
+            {
+                for (auto const& visual : chains[c])
+                {
+                    int32_t mesh = (visual ? AddMesh(*visual) : -1);
+                    if (mesh < 0)
+                    {
+                        LogWarning("Scene cache cannot save a chain mesh without vertex data");
+                        return false;
+                    }
+
+                    LevelRecord record;
+                    std::memset(&record, 0, sizeof(record));
+                    record.chain = static_cast<uint32_t>(c);
+                    record.mesh = static_cast<uint32_t>(mesh);
+                    Vector4<float> center = visual->modelBound.GetCenter();
+                    for (int i = 0; i < 3; ++i)
+                    {
+                        record.center[i] = center[i];
+                    }
+                    record.radius = visual->modelBound.GetRadius();
+                    mLevels.push_back(record);
+                }
+            }
+            return true;
+        }
+
+        bool Write(std::string const& filename, uint32_t tag)
+        {
+            Header header;
+            std::memset(&header, 0, sizeof(header));
+            header.magic = CACHE_MAGIC;
+            header.version = SceneCache::FORMAT_VERSION;
+            header.numNodes = static_cast<uint32_t>(mNodes.size());
+            header.numMeshes = static_cast<uint32_t>(mMeshes.size());
+            header.numLevels = static_cast<uint32_t>(mLevels.size());
+            header.tag = tag;
+            header.nodes = Align(sizeof(Header));
+            header.meshes = Align(header.nodes + mNodes.size() * sizeof(NodeRecord));
+            header.levels = Align(header.meshes + mMeshes.size() * sizeof(MeshRecord));
+            header.strings = Align(header.levels + mLevels.size() * sizeof(LevelRecord));
+            header.stringsSize = mStrings.size();
+
+            // The meshes of a vertex buffer that several index buffers
+            // address (GeometryPool) share one copy of its vertices.
+            size_t offset = Align(header.strings + mStrings.size());
+            std::map<VertexBuffer const*, size_t> vertexOffsets;
+            std::vector<bool> writeVertices(mMeshes.size(), false);
+            for (size_t i = 0; i < mMeshes.size(); ++i)
+            {
+                auto inserted = vertexOffsets.insert(std::make_pair(mGeometry[i].first, offset));
+                mMeshes[i].vertices = inserted.first->second;
+                if (inserted.second)
+                {
+                    writeVertices[i] = true;
+                    offset = Align(offset + VertexBytes(mMeshes[i]));
+                }
+                if (mMeshes[i].indexSize > 0)
+                {
+                    mMeshes[i].indices = offset;
+                    offset = Align(offset + mGeometry[i].second->GetNumBytes());
+                }
+            }
+
+            std::vector<char> file(offset, 0);
+            std::memcpy(file.data(), &header, sizeof(header));
+            if (!mNodes.empty())
+            {
+                std::memcpy(&file[header.nodes], mNodes.data(), mNodes.size() * sizeof(NodeRecord));
+            }
+            if (!mMeshes.empty())
+            {
+                std::memcpy(&file[header.meshes], mMeshes.data(), mMeshes.size() * sizeof(MeshRecord));
+            }
+            if (!mLevels.empty())
+            {
+                std::memcpy(&file[header.levels], mLevels.data(), mLevels.size() * sizeof(LevelRecord));
+            }
+            std::memcpy(&file[header.strings], mStrings.data(), mStrings.size());
+            for (size_t i = 0; i < mMeshes.size(); ++i)
+            {
+                if (writeVertices[i])
+                {
+                    std::memcpy(&file[mMeshes[i].vertices], mGeometry[i].first->GetData(),
+                        VertexBytes(mMeshes[i]));
+                }
+                if (mMeshes[i].indexSize > 0)
+                {
+                    std::memcpy(&file[mMeshes[i].indices], mGeometry[i].second->GetData(),
+                        mGeometry[i].second->GetNumBytes());
+                }
+            }
+
+            std::ofstream output(filename, std::ios::binary | std::ios::trunc);
+            output.write(file.data(), static_cast<std::streamsize>(file.size()));
+            output.close();
+            if (!output)
+            {
+                LogWarning("Cannot write scene cache " + filename);
+                return false;
+            }
+            return true;
+        }
+
+    private:
+        int32_t AddMesh(Visual const& visual)
+        {
+            auto const& vbuffer = visual.GetVertexBuffer();
+            auto const& ibuffer = visual.GetIndexBuffer();
+            if (!vbuffer || !vbuffer->GetData() || !ibuffer)
+            {
+                return -1;
+            }
+
+            auto key = std::make_pair(vbuffer.get(), ibuffer.get());
+            auto found = mMeshIndices.find(key);
+            if (found != mMeshIndices.end())
+            {
+                return found->second;
+            }
+
+            MeshRecord record;
+            std::memset(&record, 0, sizeof(record));
+            VertexFormat const& vformat = vbuffer->GetFormat();
+            record.numAttributes = static_cast<uint32_t>(vformat.GetNumAttributes());
+            for (uint32_t i = 0; i < record.numAttributes && i < MAX_ATTRIBUTES; ++i)
+            {
+                VASemantic semantic = VA_NO_SEMANTIC;
+                DFType type = DF_UNKNOWN;
+                unsigned int unit = 0, offset = 0;
+                vformat.GetAttribute(static_cast<int>(i), semantic, type, unit, offset);
+                record.attributes[i] = { static_cast<uint32_t>(semantic),
+                    static_cast<uint32_t>(type), unit, offset };
+            }
+            // A partly filled buffer, such as a GeometryPool page, is
+            // saved up to its active vertices.
+            record.numVertices = vbuffer->GetNumActiveElements();
+            record.vertexSize = vformat.GetVertexSize();
+            record.vertexUsage = static_cast<uint32_t>(vbuffer->GetUsage());
+            record.primitiveType = static_cast<uint32_t>(ibuffer->GetPrimitiveType());
+            record.numPrimitives = ibuffer->GetNumPrimitives();
+            record.numIndices = ibuffer->GetNumElements();
+            record.indexSize = (ibuffer->IsIndexed() ? ibuffer->GetElementSize() : 0);
+            record.indexUsage = static_cast<uint32_t>(ibuffer->GetUsage());
+
+            int32_t index = static_cast<int32_t>(mMeshes.size());
+            mMeshes.push_back(record);
+            mGeometry.push_back(std::make_pair(vbuffer.get(), ibuffer.get()));
+            mMeshIndices.insert(std::make_pair(key, index));
+            return index;
+        }
+
+        static size_t VertexBytes(MeshRecord const& record)
+        {
+            return static_cast<size_t>(record.numVertices) * record.vertexSize;
+        }
+
+        static void SetTransform(Transform<float> const& transform, NodeRecord& record)
+        {
+            if (transform.IsIdentity())
+            {
+                record.transformFlags = TRANSFORM_IDENTITY;
+                return;
+            }
+
+            Matrix4x4<float> const& matrix = (transform.IsRSMatrix() ?
+                transform.GetRotation() : transform.GetMatrix());
+            for (int r = 0, i = 0; r < 4; ++r)
+            {
+                for (int c = 0; c < 4; ++c, ++i)
+                {
+                    record.matrix[i] = matrix(r, c);
+                }
+            }
+
+            Vector3<float> translation = transform.GetTranslation();
+            Vector3<float> scale = transform.GetScale();
+            for (int i = 0; i < 3; ++i)
+            {
+                record.translation[i] = translation[i];
+                record.scale[i] = scale[i];
+            }
+
+            if (transform.IsRSMatrix())
+            {
+                record.transformFlags = TRANSFORM_RS_MATRIX;
+                if (transform.IsUniformScale())
+                {
+                    record.transformFlags |= TRANSFORM_UNIFORM_SCALE;
+                }
+            }
+        }
+
+        SceneCache::EffectNamer const& mNamer;
+        std::vector<NodeRecord> mNodes;
+        std::vector<MeshRecord> mMeshes;
+        std::vector<LevelRecord> mLevels;
+        std::vector<std::pair<VertexBuffer const*, IndexBuffer const*>> mGeometry;
+        std::map<std::pair<VertexBuffer const*, IndexBuffer const*>, int32_t> mMeshIndices;
+        std::vector<char> mStrings;
+        std::map<std::string, uint32_t> mStringOffsets;
+    };
+
+    void GetTransform(NodeRecord const& record, Transform<float>& transform)
+    {
+        if (record.transformFlags & TRANSFORM_IDENTITY)
+        {
+            return;
+        }
+
+        Matrix4x4<float> matrix;
+        for (int r = 0, i = 0; r < 4; ++r)
+        {
+            for (int c = 0; c < 4; ++c, ++i)
+            {
+                matrix(r, c) = record.matrix[i];
+            }
+        }
+
+        if (record.transformFlags & TRANSFORM_RS_MATRIX)
+        {
+            transform.SetRotation(matrix);
+            if (record.transformFlags & TRANSFORM_UNIFORM_SCALE)
+            {
+                transform.SetUniformScale(record.scale[0]);
+            }
+            else
+            {
+                transform.SetScale(record.scale[0], record.scale[1], record.scale[2]);
+            }
+        }
+        else
+        {
+            transform.SetMatrix(matrix);
+        }
+        transform.SetTranslation(record.translation[0], record.translation[1], record.translation[2]);
+    }
+}
+
+SceneCache::SceneCache()
+{
+}
+
+bool SceneCache::Save(std::string const& filename, std::string const& tag,
+    std::shared_ptr<Node> const& scene, EffectNamer const& namer, Chains const& chains)
+{
+    if (!scene)
+    {
+        return false;
+    }
+
+    Writer writer(namer);
+    uint32_t tagOffset = writer.AddString(tag);
+    writer.AddSpatial(*scene, -1);
+    if (!writer.AddChains(chains))
+    {
+        return false;
+    }
+    return writer.Write(filename, tagOffset);
+}
+
+std::shared_ptr<Node> SceneCache::Load(std::string const& filename, std::string const& tag,
+    EffectResolver const& resolver, Chains* chains)
+{
+    Clear();
+    if (!mFile.Open(filename))
+    {
+        return nullptr;
+    }
+
+    // Pointer fix-ups: every section is its offset added to the base.
+    char* base = mFile.GetData();
+    uint64_t const size = mFile.GetSize();
+    Header header;
+    if (size < sizeof(Header))
+    {
+        LogWarning("Truncated scene cache " + filename);
+        Clear();
+        return nullptr;
+    }
+    std::memcpy(&header, base, sizeof(header));
+    if (header.magic != CACHE_MAGIC || header.version != FORMAT_VERSION)
+    {
+        Clear();
+        return nullptr;
+    }
+
+    if (!InRange(header.nodes, header.numNodes, sizeof(NodeRecord), size)
+        || !InRange(header.meshes, header.numMeshes, sizeof(MeshRecord), size)
+        || !InRange(header.levels, header.numLevels, sizeof(LevelRecord), size)
+        || !InRange(header.strings, header.stringsSize, 1, size)
+        || header.stringsSize == 0 || base[header.strings + header.stringsSize - 1] != '\0'
+        || header.tag >= header.stringsSize || header.numNodes == 0
+        || header.nodes % ALIGNMENT != 0 || header.meshes % ALIGNMENT != 0
+        || header.levels % ALIGNMENT != 0)
+    {
+        LogWarning("Malformed scene cache " + filename);
+        Clear();
+        return nullptr;
+    }
+
+    char const* strings = base + header.strings;
+    if (tag != strings + header.tag)
+    {
+        Clear();
+        return nullptr;
+    }
+
+    auto const* nodes = reinterpret_cast<NodeRecord const*>(base + header.nodes);
+    auto const* meshes = reinterpret_cast<MeshRecord const*>(base + header.meshes);
+    auto const* levels = reinterpret_cast<LevelRecord const*>(base + header.levels);
+
+    std::vector<std::pair<std::shared_ptr<VertexBuffer>, std::shared_ptr<IndexBuffer>>> geometry(header.numMeshes);
+    std::map<uint64_t, std::shared_ptr<VertexBuffer>> vbufferAt;
+    for (uint32_t i = 0; i < header.numMeshes; ++i)
+    {
+        MeshRecord const& mesh = meshes[i];
+        VertexFormat vformat;
+        for (uint32_t j = 0; j < mesh.numAttributes && j < MAX_ATTRIBUTES; ++j)
+        {
+            vformat.Bind(static_cast<VASemantic>(mesh.attributes[j].semantic),
+                static_cast<DFType>(mesh.attributes[j].type), mesh.attributes[j].unit);
+        }
+
+        if (mesh.numAttributes > MAX_ATTRIBUTES || mesh.vertexSize != vformat.GetVertexSize()
+            || mesh.vertices % ALIGNMENT != 0
+            || !InRange(mesh.vertices, mesh.numVertices, mesh.vertexSize, size))
+        {
+            LogWarning("Malformed mesh " + std::to_string(i) + " in scene cache " + filename);
+            Clear();
+            return nullptr;
+        }
+
+        // Meshes that were saved from one vertex buffer share it again.
+        auto& vbuffer = vbufferAt[mesh.vertices];
+        if (vbuffer && (vbuffer->GetNumElements() != mesh.numVertices
+            || static_cast<uint32_t>(vbuffer->GetElementSize()) != mesh.vertexSize))
+        {
+            LogWarning("Malformed mesh " + std::to_string(i) + " in scene cache " + filename);
+            Clear();
+            return nullptr;
+        }
+        if (!vbuffer)
+        {
+            vbuffer = std::make_shared<VertexBuffer>(vformat, mesh.numVertices, false);
+            vbuffer->SetData(base + mesh.vertices);
+            vbuffer->SetUsage(static_cast<Resource::Usage>(mesh.vertexUsage));
+        }
+
+        std::shared_ptr<IndexBuffer> ibuffer;
+        IPType type = static_cast<IPType>(mesh.primitiveType);
+        if (mesh.indexSize > 0)
+        {
+            ibuffer = std::make_shared<IndexBuffer>(type, mesh.numPrimitives, mesh.indexSize, false);
+            if (ibuffer->GetNumElements() != mesh.numIndices || mesh.indices % ALIGNMENT != 0
+                || !InRange(mesh.indices, mesh.numIndices, mesh.indexSize, size))
+            {
+                LogWarning("Malformed mesh " + std::to_string(i) + " in scene cache " + filename);
+                Clear();
+                return nullptr;
+            }
+            ibuffer->SetData(base + mesh.indices);
+            ibuffer->SetUsage(static_cast<Resource::Usage>(mesh.indexUsage));
+        }
+        else
+        {
+            ibuffer = std::make_shared<IndexBuffer>(type, mesh.numPrimitives);
+        }
+        geometry[i] = std::make_pair(vbuffer, ibuffer);
+    }
+
+    std::vector<std::shared_ptr<Node>> parents(header.numNodes);
+    for (uint32_t i = 0; i < header.numNodes; ++i)
+    {
+        NodeRecord const& record = nodes[i];
+        bool validParent = (i == 0 ? record.parent == -1 :
+            record.parent >= 0 && static_cast<uint32_t>(record.parent) < i && parents[record.parent]);
+        bool validMesh = (record.type == RECORD_NODE || (record.type == RECORD_VISUAL
+            && record.mesh >= 0 && static_cast<uint32_t>(record.mesh) < header.numMeshes
+            && record.effect < header.stringsSize));
+        if (!validParent || !validMesh || (i == 0 && record.type != RECORD_NODE))
+        {
+            LogWarning("Malformed node " + std::to_string(i) + " in scene cache " + filename);
+            Clear();
+            return nullptr;
+        }
+
+        if (record.type == RECORD_NODE)
+        {
+            auto node = std::make_shared<Node>();
+            GetTransform(record, node->localTransform);
+            if (i > 0)
+            {
+                parents[record.parent]->AttachChild(node);
+            }
+            parents[i] = node;
+            continue;
+        }
+
+        auto const& mesh = geometry[record.mesh];
+        auto visual = std::make_shared<Visual>(mesh.first, mesh.second);
+        GetTransform(record, visual->localTransform);
+        visual->modelBound.SetCenter({ record.center[0], record.center[1], record.center[2], 1.0f });
+        visual->modelBound.SetRadius(record.radius);
+        if (resolver && !resolver(visual, strings + record.effect))
+        {
+            Clear();
+            return nullptr;
+        }
+        parents[record.parent]->AttachChild(visual);
+    }
+
+    Chains loaded;
+    for (uint32_t i = 0; i < header.numLevels; ++i)
+    {
+        LevelRecord const& record = levels[i];
+        if (record.mesh >= header.numMeshes || record.chain > loaded.size()
+            || record.chain + 1 < loaded.size())
+        {
+            LogWarning("Malformed chain " + std::to_string(record.chain) + " in scene cache " + filename);
+            Clear();
+            return nullptr;
+        }
+        if (record.chain == loaded.size())
+        {
+            loaded.emplace_back();
+        }
+
+        auto const& mesh = geometry[record.mesh];
+        auto visual = std::make_shared<Visual>(mesh.first, mesh.second);
+        visual->modelBound.SetCenter({ record.center[0], record.center[1], record.center[2], 1.0f });
+        visual->modelBound.SetRadius(record.radius);
+        loaded.back().push_back(visual);
+    }
+    if (chains)
+    {
+        *chains = std::move(loaded);
+    }
+    return parents[0];
+}
+
+void SceneCache::Clear()
+{
+    mFile.Close();
+}
@@ -0,0 +1,70 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#pragma once
+
+#include <Graphics/Node.h>
+#include <Graphics/Visual.h>
+#include "MappedFile.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace gte
+{
+    class SceneCache
+    {
+    public:
+        // Construction.  A scene cache file stores a Node hierarchy with
+        // the local transforms of its Nodes and Visuals, the vertex formats,
+        // the vertex and index data and the model bounds of the Visuals,
+        // and for every Visual the name of its effect.  Loading maps the
+        // file and turns its offsets into pointers; the vertex and index
+        // buffers use the mapped bytes as their storage, so the cache owns
+        // the mapping and must outlive the scene it loaded.  Visuals that
+        // share buffers in the saved scene share them after loading.
+        SceneCache();
+
+        // Effects are not serialized.  Save asks the application for a name
+        // per Visual and Load gives the name back so that the application
+        // can create the effect and subscribe the world transform for PVW
+        // updates.  When the resolver returns false, loading fails, and the
+        // application undoes what it did for the Visuals resolved so far.
+        typedef std::function<std::string(Visual const&)> EffectNamer;
+        typedef std::function<bool(std::shared_ptr<Visual> const&, std::string const&)> EffectResolver;
+
+        // Chains of meshes stored apart from the hierarchy, for example the
+        // levels of detail of a shape from finest to coarsest.  Only the
+        // vertex and index buffers and the model bound of a Visual in a
+        // chain are saved, and Load creates Visuals that have just those.
+        typedef std::vector<std::vector<std::shared_ptr<Visual>>> Chains;
+
+        // The tag identifies the content, for example the parameters the
+        // scene was generated from.  Load returns null when the file is
+        // missing, was written by another format version or with another
+        // tag, or is malformed (which is reported with LogWarning); the
+        // application then builds the scene and saves it.  Only Node and
+        // Visual objects with system-memory vertex data are saved; Save
+        // fails when a Visual of a chain has none.  The chains are returned
+        // only when Load succeeds.
+        static bool Save(std::string const& filename, std::string const& tag,
+            std::shared_ptr<Node> const& scene, EffectNamer const& namer,
+            Chains const& chains = Chains());
+
+        std::shared_ptr<Node> Load(std::string const& filename, std::string const& tag,
+            EffectResolver const& resolver, Chains* chains = nullptr);
+
+        // Release the mapped file.
+        void Clear();
+
+        enum { FORMAT_VERSION = 2 };
+
+    private:
+        MappedFile mFile;
+    };
+}
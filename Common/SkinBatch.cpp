@@ -0,0 +1,602 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#include "SkinBatch.h"
+#include <Mathematics/Logger.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SKIN_BATCH_SSE
+#include <emmintrin.h>
+#endif
+
+using namespace gte;
+
+namespace
+{
+    // Every kernel blends the palette columns of the four joints of a
+    // vertex with its weights and applies the blended map to the bind
+    // position:  out = C0*x + C1*y + C2*z + C3.  Unused influences have
+    // weight 0 and joint 0.
+    void KernelScalar(float const* palette, float const* positions, uint16_t const* joints,
+        float const* weights, float* out, unsigned int begin, unsigned int end)
+    {
+        for (unsigned int v = begin; v < end; ++v)
+        {
+            float blend[16] = {};
+            for (int i = 0; i < 4; ++i)
+            {
+                float const w = weights[4 * v + i];
+                float const* entry = palette + 16 * joints[4 * v + i];
+                for (int k = 0; k < 16; ++k)
+                {
+                    blend[k] += w * entry[k];
+                }
+            }
+
+            float const* p = positions + 3 * v;
+            float* q = out + 3 * v;
+            for (int r = 0; r < 3; ++r)
+            {
+                q[r] = blend[r] * p[0] + blend[4 + r] * p[1] + blend[8 + r] * p[2] + blend[12 + r];
+            }
+        }
+    }
+
+#if defined(SKIN_BATCH_SSE)
+    void KernelSSE(float const* palette, float const* positions, uint16_t const* joints,
+        float const* weights, float* out, unsigned int begin, unsigned int end)
+    {
+        for (unsigned int v = begin; v < end; ++v)
+        {
+            __m128 c0 = _mm_setzero_ps(), c1 = c0, c2 = c0, c3 = c0;
+            for (int i = 0; i < 4; ++i)
+            {
+                __m128 w = _mm_set1_ps(weights[4 * v + i]);
+                float const* entry = palette + 16 * joints[4 * v + i];
+                c0 = _mm_add_ps(c0, _mm_mul_ps(w, _mm_loadu_ps(entry)));
+                c1 = _mm_add_ps(c1, _mm_mul_ps(w, _mm_loadu_ps(entry + 4)));
+                c2 = _mm_add_ps(c2, _mm_mul_ps(w, _mm_loadu_ps(entry + 8)));
+                c3 = _mm_add_ps(c3, _mm_mul_ps(w, _mm_loadu_ps(entry + 12)));
+            }
+
+            float const* p = positions + 3 * v;
+            __m128 q = _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(p[0])), c3);
+            q = _mm_add_ps(q, _mm_mul_ps(c1, _mm_set1_ps(p[1])));
+            q = _mm_add_ps(q, _mm_mul_ps(c2, _mm_set1_ps(p[2])));
+
+            // The output is packed float3, so the fourth lane is dropped.
+            alignas(16) float result[4];
+            _mm_store_ps(result, q);
+            std::memcpy(out + 3 * v, result, 3 * sizeof(float));
+        }
+    }
+#endif
+
+    // The element (r,c) of the map that multiplies column vectors, for
+    // either matrix convention.
+    inline float GetMapElement(Matrix4x4<float> const& M, int r, int c)
+    {
+#if defined(GTE_USE_VEC_MAT)
+        return M(c, r);
+#else
+        return M(r, c);
+#endif
+    }
+
+    // The offset of the first vertex attribute with 'semantic', when the
+    // attribute has the type 'type'.
+    bool GetAttribute(VertexFormat const& vformat, VASemantic semantic, DFType type,
+        unsigned int& offset)
+    {
+        int index = vformat.GetIndex(semantic, 0);
+        if (index < 0 || vformat.GetType(index) != type)
+        {
+            return false;
+        }
+        offset = vformat.GetOffset(index);
+        return true;
+    }
+}
+
+SkinBatch::SkinBatch(Mode mode, std::shared_ptr<TaskScheduler> const& scheduler)
+    :
+    mMode(mode),
+#if defined(SKIN_BATCH_SSE)
+    mKernel(SSE),
+#else
+    mKernel(SCALAR),
+#endif
+    mScheduler(scheduler),
+    mNumVertices(0)
+{
+    if (mMode == CPU && !mScheduler)
+    {
+        mScheduler = std::make_shared<TaskScheduler>();
+    }
+}
+
+int SkinBatch::AddSkin(std::vector<Spatial*> const& joints,
+    std::vector<Matrix4x4<float>> const& inverseBindMatrices)
+{
+    if (joints.empty() || joints.size() != inverseBindMatrices.size() || joints.size() > 65536)
+    {
+        LogWarning("A skin needs joints and one inverse bind matrix per joint.");
+        return -1;
+    }
+
+    Skin skin;
+    skin.joints = joints;
+    skin.inverseBindMatrices = inverseBindMatrices;
+    skin.jointMatrices.resize(joints.size());
+    skin.jointWorlds.resize(joints.size());
+    skin.version = 0;
+    mSkins.push_back(std::move(skin));
+    return static_cast<int>(mSkins.size()) - 1;
+}
+
+bool SkinBatch::AddMesh(std::shared_ptr<Visual> const& visual, int skin)
+{
+    if (!visual || mMeshIndex.find(visual.get()) != mMeshIndex.end())
+    {
+        return visual != nullptr;
+    }
+    if (skin < 0 || static_cast<size_t>(skin) >= mSkins.size())
+    {
+        LogWarning("Invalid skin index.");
+        return false;
+    }
+
+    auto const& vbuffer = visual->GetVertexBuffer();
+    VertexFormat const& vformat = vbuffer->GetFormat();
+    unsigned int positionOffset, jointOffset, weightOffset;
+    if (!vbuffer->GetData()
+        || !GetAttribute(vformat, VA_POSITION, DF_R32G32B32_FLOAT, positionOffset)
+        || !GetAttribute(vformat, VA_BLENDINDICES, DF_R32G32B32A32_FLOAT, jointOffset)
+        || !GetAttribute(vformat, VA_BLENDWEIGHT, DF_R32G32B32A32_FLOAT, weightOffset))
+    {
+        LogWarning("The vertex buffer has no float3 positions with float4 joints and weights.");
+        return false;
+    }
+
+    auto mesh = std::make_unique<Mesh>();
+    mesh->visual = visual.get();
+    mesh->skin = skin;
+    mesh->skinVersion = 0;
+    mesh->dirty = false;
+    mesh->numVertices = vbuffer->GetNumElements();
+    mesh->positions.resize(3 * static_cast<size_t>(mesh->numVertices));
+    mesh->joints.resize(MAX_INFLUENCES * static_cast<size_t>(mesh->numVertices));
+    mesh->weights.resize(MAX_INFLUENCES * static_cast<size_t>(mesh->numVertices));
+
+    // Gather the interleaved attributes.  The weights are normalized, as
+    // glTF requires but exporters do not always ensure.
+    size_t const numJoints = mSkins[skin].joints.size();
+    unsigned int const vertexSize = vformat.GetVertexSize();
+    char const* vertex = vbuffer->GetData();
+    for (unsigned int v = 0; v < mesh->numVertices; ++v, vertex += vertexSize)
+    {
+        float values[4];
+        std::memcpy(&mesh->positions[3 * v], vertex + positionOffset, 3 * sizeof(float));
+
+        std::memcpy(values, vertex + weightOffset, sizeof(values));
+        float sum = 0.0f;
+        for (int i = 0; i < MAX_INFLUENCES; ++i)
+        {
+            values[i] = std::max(values[i], 0.0f);
+            sum += values[i];
+        }
+        if (sum == 0.0f)
+        {
+            // An unweighted vertex follows the first joint that it lists.
+            values[0] = 1.0f;
+            sum = 1.0f;
+        }
+        for (int i = 0; i < MAX_INFLUENCES; ++i)
+        {
+            mesh->weights[MAX_INFLUENCES * v + i] = values[i] / sum;
+        }
+
+        std::memcpy(values, vertex + jointOffset, sizeof(values));
+        for (int i = 0; i < MAX_INFLUENCES; ++i)
+        {
+            size_t joint = static_cast<size_t>(std::max(values[i], 0.0f));
+            if (mesh->weights[MAX_INFLUENCES * v + i] == 0.0f)
+            {
+                joint = 0;
+            }
+            else if (joint >= numJoints)
+            {
+                LogWarning("A vertex references a joint that is not in the skin.");
+                return false;
+            }
+            mesh->joints[MAX_INFLUENCES * v + i] = static_cast<uint16_t>(joint);
+        }
+    }
+
+    // The bound of the deformed mesh is the union of the bounds of the
+    // joint influences, each moved by its palette entry; a blend of points
+    // lies in the convex hull of the moved spheres.
+    mesh->jointSpheres.assign(numJoints, { 0.0f, 0.0f, 0.0f, -1.0f });
+    std::vector<std::array<float, 6>> boxes(numJoints);
+    for (unsigned int v = 0; v < mesh->numVertices; ++v)
+    {
+        float const* p = &mesh->positions[3 * v];
+        for (int i = 0; i < MAX_INFLUENCES; ++i)
+        {
+            if (mesh->weights[MAX_INFLUENCES * v + i] == 0.0f)
+            {
+                continue;
+            }
+            size_t j = mesh->joints[MAX_INFLUENCES * v + i];
+            auto& box = boxes[j];
+            if (mesh->jointSpheres[j][3] < 0.0f)
+            {
+                box = { p[0], p[1], p[2], p[0], p[1], p[2] };
+                mesh->jointSpheres[j][3] = 0.0f;
+            }
+            for (int c = 0; c < 3; ++c)
+            {
+                box[c] = std::min(box[c], p[c]);
+                box[3 + c] = std::max(box[3 + c], p[c]);
+            }
+        }
+    }
+    for (size_t j = 0; j < numJoints; ++j)
+    {
+        if (mesh->jointSpheres[j][3] >= 0.0f)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                mesh->jointSpheres[j][c] = 0.5f * (boxes[j][c] + boxes[j][3 + c]);
+            }
+        }
+    }
+    for (unsigned int v = 0; v < mesh->numVertices; ++v)
+    {
+        float const* p = &mesh->positions[3 * v];
+        for (int i = 0; i < MAX_INFLUENCES; ++i)
+        {
+            if (mesh->weights[MAX_INFLUENCES * v + i] == 0.0f)
+            {
+                continue;
+            }
+            auto& sphere = mesh->jointSpheres[mesh->joints[MAX_INFLUENCES * v + i]];
+            float sqrDistance = 0.0f;
+            for (int c = 0; c < 3; ++c)
+            {
+                float diff = p[c] - sphere[c];
+                sqrDistance += diff * diff;
+            }
+            sphere[3] = std::max(sphere[3], std::sqrt(sqrDistance));
+        }
+    }
+
+    if (mMode == CPU)
+    {
+        mesh->palette.resize(16 * numJoints);
+
+        VertexFormat skinnedFormat;
+        skinnedFormat.Bind(VA_POSITION, DF_R32G32B32_FLOAT, 0);
+        mesh->skinned = std::make_shared<VertexBuffer>(skinnedFormat, mesh->numVertices);
+        mesh->skinned->SetUsage(Resource::DYNAMIC_UPDATE);
+        std::memcpy(mesh->skinned->GetData(), mesh->positions.data(),
+            mesh->positions.size() * sizeof(float));
+        visual->SetVertexBuffer(mesh->skinned);
+
+        for (unsigned int begin = 0; begin < mesh->numVertices; begin += BATCH_SIZE)
+        {
+            mTasks.push_back({ mMeshes.size(), begin,
+                std::min<unsigned int>(mesh->numVertices, begin + BATCH_SIZE) });
+        }
+    }
+    else
+    {
+        // The shader must blend the cleaned joints and weights, not those
+        // of the file, so that both modes deform a vertex alike.  The
+        // original buffer may be mapped from the file and is not written.
+        VertexFormat skinnedFormat;
+        skinnedFormat.Bind(VA_POSITION, DF_R32G32B32_FLOAT, 0);
+        skinnedFormat.Bind(VA_BLENDINDICES, DF_R32G32B32A32_FLOAT, 0);
+        skinnedFormat.Bind(VA_BLENDWEIGHT, DF_R32G32B32A32_FLOAT, 0);
+        mesh->skinned = std::make_shared<VertexBuffer>(skinnedFormat, mesh->numVertices);
+        float* target = mesh->skinned->Get<float>();
+        for (unsigned int v = 0; v < mesh->numVertices; ++v)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                *target++ = mesh->positions[3 * v + c];
+            }
+            for (int i = 0; i < MAX_INFLUENCES; ++i)
+            {
+                *target++ = static_cast<float>(mesh->joints[MAX_INFLUENCES * v + i]);
+            }
+            for (int i = 0; i < MAX_INFLUENCES; ++i)
+            {
+                *target++ = mesh->weights[MAX_INFLUENCES * v + i];
+            }
+        }
+        visual->SetVertexBuffer(mesh->skinned);
+
+        mesh->gpuPalette = std::make_shared<StructuredBuffer>(
+            static_cast<unsigned int>(numJoints), sizeof(Matrix4x4<float>));
+        mesh->gpuPalette->SetUsage(Resource::DYNAMIC_UPDATE);
+    }
+
+    mNumVertices += mesh->numVertices;
+    mMeshIndex.insert(std::make_pair(visual.get(), mMeshes.size()));
+    mMeshes.push_back(std::move(mesh));
+    return true;
+}
+
+void SkinBatch::Clear()
+{
+    mSkins.clear();
+    mMeshes.clear();
+    mMeshIndex.clear();
+    mTasks.clear();
+    mDirtyTasks.clear();
+    mUpdatedVisuals.clear();
+    mNumVertices = 0;
+}
+
+void SkinBatch::Update(std::shared_ptr<GraphicsEngine> const& engine)
+{
+    // The joint matrices of a skin are shared by all of its meshes.  Only
+    // those of joints that moved are recomputed.
+    for (auto& skin : mSkins)
+    {
+        bool moved = false;
+        for (size_t j = 0; j < skin.joints.size(); ++j)
+        {
+            Matrix4x4<float> const& world = skin.joints[j]->worldTransform.GetHMatrix();
+            if (skin.version > 0 && world == skin.jointWorlds[j])
+            {
+                continue;
+            }
+            skin.jointWorlds[j] = world;
+#if defined(GTE_USE_VEC_MAT)
+            skin.jointMatrices[j] = skin.inverseBindMatrices[j] * world;
+#else
+            skin.jointMatrices[j] = world * skin.inverseBindMatrices[j];
+#endif
+            moved = true;
+        }
+        if (moved)
+        {
+            ++skin.version;
+        }
+    }
+
+    mUpdatedVisuals.clear();
+    for (auto& mesh : mMeshes)
+    {
+        uint64_t const version = mSkins[mesh->skin].version;
+        Matrix4x4<float> const& world = mesh->visual->worldTransform.GetHMatrix();
+        mesh->dirty = (mesh->skinVersion != version || !(mesh->world == world));
+        if (mesh->dirty)
+        {
+            mesh->skinVersion = version;
+            mesh->world = world;
+            ComputePalette(*mesh);
+            UpdateBound(*mesh);
+            mUpdatedVisuals.push_back(mesh->visual);
+        }
+    }
+    if (mUpdatedVisuals.empty())
+    {
+        return;
+    }
+
+    if (mMode == GPU)
+    {
+        for (auto const& mesh : mMeshes)
+        {
+            if (mesh->dirty)
+            {
+                engine->Update(mesh->gpuPalette);
+            }
+        }
+        return;
+    }
+
+    mDirtyTasks.clear();
+    for (size_t task = 0; task < mTasks.size(); ++task)
+    {
+        if (mMeshes[mTasks[task].mesh]->dirty)
+        {
+            mDirtyTasks.push_back(static_cast<int>(task));
+        }
+    }
+    if (mDirtyTasks.size() == 1)
+    {
+        SkinRange(mDirtyTasks[0]);
+    }
+    else if (mDirtyTasks.size() > 1)
+    {
+        for (auto task : mDirtyTasks)
+        {
+            mScheduler->Submit({ &SkinBatch::SkinTask, this, task });
+        }
+        mScheduler->Wait();
+    }
+
+    for (auto const& mesh : mMeshes)
+    {
+        if (mesh->dirty)
+        {
+            engine->Update(mesh->skinned);
+        }
+    }
+}
+
+bool SkinBatch::Bind(Visual const* visual) const
+{
+    auto element = mMeshIndex.find(visual);
+    if (element == mMeshIndex.end() || mMode != GPU)
+    {
+        return false;
+    }
+
+    auto const& effect = visual->GetEffect();
+    if (!effect)
+    {
+        return false;
+    }
+    effect->GetVertexShader()->Set("JointPalette", mMeshes[element->second]->gpuPalette);
+    return true;
+}
+
+void SkinBatch::SetKernel(Kernel kernel)
+{
+#if defined(SKIN_BATCH_SSE)
+    mKernel = kernel;
+#else
+    (void)kernel;
+    mKernel = SCALAR;
+#endif
+}
+
+void SkinBatch::ComputePalette(Mesh& mesh)
+{
+    // The palette maps the bind pose to the model space of the Visual, so
+    // the Visual is drawn with its own world transform.
+    Skin const& skin = mSkins[mesh.skin];
+    Matrix4x4<float> const& invWorld = mesh.visual->worldTransform.GetHInverse();
+    size_t const numJoints = skin.joints.size();
+
+    if (mMode == GPU)
+    {
+        auto* target = mesh.gpuPalette->Get<Matrix4x4<float>>();
+        for (size_t j = 0; j < numJoints; ++j)
+        {
+#if defined(GTE_USE_VEC_MAT)
+            target[j] = skin.jointMatrices[j] * invWorld;
+#else
+            target[j] = invWorld * skin.jointMatrices[j];
+#endif
+        }
+        return;
+    }
+
+    float* palette = mesh.palette.data();
+    for (size_t j = 0; j < numJoints; ++j)
+    {
+#if defined(GTE_USE_VEC_MAT)
+        Matrix4x4<float> M = skin.jointMatrices[j] * invWorld;
+#else
+        Matrix4x4<float> M = invWorld * skin.jointMatrices[j];
+#endif
+        float* entry = palette + 16 * j;
+        for (int c = 0; c < 4; ++c)
+        {
+            for (int r = 0; r < 4; ++r)
+            {
+                entry[4 * c + r] = GetMapElement(M, r, c);
+            }
+        }
+    }
+}
+
+void SkinBatch::UpdateBound(Mesh& mesh)
+{
+    Skin const& skin = mSkins[mesh.skin];
+    Matrix4x4<float> const& invWorld = mesh.visual->worldTransform.GetHInverse();
+
+    auto& spheres = mSpheres;
+    spheres.clear();
+    float boxMin[3] = { 0.0f, 0.0f, 0.0f }, boxMax[3] = { 0.0f, 0.0f, 0.0f };
+    for (size_t j = 0; j < skin.joints.size(); ++j)
+    {
+        auto const& sphere = mesh.jointSpheres[j];
+        if (sphere[3] < 0.0f)
+        {
+            continue;
+        }
+
+#if defined(GTE_USE_VEC_MAT)
+        Matrix4x4<float> M = skin.jointMatrices[j] * invWorld;
+#else
+        Matrix4x4<float> M = invWorld * skin.jointMatrices[j];
+#endif
+        // The radius grows by the Frobenius norm of the linear part, which
+        // bounds its largest stretch for any map, sheared or not.
+        std::array<float, 4> moved;
+        float sqrNorm = 0.0f;
+        for (int r = 0; r < 3; ++r)
+        {
+            moved[r] = GetMapElement(M, r, 3);
+            for (int c = 0; c < 3; ++c)
+            {
+                float element = GetMapElement(M, r, c);
+                moved[r] += element * sphere[c];
+                sqrNorm += element * element;
+            }
+        }
+        moved[3] = sphere[3] * std::sqrt(sqrNorm);
+
+        for (int c = 0; c < 3; ++c)
+        {
+            float lower = moved[c] - moved[3], upper = moved[c] + moved[3];
+            boxMin[c] = (spheres.empty() ? lower : std::min(boxMin[c], lower));
+            boxMax[c] = (spheres.empty() ? upper : std::max(boxMax[c], upper));
+        }
+        spheres.push_back(moved);
+    }
+
+    if (spheres.empty())
+    {
+        return;
+    }
+
+    float center[3], radius = 0.0f;
+    for (int c = 0; c < 3; ++c)
+    {
+        center[c] = 0.5f * (boxMin[c] + boxMax[c]);
+    }
+    for (auto const& sphere : spheres)
+    {
+        float sqrDistance = 0.0f;
+        for (int c = 0; c < 3; ++c)
+        {
+            float diff = sphere[c] - center[c];
+            sqrDistance += diff * diff;
+        }
+        radius = std::max(radius, std::sqrt(sqrDistance) + sphere[3]);
+    }
+
+    Visual& visual = *mesh.visual;
+    visual.modelBound.SetCenter({ center[0], center[1], center[2], 1.0f });
+    visual.modelBound.SetRadius(radius);
+    visual.modelBound.TransformBy(visual.worldTransform, visual.worldBound);
+}
+
+void SkinBatch::SkinRange(int task)
+{
+    Task const& range = mTasks[task];
+    Mesh const& mesh = *mMeshes[range.mesh];
+    float const* palette = mesh.palette.data();
+    float* out = mesh.skinned->Get<float>();
+
+#if defined(SKIN_BATCH_SSE)
+    if (mKernel == SSE)
+    {
+        KernelSSE(palette, mesh.positions.data(), mesh.joints.data(), mesh.weights.data(),
+            out, range.begin, range.end);
+        return;
+    }
+#endif
+    KernelScalar(palette, mesh.positions.data(), mesh.joints.data(), mesh.weights.data(),
+        out, range.begin, range.end);
+}
+
+void SkinBatch::SkinTask(void* context, int item, unsigned int)
+{
+    static_cast<SkinBatch*>(context)->SkinRange(item);
+}
@@ -0,0 +1,203 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#pragma once
+
+#include <Graphics/GraphicsEngine.h>
+#include <Graphics/StructuredBuffer.h>
+#include <Graphics/Visual.h>
+#include <Mathematics/Matrix4x4.h>
+#include "TaskScheduler.h"
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace gte
+{
+    class SkinBatch
+    {
+    public:
+        // Where the vertices are deformed.
+        //   CPU:  Update blends the bind pose positions with the joint
+        //     palettes on the threads of a TaskScheduler and uploads the
+        //     results; the Visual draws a dynamic VA_POSITION buffer, so
+        //     any of the wire mesh vertex shaders can be used.
+        //   GPU:  Update uploads only the palettes; the Visual draws a
+        //     static buffer of the bind pose with the joints and weights
+        //     that AddMesh cleaned, which the WireMeshSkinned vertex shader
+        //     blends.  Call Bind before drawing a Visual.
+        enum Mode
+        {
+            CPU,
+            GPU
+        };
+
+        // The kernels of the CPU blend.  SSE is used on x86-64 processors,
+        // which all support it; SCALAR elsewhere.
+        enum Kernel
+        {
+            SCALAR,
+            SSE
+        };
+
+        // Construction.  Pass a scheduler to share its threads with other
+        // parallel stages; otherwise the batch creates its own with one
+        // thread per hardware thread.
+        SkinBatch(Mode mode = CPU, std::shared_ptr<TaskScheduler> const& scheduler = nullptr);
+
+        // A skin is a set of joints and the inverse bind matrices that map
+        // the mesh space of the bind pose to the joint spaces, in the
+        // convention of GTE_USE_MAT_VEC or GTE_USE_VEC_MAT.  The joints are
+        // not owned and must outlive the batch or its next Clear.  AddSkin
+        // returns the index of the skin, or -1 when there are no joints
+        // or the arrays differ in size.
+        int AddSkin(std::vector<Spatial*> const& joints,
+            std::vector<Matrix4x4<float>> const& inverseBindMatrices);
+
+        // The vertex buffer of the Visual must have float3 VA_POSITION,
+        // float4 VA_BLENDINDICES (joint indices of the skin) and float4
+        // VA_BLENDWEIGHT attributes.  In both modes the Visual is given a
+        // vertex buffer of its own.  A Visual that was added already is
+        // accepted and left alone.  AddMesh returns false and reports the
+        // reason with LogWarning when the Visual cannot be skinned.
+        bool AddMesh(std::shared_ptr<Visual> const& visual, int skin);
+
+        void Clear();
+
+        // Call once per frame after the world transforms of the joints and
+        // the Visuals are current.  The palette of a Visual maps its bind
+        // pose to its model space, and the model and world bounds of the
+        // Visual are set to contain the deformed mesh; the bounds of its
+        // ancestors are not changed.  A mesh whose joints and Visual have
+        // the world transforms of its previous update is skipped: its
+        // palette, vertices and bounds are neither recomputed nor uploaded.
+        void Update(std::shared_ptr<GraphicsEngine> const& engine);
+
+        // GPU mode:  set the JointPalette buffer of 'visual' on its vertex
+        // shader, which all Visuals of a program share.  Returns false for
+        // Visuals that are not in the batch.
+        bool Bind(Visual const* visual) const;
+
+        inline bool Contains(Visual const* visual) const
+        {
+            return mMeshIndex.find(visual) != mMeshIndex.end();
+        }
+
+        inline Mode GetMode() const
+        {
+            return mMode;
+        }
+
+        inline Kernel GetKernel() const
+        {
+            return mKernel;
+        }
+
+        // A kernel the processor does not support is replaced by SCALAR.
+        void SetKernel(Kernel kernel);
+
+        // Statistics.
+        inline size_t GetNumMeshes() const
+        {
+            return mMeshes.size();
+        }
+
+        inline size_t GetNumVertices() const
+        {
+            return mNumVertices;
+        }
+
+        inline size_t GetNumTasks() const
+        {
+            return mTasks.size();
+        }
+
+        // The Visuals that the most recent Update deformed, whose bounds
+        // changed; pass them to BVHCuller::MarkMoved.
+        inline std::vector<Visual*> const& GetUpdatedVisuals() const
+        {
+            return mUpdatedVisuals;
+        }
+
+        inline size_t GetNumUpdatedMeshes() const
+        {
+            return mUpdatedVisuals.size();
+        }
+
+    private:
+        enum { MAX_INFLUENCES = 4, BATCH_SIZE = 2048 };
+
+        struct Skin
+        {
+            std::vector<Spatial*> joints;
+            std::vector<Matrix4x4<float>> inverseBindMatrices;
+
+            // joint world * inverse bind, computed when the joint world
+            // transform differs from the copy in jointWorlds.  The version
+            // changes whenever any joint moved.
+            std::vector<Matrix4x4<float>> jointMatrices;
+            std::vector<Matrix4x4<float>> jointWorlds;
+            uint64_t version;
+        };
+
+        struct Mesh
+        {
+            Visual* visual;
+            int skin;
+            unsigned int numVertices;
+
+            // The bind pose, MAX_INFLUENCES joints and normalized weights
+            // per vertex.
+            std::vector<float> positions;
+            std::vector<uint16_t> joints;
+            std::vector<float> weights;
+
+            // The bounding sphere (center, radius) of the bind pose vertices
+            // that each joint influences; a negative radius marks a joint
+            // without vertices.
+            std::vector<std::array<float, 4>> jointSpheres;
+
+            // The 16 floats of palette entry j are the columns of the
+            // affine map that a kernel applies to (x,y,z,1).
+            std::vector<float> palette;
+
+            std::shared_ptr<VertexBuffer> skinned;
+            std::shared_ptr<StructuredBuffer> gpuPalette;
+
+            // The skin version and Visual world transform of the last
+            // update, and whether the current Update deforms the mesh.
+            uint64_t skinVersion;
+            Matrix4x4<float> world;
+            bool dirty;
+        };
+
+        struct Task
+        {
+            size_t mesh;
+            unsigned int begin, end;
+        };
+
+        void ComputePalette(Mesh& mesh);
+        void UpdateBound(Mesh& mesh);
+        void SkinRange(int task);
+        static void SkinTask(void* context, int item, unsigned int thread);
+
+        Mode mMode;
+        Kernel mKernel;
+        std::shared_ptr<TaskScheduler> mScheduler;
+        std::vector<Skin> mSkins;
+        std::vector<std::unique_ptr<Mesh>> mMeshes;
+        std::map<Visual const*, size_t> mMeshIndex;
+        std::vector<Task> mTasks;
+        std::vector<int> mDirtyTasks;
+        std::vector<std::array<float, 4>> mSpheres;
+        std::vector<Visual*> mUpdatedVisuals;
+        size_t mNumVertices;
+    };
+}
@@ -0,0 +1,161 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#include "TaskScheduler.h"
+#include "Profiler.h"
+#include <algorithm>
+using namespace gte;
+
+TaskScheduler::~TaskScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+        mQuit = true;
+    }
+    mSleep.notify_all();
+    for (auto& worker : mWorkers)
+    {
+        worker.join();
+    }
+}
+
+TaskScheduler::TaskScheduler(unsigned int numThreads)
+    :
+    mQueues(numThreads > 0 ? numThreads : std::max(1u, std::thread::hardware_concurrency())),
+    mQueued(0),
+    mPending(0),
+    mQuit(false)
+{
+    for (auto& queue : mQueues)
+    {
+        queue.tasks.reserve(256);
+    }
+
+    mWorkers.reserve(mQueues.size() - 1);
+    for (unsigned int thread = 1; thread < GetNumThreads(); ++thread)
+    {
+        mWorkers.emplace_back(&TaskScheduler::WorkerLoop, this, thread);
+    }
+}
+
+void TaskScheduler::Submit(Task const& task, unsigned int thread)
+{
+    // Count the task as pending before it becomes visible.  Otherwise a
+    // thief could finish it before the increment and Wait() could observe a
+    // transient zero while other tasks are still running.
+    mPending.fetch_add(1);
+    Queue& queue = mQueues[thread];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(task);
+    }
+
+    // The sleep mutex is taken so that the increment cannot slip between a
+    // worker's test of mQueued and its call to wait().
+    {
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+        mQueued.fetch_add(1);
+    }
+    mSleep.notify_one();
+}
+
+void TaskScheduler::Wait()
+{
+    Task task;
+    while (mPending.load() > 0)
+    {
+        if (Acquire(0, task))
+        {
+            Execute(task, 0);
+        }
+        else
+        {
+            // The remaining tasks are running on workers and may still
+            // submit more, so keep polling rather than sleeping.
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool TaskScheduler::Pop(unsigned int thread, Task& task)
+{
+    Queue& queue = mQueues[thread];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.size() > queue.head)
+    {
+        task = queue.tasks.back();
+        queue.tasks.pop_back();
+        if (queue.tasks.size() == queue.head)
+        {
+            queue.tasks.clear();
+            queue.head = 0;
+        }
+        return true;
+    }
+    return false;
+}
+
+bool TaskScheduler::Steal(unsigned int thread, Task& task)
+{
+    unsigned int const numThreads = GetNumThreads();
+    for (unsigned int i = 1; i < numThreads; ++i)
+    {
+        Queue& queue = mQueues[(thread + i) % numThreads];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.size() > queue.head)
+        {
+            task = queue.tasks[queue.head++];
+            if (queue.tasks.size() == queue.head)
+            {
+                queue.tasks.clear();
+                queue.head = 0;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TaskScheduler::Acquire(unsigned int thread, Task& task)
+{
+    if (Pop(thread, task) || Steal(thread, task))
+    {
+        mQueued.fetch_sub(1);
+        return true;
+    }
+    return false;
+}
+
+void TaskScheduler::Execute(Task const& task, unsigned int thread)
+{
+    {
+        GTE_PROFILE_SCOPE("Task");
+        task.execute(task.context, task.item, thread);
+    }
+    mPending.fetch_sub(1);
+}
+
+void TaskScheduler::WorkerLoop(unsigned int thread)
+{
+    Profiler::SetThreadName("TaskScheduler worker");
+    Task task;
+    for (;;)
+    {
+        if (Acquire(thread, task))
+        {
+            Execute(task, thread);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mSleepMutex);
+        mSleep.wait(lock, [this]() { return mQuit || mQueued.load() > 0; });
+        if (mQuit)
+        {
+            return;
+        }
+    }
+}
@@ -0,0 +1,81 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gte
+{
+    class TaskScheduler
+    {
+    public:
+        // A task is a function pointer with an opaque context and an item
+        // index, so submitting work never allocates.  The 'thread' argument
+        // passed to the function identifies the executing thread in
+        // [0,GetNumThreads()); thread 0 is the one that calls Wait().
+        struct Task
+        {
+            void (*execute)(void* context, int item, unsigned int thread);
+            void* context;
+            int item;
+        };
+
+        // Construction.  The scheduler starts numThreads-1 workers; the
+        // calling thread is the remaining one.  When numThreads is 0, the
+        // number of hardware threads is used.
+        ~TaskScheduler();
+        TaskScheduler(unsigned int numThreads = 0);
+
+        inline unsigned int GetNumThreads() const
+        {
+            return static_cast<unsigned int>(mQueues.size());
+        }
+
+        // Queue a task on the deque of 'thread'.  Tasks may submit further
+        // tasks from inside execute() by passing their own thread index.
+        // The owner of a deque takes the most recently submitted task
+        // (depth first, cache warm); idle threads steal the oldest task of
+        // another deque, which for recursive work is the largest one.
+        void Submit(Task const& task, unsigned int thread = 0);
+
+        // Execute tasks on the calling thread until every submitted task has
+        // completed.  Only one thread may wait at a time.
+        void Wait();
+
+    private:
+        struct alignas(64) Queue
+        {
+            std::mutex mutex;
+            std::vector<Task> tasks;
+            size_t head = 0;
+        };
+
+        bool Pop(unsigned int thread, Task& task);
+        bool Steal(unsigned int thread, Task& task);
+        bool Acquire(unsigned int thread, Task& task);
+        void Execute(Task const& task, unsigned int thread);
+        void WorkerLoop(unsigned int thread);
+
+        std::vector<Queue> mQueues;
+        std::vector<std::thread> mWorkers;
+
+        // mQueued counts tasks sitting in the deques and is what sleeping
+        // workers wait on.  mPending counts tasks that are queued or still
+        // executing and is what Wait() waits on.
+        std::atomic<int> mQueued;
+        std::atomic<int> mPending;
+        std::mutex mSleepMutex;
+        std::condition_variable mSleep;
+        bool mQuit;
+    };
+}
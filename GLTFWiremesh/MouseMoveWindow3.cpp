@@ -121,7 +121,10 @@ bool MouseMoveWindow3::OnMouseMotion(MouseButton button, int x, int y, unsigned
 {
     if (button == MOUSE_LEFT && mTrackBall.GetActive())
     {
+        // The trackball moves the world transforms of the objects attached
+        // to it without telling the PVW tracker.
         mTrackBall.SetFinalPoint(x, mYSize - 1 - y);
+        mPVWMatrices.InvalidateAll();
         mPVWMatrices.Update();
         return true;
     }
@@ -17,6 +17,7 @@
 #include <Graphics/PVWUpdater.h>
 
 #include "FreeMouseCameraRig.h"
+#include "PVWTracker.h"
 
 namespace gte
 {
@@ -67,7 +68,7 @@ namespace gte
         BufferUpdater mUpdater;
         std::shared_ptr<Camera> mCamera;
         FreeMouseCameraRig mFreeMouseCameraRig;
-        PVWUpdater mPVWMatrices;
+        PVWTracker mPVWMatrices;
         TrackBall mTrackBall;
 
         int mouse_x, mouse_y;
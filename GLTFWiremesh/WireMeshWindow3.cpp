@@ -7,16 +7,30 @@
 
 #include <iostream>
 #include "WireMeshWindow3.h"
+#include "Profiler.h"
 #include <Graphics/MeshFactory.h>
 #include <Mathematics/Transform.h>
+#include <algorithm>
+
+// The repository's shaders, which include some that are not part of the
+// engine samples.
+#if !defined(WIREMESH_SHADERS_PATH)
+#define WIREMESH_SHADERS_PATH "../WireMesh/Shaders/"
+#endif
+
+// A mesh of a loaded scene is an occluder when the radius of its bound is
+// at least this fraction of the radius of the scene bound and it has at
+// most this many triangles, so the occluders are few, large and cheap to
+// rasterize.
+#define OCCLUDER_MIN_RADIUS_FRACTION 0.1f
+#define OCCLUDER_MAX_TRIANGLES 4096
 
 WireMeshWindow3::WireMeshWindow3(Parameters& parameters)
     :
     MouseMoveWindow3(parameters),
-    mApplicationTime(0.0),
-    mApplicationDeltaTime(0.001)
+    mEffects(mProgramFactory),
+    mSkinning(SkinBatch::CPU)
 {
-
     if (!SetEnvironment() || !CreateScene())
     {
         parameters.created = false;
@@ -33,22 +47,97 @@ WireMeshWindow3::WireMeshWindow3(Parameters& parameters)
 
 void WireMeshWindow3::OnIdle()
 {
+    GTE_PROFILE_SCOPE("OnIdle");
     mTimer.Measure();
+    mBenchmark.BeginFrame(mEngine);
+
+    if (!mBenchmark.MoveCamera(*mCamera))
+    {
+        mFreeMouseCameraRig.Move();
+    }
+
+    // Attach the meshes the streamer finished since the last frame.  A
+    // rebuild of the hierarchy visits the whole scene, so it waits until
+    // the attached visuals are as many as the hierarchy holds, which
+    // keeps the total rebuild cost linear in the size of the file, or
+    // until the streamer is done.  Until then the newer visuals are culled
+    // one by one.
+    if (mStreamer.Update(mScene,
+        [this](std::shared_ptr<Visual> const& visual)
+        {
+            if (!AttachEffect(visual))
+            {
+                return false;
+            }
+            mPendingVisuals.push_back(visual.get());
+            return true;
+        }) > 0)
+    {
+        AddSkins();
+    }
+    else if (mStreamer.GetState() == GLTFStreamer::FAILED)
+    {
+        mStreamer.Cancel();
+        mPendingVisuals.clear();
+        CreateDefaultMesh();
+        mScene->Update();
+        mCuller.Rebuild(mScene);
+    }
+    if (!mPendingVisuals.empty() && (mStreamer.GetState() != GLTFStreamer::LOADING
+        || mPendingVisuals.size() >= static_cast<size_t>(mCuller.GetNumLeaves())))
+    {
+        AddOccluders();
+        mPendingVisuals.clear();
+        mCuller.Rebuild(mScene);
+    }
+
+    {
+        GTE_PROFILE_SCOPE("Skinning");
+        mSkinning.Update(mEngine);
+        for (auto visual : mSkinning.GetUpdatedVisuals())
+        {
+            mCuller.MarkMoved(visual);
+        }
+    }
 
-    mFreeMouseCameraRig.Move();
+    mBenchmark.Begin(FrameBenchmark::PVW_UPDATE);
     mPVWMatrices.Update();    
+    mBenchmark.End();
 
+    mBenchmark.Begin(FrameBenchmark::CULL);
     mCuller.ComputeVisibleSet(mCamera, mScene);
+    if (!mPendingVisuals.empty())
+    {
+        auto& visibleSet = mCuller.GetVisibleSet();
+        mPendingFrustum.Compute(mCamera);
+        for (auto visual : mPendingVisuals)
+        {
+            uint32_t planeMask = FrustumPlanes::ALL_PLANES;
+            if (mPendingFrustum.IsVisible(visual->worldBound, planeMask))
+            {
+                visibleSet.push_back(visual);
+            }
+        }
+    }
+    mOcclusion.Cull(mCamera, mCuller.GetVisibleSet());
+    mBenchmark.End();
 
-    mEngine->ClearBuffers();
+    {
+        GTE_PROFILE_SCOPE("ClearBuffers");
+        mEngine->ClearBuffers();
+    }
 
-    for (auto const& visual : mCuller.GetVisibleSet())
+    mBenchmark.Begin(FrameBenchmark::DRAW_SUBMISSION);
+    for (auto const& visual : mOcclusion.GetVisibleSet())
     {
+      EffectCache::Bind(visual);
+      mSkinning.Bind(visual);
       mEngine->Draw(visual);
     }
 
     mEngine->Draw(8, mYSize - 8, { 1.0f, 1.0f, 1.0f, 1.0 }, mTimer.GetFPS());
-    mEngine->DisplayColorBuffer(0);
+    mBenchmark.End();
+    mBenchmark.Present(mEngine);
 
     mTimer.UpdateFrameCount();
 }
@@ -62,6 +151,87 @@ bool WireMeshWindow3::OnResize(int xSize, int ySize)
     return true;
 }
 
+void WireMeshWindow3::LoadScene(std::string const& filename)
+{
+    // The old scene is released before the streamer unmaps the buffers
+    // it references.
+    mScene->DetachAllChildren();
+    mPVWMatrices.UnsubscribeAll();
+    if (mRing)
+    {
+        mRing->Clear();
+    }
+    mSkinning.Clear();
+    mSkinIndices.clear();
+    mSkinVisualCounts.clear();
+    mPendingVisuals.clear();
+    mOcclusion.Clear();
+    mCuller.Rebuild(mScene);
+    mStreamer.Start(filename);
+}
+
+bool WireMeshWindow3::UseGPUSkinning(bool use)
+{
+    if (use && !mSkinnedProgram)
+    {
+        // The skinned meshes have PVWMatrix buffers of their own, as in
+        // the samples without the ring.
+        GTE_PROFILE_SCOPE("CreateSkinnedProgram");
+        std::string vsPath = mEnvironment.GetPath(mEngine->GetShaderName("WireMeshSkinned.vs"));
+        std::string psPath = mEnvironment.GetPath(mEngine->GetShaderName("WireMesh.ps"));
+        std::string gsPath = mEnvironment.GetPath(mEngine->GetShaderName("WireMesh.gs"));
+        if (vsPath == "")
+        {
+            LogError("Cannot find file " + mEngine->GetShaderName("WireMeshSkinned.vs"));
+            return false;
+        }
+        mSkinnedProgram = mEffects.CreateFromFiles(vsPath, psPath, gsPath,
+            [this](std::shared_ptr<VisualProgram> const& program)
+            {
+                SetWireParameters(program);
+            });
+        if (!mSkinnedProgram)
+        {
+            return false;
+        }
+    }
+
+    mSkinning = SkinBatch(use ? SkinBatch::GPU : SkinBatch::CPU);
+    mSkinIndices.clear();
+    mSkinVisualCounts.clear();
+    return true;
+}
+
+bool WireMeshWindow3::RunBenchmark(unsigned int numFrames, std::string const& output)
+{
+    // Finish streaming, or fall back to the default sphere, first.
+    while (mStreamer.GetState() == GLTFStreamer::LOADING
+        || mStreamer.GetState() == GLTFStreamer::FAILED)
+    {
+        OnIdle();
+    }
+
+    // Count the constant buffer uploads apart from the PVW products.
+    mPVWMatrices.Set(mCamera, [this](std::shared_ptr<Buffer> const& buffer)
+    {
+        mBenchmark.Begin(FrameBenchmark::CONSTANT_UPLOAD);
+        mEngine->Update(buffer);
+        mBenchmark.End();
+    });
+
+    // Circle the whole scene, slightly from above.
+    Vector4<float> center = mScene->worldBound.GetCenter();
+    float radius = std::max(mScene->worldBound.GetRadius(), 1.0f);
+    mBenchmark.Start(numFrames, mXSize, mYSize, center, 2.5f * radius, 0.5f * radius);
+    while (mBenchmark.IsRunning())
+    {
+        OnIdle();
+    }
+
+    mPVWMatrices.Set(mCamera, mUpdater);
+    return mBenchmark.Save(output, "GLTFWiremesh");
+}
+
 bool WireMeshWindow3::SetEnvironment()
 {
     std::string path = GetGTEPath();
@@ -71,6 +241,7 @@ bool WireMeshWindow3::SetEnvironment()
     }
 
     mEnvironment.Insert(path + "/Samples/Graphics/WireMesh/Shaders/");
+    mEnvironment.Insert(WIREMESH_SHADERS_PATH);
 
     std::vector<std::string> inputs =
     {
@@ -93,32 +264,53 @@ bool WireMeshWindow3::SetEnvironment()
 
 bool WireMeshWindow3::CreateScene()
 {
+    GTE_PROFILE_SCOPE("CreateScene");
     mScene = std::make_shared<Node>();
 
     std::string vsPath = mEnvironment.GetPath(mEngine->GetShaderName("WireMesh.vs"));
     std::string psPath = mEnvironment.GetPath(mEngine->GetShaderName("WireMesh.ps"));
     std::string gsPath = mEnvironment.GetPath(mEngine->GetShaderName("WireMesh.gs"));
 
-    auto program = mProgramFactory->CreateFromFiles(vsPath, psPath, gsPath);
-    if (!program)
+    // The ring vertex shader reads the PVW matrices from a ConstantRing,
+    // which uploads all of them with one update per frame.
+    std::string ringPath = mEnvironment.GetPath(mEngine->GetShaderName("WireMeshRing.vs"));
+    if (ringPath != "")
     {
-        return false;
+        vsPath = ringPath;
+        mRing = std::make_shared<ConstantRing>();
     }
 
-    auto parameters = std::make_shared<ConstantBuffer>(3 * sizeof(Vector4<float>), false);
-    auto* data = parameters->Get<Vector4<float>>();
-    data[0] = { 0.0f, 0.0f, 1.0f, 1.0f };  // mesh color
-    data[1] = { 0.0f, 0.0f, 0.0f, 1.0f };  // edge color
-    data[2] = { static_cast<float>(mXSize), static_cast<float>(mYSize), 0.0f, 0.0f };
-    program->GetVertexShader()->Set("WireParameters", parameters);
-    program->GetPixelShader()->Set("WireParameters", parameters);
-    program->GetGeometryShader()->Set("WireParameters", parameters);
+    // Every mesh of a loaded scene uses this program and its WireParameters
+    // buffer; only the PVWMatrix buffer is created per mesh.
+    {
+        GTE_PROFILE_SCOPE("CreateProgram");
+        mProgram = mEffects.CreateFromFiles(vsPath, psPath, gsPath,
+            [this](std::shared_ptr<VisualProgram> const& program)
+            {
+                SetWireParameters(program);
+                if (mRing)
+                {
+                    mRing->Attach(program->GetVertexShader());
+                }
+            });
+    }
+    if (!mProgram)
+    {
+        return false;
+    }
 
-    auto cbuffer = std::make_shared<ConstantBuffer>(sizeof(Matrix4x4<float>), true);
-    program->GetVertexShader()->Set("PVWMatrix", cbuffer);
+    if (!CreateDefaultMesh())
+    {
+        return false;
+    }
 
-    auto effect = std::make_shared<VisualEffect>(program);
+    mScene->Update();
+    return true;
+}
 
+bool WireMeshWindow3::CreateDefaultMesh()
+{
+    GTE_PROFILE_SCOPE("CreateDefaultMesh");
     VertexFormat vformat;
     vformat.Bind(VA_POSITION, DF_R32G32B32_FLOAT, 0);
     MeshFactory mf;
@@ -126,14 +318,100 @@ bool WireMeshWindow3::CreateScene()
 
     std::shared_ptr<Visual> mMesh = mf.CreateSphere(16, 16, 1.0f);
     mMesh->localTransform.SetTranslation(0.0, 0.0, 0.0);
-    mMesh->SetEffect(effect);
-
-    mPVWMatrices.Subscribe(mMesh->worldTransform, cbuffer);
+    if (!AttachEffect(mMesh))
+    {
+        return false;
+    }
 
     mScene->AttachChild(mMesh);
+    return true;
+}
 
-    mScene->Update();
+void WireMeshWindow3::SetWireParameters(std::shared_ptr<VisualProgram> const& program)
+{
+    auto parameters = std::make_shared<ConstantBuffer>(3 * sizeof(Vector4<float>), false);
+    auto* data = parameters->Get<Vector4<float>>();
+    data[0] = { 0.0f, 0.0f, 1.0f, 1.0f };  // mesh color
+    data[1] = { 0.0f, 0.0f, 0.0f, 1.0f };  // edge color
+    data[2] = { static_cast<float>(mXSize), static_cast<float>(mYSize), 0.0f, 0.0f };
+    program->GetVertexShader()->Set("WireParameters", parameters);
+    program->GetPixelShader()->Set("WireParameters", parameters);
+    program->GetGeometryShader()->Set("WireParameters", parameters);
+}
 
+bool WireMeshWindow3::AttachEffect(std::shared_ptr<Visual> const& visual)
+{
+    // The nodes of glTF scenes are not animated, so the PVW matrix of a
+    // mesh changes only with the camera.  Skinned meshes deform in their
+    // model space, which mSkinning updates.
+    if (mSkinning.GetMode() == SkinBatch::GPU && visual->GetVertexBuffer()->GetFormat().GetIndex(VA_BLENDINDICES, 0) >= 0)
+    {
+        auto cbuffer = std::make_shared<ConstantBuffer>(sizeof(Matrix4x4<float>), true);
+        visual->SetEffect(mEffects.CreateEffect(mSkinnedProgram, cbuffer));
+        mPVWMatrices.Subscribe(visual->worldTransform, cbuffer, PVWTracker::STATIC);
+        return true;
+    }
 
+    if (mRing)
+    {
+        unsigned int slot = mRing->Allocate();
+        visual->SetEffect(mEffects.CreateEffect(mProgram, mRing->GetSlotConstant(slot)));
+        mPVWMatrices.Subscribe(visual->worldTransform, mRing, slot, PVWTracker::STATIC);
+        return true;
+    }
+
+    auto cbuffer = std::make_shared<ConstantBuffer>(sizeof(Matrix4x4<float>), true);
+    visual->SetEffect(mEffects.CreateEffect(mProgram, cbuffer));
+    mPVWMatrices.Subscribe(visual->worldTransform, cbuffer, PVWTracker::STATIC);
     return true;
 }
+
+void WireMeshWindow3::AddSkins()
+{
+    // The skins arrive with the hierarchy and their Visuals with the
+    // meshes.  The streamer appends the Visuals of a skin, so only those
+    // past mSkinVisualCounts are new.
+    auto const& skins = mStreamer.GetSkins();
+    while (mSkinIndices.size() < skins.size())
+    {
+        auto const& skin = skins[mSkinIndices.size()];
+        std::vector<Spatial*> joints;
+        for (auto const& joint : skin.joints)
+        {
+            joints.push_back(joint.get());
+        }
+        mSkinIndices.push_back(joints.empty() ? -1 : mSkinning.AddSkin(joints, skin.inverseBindMatrices));
+        mSkinVisualCounts.push_back(0);
+    }
+
+    for (size_t i = 0; i < skins.size(); ++i)
+    {
+        auto const& visuals = skins[i].visuals;
+        if (mSkinIndices[i] >= 0)
+        {
+            for (size_t j = mSkinVisualCounts[i]; j < visuals.size(); ++j)
+            {
+                mSkinning.AddMesh(visuals[j], mSkinIndices[i]);
+            }
+        }
+        mSkinVisualCounts[i] = visuals.size();
+    }
+}
+
+void WireMeshWindow3::AddOccluders()
+{
+    // Skinned meshes are left out, because in GPU mode their vertex
+    // buffers hold the bind pose.  AddOccluder rejects the meshes that are
+    // not triangle meshes.
+    float minRadius = OCCLUDER_MIN_RADIUS_FRACTION * mScene->worldBound.GetRadius();
+    for (auto visual : mPendingVisuals)
+    {
+        auto const& ibuffer = visual->GetIndexBuffer();
+        if (ibuffer && ibuffer->GetNumPrimitives() <= OCCLUDER_MAX_TRIANGLES
+            && visual->worldBound.GetRadius() >= minRadius
+            && !mSkinning.Contains(visual))
+        {
+            mOcclusion.AddOccluder(visual);
+        }
+    }
+}
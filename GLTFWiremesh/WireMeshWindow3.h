@@ -9,7 +9,14 @@
 
 #include <Graphics/KeyframeController.h>
 
+#include "BVHCuller.h"
+#include "ConstantRing.h"
+#include "EffectCache.h"
+#include "FrameBenchmark.h"
+#include "GLTFStreamer.h"
 #include "MouseMoveWindow3.h"
+#include "OcclusionCuller.h"
+#include "SkinBatch.h"
 
 using namespace gte;
 
@@ -22,13 +29,60 @@ public:
 
     virtual bool OnResize(int xSize, int ySize) override;
 
+    // Replace the scene with the contents of a .gltf or .glb file.  The
+    // file is decoded on background threads and its meshes appear as they
+    // are ready; on failure the default sphere is shown.
+    void LoadScene(std::string const& filename);
+
+    // Deform the skinned meshes with the WireMeshSkinned vertex shader
+    // instead of on the CPU.  Call it before LoadScene; the skinned meshes
+    // of a scene loaded already stop deforming.  Returns false, keeping the
+    // previous mode, when the shader cannot be found or compiled.
+    bool UseGPUSkinning(bool use);
+
+    // Draw numFrames frames offscreen along a fixed camera path around the
+    // scene and write the frame times to 'output'.  A scene that is still
+    // streaming is completed first.
+    bool RunBenchmark(unsigned int numFrames, std::string const& output);
+
 private:
-    Culler mCuller;
+    BVHCuller mCuller;
+    FrameBenchmark mBenchmark;
+
+    // The visuals attached by the streamer since the hierarchy of mCuller
+    // was last rebuilt, which OnIdle culls against mPendingFrustum.
+    std::vector<Visual*> mPendingVisuals;
+    FrustumPlanes mPendingFrustum;
+
+    // The large static meshes of a loaded scene are occluders, which hide
+    // the visuals behind them after the frustum culling.
+    OcclusionCuller mOcclusion;
 
     bool SetEnvironment();
     bool CreateScene();
-    
-    std::shared_ptr<Node> mScene;
+    bool CreateDefaultMesh();
+    void SetWireParameters(std::shared_ptr<VisualProgram> const& program);
+    bool AttachEffect(std::shared_ptr<Visual> const& visual);
+    void AddSkins();
+    void AddOccluders();
+
+    EffectCache mEffects;
+    std::shared_ptr<VisualProgram> mProgram;
+
+    // The skinned meshes of a loaded scene.  mSkinnedProgram is the
+    // WireMeshSkinned program once UseGPUSkinning has selected it,
+    // mSkinIndices maps the skins of the streamer to those of mSkinning
+    // (-1 for a skin without joints), and mSkinVisualCounts is the number
+    // of Visuals of each skin that AddSkins has seen.
+    SkinBatch mSkinning;
+    std::shared_ptr<VisualProgram> mSkinnedProgram;
+    std::vector<int> mSkinIndices;
+    std::vector<size_t> mSkinVisualCounts;
 
-    double mApplicationTime, mApplicationDeltaTime;
+    // The PVW matrices of the meshes, when the WireMeshRing vertex shader
+    // is found; otherwise every mesh has a PVWMatrix buffer of its own.
+    std::shared_ptr<ConstantRing> mRing;
+    GLTFStreamer mStreamer;
+
+    std::shared_ptr<Node> mScene;
 };
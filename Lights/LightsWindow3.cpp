@@ -6,6 +6,7 @@
 // Version: 4.0.2019.08.13
 
 #include "LightsWindow3.h"
+#include "Profiler.h"
 #include <Graphics/MeshFactory.h>
 #include <Graphics/DirectionalLightEffect.h>
 #include <Graphics/PointLightEffect.h>
@@ -13,7 +14,8 @@
 
 LightsWindow3::LightsWindow3(Parameters& parameters)
     :
-    Window3(parameters)
+    Window3(parameters),
+    mLOD(8.0f)
 {
     mEngine->SetClearColor({ 0.0f, 0.25f, 0.75f, 1.0f });
     mWireState = std::make_shared<RasterizerState>();
@@ -32,27 +34,74 @@ LightsWindow3::LightsWindow3(Parameters& parameters)
 
 void LightsWindow3::OnIdle()
 {
+    GTE_PROFILE_SCOPE("OnIdle");
     mTimer.Measure();
+    mBenchmark.BeginFrame(mEngine);
 
-    if (mCameraRig.Move())
+    if (mBenchmark.MoveCamera(*mCamera) || mCameraRig.Move())
     {
+        mBenchmark.Begin(FrameBenchmark::PVW_UPDATE);
         mPVWMatrices.Update();
+        mBenchmark.End();
     }
+
+    // The sample draws all four meshes; it has no culling stage.  The
+    // trackball rotates the spheres, so their levels are selected every
+    // frame.
+    {
+        GTE_PROFILE_SCOPE("SelectLOD");
+        mLOD.Select(mCamera, mYSize, mLODVisuals);
+    }
+
+    mBenchmark.Begin(FrameBenchmark::CONSTANT_UPLOAD);
     UpdateConstants();
+    mBenchmark.End();
 
-    mEngine->ClearBuffers();
-    mEngine->Draw(mPlane[0]);
-    mEngine->Draw(mPlane[1]);
-    mEngine->Draw(mSphere[0]);
-    mEngine->Draw(mSphere[1]);
+    {
+        GTE_PROFILE_SCOPE("ClearBuffers");
+        mEngine->ClearBuffers();
+    }
+
+    mBenchmark.Begin(FrameBenchmark::DRAW_SUBMISSION);
+    {
+        GTE_PROFILE_SCOPE("SortDraws");
+        mDrawQueue.Sort(mCamera, mDrawList);
+    }
+    for (auto visual : mDrawQueue.GetVisuals())
+    {
+        mEngine->Draw(visual);
+    }
     std::array<float, 4> textColor{ 1.0f, 1.0f, 1.0f, 1.0f };
     mEngine->Draw(8, 16, textColor, mCaption[mType]);
     mEngine->Draw(8, mYSize - 8, textColor, mTimer.GetFPS());
-    mEngine->DisplayColorBuffer(0);
+    mBenchmark.End();
+    mBenchmark.Present(mEngine);
 
     mTimer.UpdateFrameCount();
 }
 
+bool LightsWindow3::RunBenchmark(unsigned int numFrames, std::string const& output)
+{
+    // UpdateConstants uploads through the effects; the PVW matrices
+    // upload through this updater.
+    mPVWMatrices.Set(mCamera, [this](std::shared_ptr<Buffer> const& buffer)
+    {
+        mBenchmark.Begin(FrameBenchmark::CONSTANT_UPLOAD);
+        mEngine->Update(buffer);
+        mBenchmark.End();
+    });
+
+    // Circle the origin at the distance of the initial camera.
+    mBenchmark.Start(numFrames, mXSize, mYSize, { 0.0f, 0.0f, 0.0f, 1.0f }, 17.5f, 4.0f);
+    while (mBenchmark.IsRunning())
+    {
+        OnIdle();
+    }
+
+    mPVWMatrices.Set(mCamera, mUpdater);
+    return mBenchmark.Save(output, "Lights");
+}
+
 bool LightsWindow3::OnCharPress(unsigned char key, int x, int y)
 {
     switch (key)
@@ -191,6 +240,8 @@ bool LightsWindow3::OnCharPress(unsigned char key, int x, int y)
 
 void LightsWindow3::CreateScene()
 {
+    GTE_PROFILE_SCOPE("CreateScene");
+
     // Copper color for the planes.
     Vector4<float> planeAmbient{ 0.2295f, 0.08825f, 0.0275f, 1.0f };
     Vector4<float> planeDiffuse{ 0.5508f, 0.2118f, 0.066f, 1.0f };
@@ -266,45 +317,112 @@ void LightsWindow3::CreateScene()
     // constant buffers are shared by the vertex and pixel shaders.  This
     // is important to remember when processing keystroked; see the comments
     // in OnCharPress.
-    for (int gt = 0; gt < GNUM; ++gt)
     {
-        for (int st = 0; st < SNUM; ++st)
+        GTE_PROFILE_SCOPE("CreateEffects");
+        for (int gt = 0; gt < GNUM; ++gt)
         {
-            mEffect[LDIR][gt][st] = std::make_shared<DirectionalLightEffect>(
-                mProgramFactory, mUpdater, st,
-                material[LDIR][gt], lighting[LDIR][gt], geometry[LDIR][gt]);
+            for (int st = 0; st < SNUM; ++st)
+            {
+                mEffect[LDIR][gt][st] = std::make_shared<DirectionalLightEffect>(
+                    mProgramFactory, mUpdater, st,
+                    material[LDIR][gt], lighting[LDIR][gt], geometry[LDIR][gt]);
 
-            mEffect[LPNT][gt][st] = std::make_shared<PointLightEffect>(
-                mProgramFactory, mUpdater, st,
-                material[LPNT][gt], lighting[LPNT][gt], geometry[LPNT][gt]);
+                mEffect[LPNT][gt][st] = std::make_shared<PointLightEffect>(
+                    mProgramFactory, mUpdater, st,
+                    material[LPNT][gt], lighting[LPNT][gt], geometry[LPNT][gt]);
 
-            mEffect[LSPT][gt][st] = std::make_shared<SpotLightEffect>(
-                mProgramFactory, mUpdater, st,
-                material[LSPT][gt], lighting[LSPT][gt], geometry[LSPT][gt]);
+                mEffect[LSPT][gt][st] = std::make_shared<SpotLightEffect>(
+                    mProgramFactory, mUpdater, st,
+                    material[LSPT][gt], lighting[LSPT][gt], geometry[LSPT][gt]);
+            }
         }
     }
 
-    // Create the planes and spheres.
-    VertexFormat vformat;
-    vformat.Bind(VA_POSITION, DF_R32G32B32_FLOAT, 0);
-    vformat.Bind(VA_NORMAL, DF_R32G32B32_FLOAT, 0);
-    MeshFactory mf;
-    mf.SetVertexFormat(vformat);
+    // Create the planes and spheres and the coarser levels of the spheres.
+    // Tessellating them dominates the startup time, so the meshes are saved
+    // to a scene cache on the first run and mapped from it on later runs.
+    // The tag describes the meshes; change it with the MeshFactory
+    // parameters.
+    std::string const cacheFile = "Lights.gtsc";
+    std::string const cacheTag = "Lights rectangle 128x128 8x8, sphere 64x64 2, "
+        "level chain 32x32 16x16, position normal";
+    std::string const effectName[4] = { "Plane", "Plane", "Sphere", "Sphere" };
+    std::shared_ptr<Visual> cached[4];
+    int numCached = 0;
+    std::shared_ptr<Node> cache;
+    SceneCache::Chains levels;
+    {
+        GTE_PROFILE_SCOPE("SceneCache::Load");
+        cache = mSceneCache.Load(cacheFile, cacheTag,
+            [&](std::shared_ptr<Visual> const& visual, std::string const& effect)
+            {
+                if (numCached == 4 || effect != effectName[numCached])
+                {
+                    return false;
+                }
+                cached[numCached++] = visual;
+                return true;
+            }, &levels);
+    }
 
-    mPlane[SVTX] = mf.CreateRectangle(128, 128, 8.0f, 8.0f);
-    mPlane[SVTX]->localTransform.SetTranslation(0.0f, -8.0f, 0.0f);
-    mTrackBall.Attach(mPlane[SVTX]);
+    // The one chain of the cache holds the coarser levels of the spheres,
+    // which both spheres share.
+    if (cache && numCached == 4 && levels.size() == 1 && levels[0].size() == 2)
+    {
+        // The trackball attaches the meshes to its own root.
+        cache->DetachAllChildren();
+        mPlane[SVTX] = cached[0];
+        mPlane[SPXL] = cached[1];
+        mSphere[SVTX] = cached[2];
+        mSphere[SPXL] = cached[3];
+    }
+    else
+    {
+        GTE_PROFILE_SCOPE("CreateMeshes");
+        VertexFormat vformat;
+        vformat.Bind(VA_POSITION, DF_R32G32B32_FLOAT, 0);
+        vformat.Bind(VA_NORMAL, DF_R32G32B32_FLOAT, 0);
+        MeshFactory mf;
+        mf.SetVertexFormat(vformat);
+
+        mPlane[SVTX] = mf.CreateRectangle(128, 128, 8.0f, 8.0f);
+        mPlane[SVTX]->localTransform.SetTranslation(0.0f, -8.0f, 0.0f);
+
+        mPlane[SPXL] = mf.CreateRectangle(128, 128, 8.0f, 8.0f);
+        mPlane[SPXL]->localTransform.SetTranslation(0.0f, +8.0f, 0.0f);
+
+        mSphere[SVTX] = mf.CreateSphere(64, 64, 2.0f);
+        mSphere[SVTX]->localTransform.SetTranslation(0.0f, -8.0f, 2.0f);
+
+        mSphere[SPXL] = mf.CreateSphere(64, 64, 2.0f);
+        mSphere[SPXL]->localTransform.SetTranslation(0.0f, +8.0f, 2.0f);
+
+        levels = { { mf.CreateSphere(32, 32, 2.0f), mf.CreateSphere(16, 16, 2.0f) } };
+
+        auto scene = std::make_shared<Node>();
+        scene->AttachChild(mPlane[SVTX]);
+        scene->AttachChild(mPlane[SPXL]);
+        scene->AttachChild(mSphere[SVTX]);
+        scene->AttachChild(mSphere[SPXL]);
+        SceneCache::Save(cacheFile, cacheTag, scene,
+            [this](Visual const& visual)
+            {
+                return std::string(&visual == mPlane[SVTX].get()
+                    || &visual == mPlane[SPXL].get() ? "Plane" : "Sphere");
+            }, levels);
+        scene->DetachAllChildren();
+    }
 
-    mPlane[SPXL] = mf.CreateRectangle(128, 128, 8.0f, 8.0f);
-    mPlane[SPXL]->localTransform.SetTranslation(0.0f, +8.0f, 0.0f);
-    mTrackBall.Attach(mPlane[SPXL]);
+    int chain = mLOD.AddChain({ mSphere[SVTX], levels[0][0], levels[0][1] });
+    mLOD.Add(mSphere[SVTX].get(), chain);
+    mLOD.Add(mSphere[SPXL].get(), chain);
+    mLODVisuals = { mSphere[SVTX].get(), mSphere[SPXL].get() };
 
-    mSphere[SVTX] = mf.CreateSphere(64, 64, 2.0f);
-    mSphere[SVTX]->localTransform.SetTranslation(0.0f, -8.0f, 2.0f);
-    mTrackBall.Attach(mSphere[SVTX]);
+    mDrawList = { mPlane[SVTX].get(), mPlane[SPXL].get(), mSphere[SVTX].get(), mSphere[SPXL].get() };
 
-    mSphere[SPXL] = mf.CreateSphere(64, 64, 2.0f);
-    mSphere[SPXL]->localTransform.SetTranslation(0.0f, +8.0f, 2.0f);
+    mTrackBall.Attach(mPlane[SVTX]);
+    mTrackBall.Attach(mPlane[SPXL]);
+    mTrackBall.Attach(mSphere[SVTX]);
     mTrackBall.Attach(mSphere[SPXL]);
 
     mTrackBall.Update();
@@ -341,6 +459,8 @@ void LightsWindow3::UseLightType(int type)
 
 void LightsWindow3::UpdateConstants()
 {
+    GTE_PROFILE_SCOPE("UpdateConstants");
+
     // The pvw-matrices are updated automatically whenever the camera moves
     // or the trackball is rotated, which happens before this call.  Here we
     // need to update the camera model position, light model position, and
@@ -356,14 +476,18 @@ void LightsWindow3::UpdateConstants()
 
     // Compute the world-to-model transforms for the planes and spheres.
     Matrix4x4<float> invWMatrix[GNUM][SNUM];
-    for (int gt = 0; gt < GNUM; ++gt)
     {
-        for (int st = 0; st < SNUM; ++st)
+        GTE_PROFILE_SCOPE("InverseWorldMatrices");
+        for (int gt = 0; gt < GNUM; ++gt)
         {
-            invWMatrix[gt][st] = Inverse(wMatrix[gt][st]);
+            for (int st = 0; st < SNUM; ++st)
+            {
+                invWMatrix[gt][st] = Inverse(wMatrix[gt][st]);
+            }
         }
     }
 
+    GTE_PROFILE_SCOPE("GeometryConstants");
     Vector4<float> cameraWorldPosition = mCamera->GetPosition();
     for (int lt = 0; lt < LNUM; ++lt)
     {
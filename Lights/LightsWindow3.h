@@ -9,6 +9,10 @@
 
 #include <Applications/Window3.h>
 #include <Graphics/LightEffect.h>
+#include "DrawQueue.h"
+#include "FrameBenchmark.h"
+#include "LODSelector.h"
+#include "SceneCache.h"
 using namespace gte;
 
 class LightsWindow3 : public Window3
@@ -19,18 +23,34 @@ public:
     virtual void OnIdle() override;
     virtual bool OnCharPress(unsigned char key, int x, int y) override;
 
+    // Draw numFrames frames offscreen along a fixed camera path and write
+    // the frame times to 'output'.
+    bool RunBenchmark(unsigned int numFrames, std::string const& output);
+
 private:
     void CreateScene();
     void UseLightType(int type);
     void UpdateConstants();
 
     std::shared_ptr<RasterizerState> mWireState;
+    FrameBenchmark mBenchmark;
 
     enum { LDIR, LPNT, LSPT, LNUM };
     enum { GPLN, GSPH, GNUM };
     enum { SVTX, SPXL, SNUM };
     std::shared_ptr<LightEffect> mEffect[LNUM][GNUM][SNUM];
+    SceneCache mSceneCache;
     std::shared_ptr<Visual> mPlane[SNUM], mSphere[SNUM];
+
+    // The spheres draw a 64x64, 32x32 or 16x16 tessellation, depending on
+    // their size on screen.
+    LODSelector mLOD;
+    VisibleSet mLODVisuals;
+
+    // Each light type and shading mode has its own LightEffect program;
+    // the queue orders the draws by program and buffers.
+    DrawQueue mDrawQueue;
+    VisibleSet mDrawList;
     Vector4<float> mLightWorldPosition[2], mLightWorldDirection;
     std::string mCaption[LNUM];
     int mType;
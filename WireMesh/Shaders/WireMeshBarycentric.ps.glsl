@@ -0,0 +1,34 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+uniform WireParameters
+{
+    vec4 meshColor;
+    vec4 edgeColor;
+    vec2 windowSize;
+};
+
+layout(location = 0) in vec4 pixelColor;
+layout(location = 1) noperspective in vec3 barycentric;
+layout(location = 0) out vec4 finalColor;
+
+void main()
+{
+    // Interpolated without perspective, a barycentric coordinate is an
+    // affine function of the window position that vanishes on the opposite
+    // edge.  Divided by the length of its gradient it is the distance in
+    // pixels to that edge, which is what the WireMesh geometry shader
+    // computes per corner.
+    vec3 dx = dFdx(barycentric);
+    vec3 dy = dFdy(barycentric);
+    vec3 edgeDistance = barycentric / sqrt(dx * dx + dy * dy);
+
+    float dmin = min(min(edgeDistance[0], edgeDistance[1]), edgeDistance[2]);
+    float blend = smoothstep(0.0f, 1.0f, dmin);
+    finalColor = mix(edgeColor, pixelColor, blend);
+    finalColor.a = dmin;
+}
@@ -0,0 +1,45 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+cbuffer WireParameters
+{
+    float4 meshColor;
+    float4 edgeColor;
+    float2 windowSize;
+};
+
+struct PS_INPUT
+{
+    float4 vertexColor : COLOR0;
+    noperspective float3 barycentric : TEXCOORD0;
+    float4 clipPosition : SV_POSITION;
+};
+
+struct PS_OUTPUT
+{
+    float4 pixelColor : SV_TARGET0;
+};
+
+PS_OUTPUT PSMain(PS_INPUT input)
+{
+    // Interpolated without perspective, a barycentric coordinate is an
+    // affine function of the window position that vanishes on the opposite
+    // edge.  Divided by the length of its gradient it is the distance in
+    // pixels to that edge, which is what the WireMesh geometry shader
+    // computes per corner.
+    float3 dx = ddx(input.barycentric);
+    float3 dy = ddy(input.barycentric);
+    float3 edgeDistance = input.barycentric / sqrt(dx * dx + dy * dy);
+
+    PS_OUTPUT output;
+    float dmin = min(edgeDistance[0], edgeDistance[1]);
+    dmin = min(dmin, edgeDistance[2]);
+    float blend = smoothstep(0.0f, 1.0f, dmin);
+    output.pixelColor = lerp(edgeColor, input.vertexColor, blend);
+    output.pixelColor.a = dmin;
+    return output;
+}
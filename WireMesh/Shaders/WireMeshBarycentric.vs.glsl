@@ -0,0 +1,37 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+uniform WireParameters
+{
+    vec4 meshColor;
+    vec4 edgeColor;
+    vec2 windowSize;
+};
+
+uniform PVWMatrix
+{
+    mat4 pvwMatrix;
+};
+
+// The mesh is drawn without indices, one vertex per triangle corner, so
+// vertex i is corner i % 3 of its triangle.
+layout(location = 0) in vec3 modelPosition;
+layout(location = 0) out vec4 vertexColor;
+layout(location = 1) noperspective out vec3 barycentric;
+
+void main()
+{
+#if GTE_USE_MAT_VEC
+    gl_Position = pvwMatrix * vec4(modelPosition, 1.0f);
+#else
+    gl_Position = vec4(modelPosition, 1.0f) * pvwMatrix;
+#endif
+    vertexColor = meshColor;
+
+    int corner = gl_VertexID % 3;
+    barycentric = vec3(corner == 0, corner == 1, corner == 2);
+}
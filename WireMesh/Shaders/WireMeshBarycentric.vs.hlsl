@@ -0,0 +1,47 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+cbuffer WireParameters
+{
+    float4 meshColor;
+    float4 edgeColor;
+    float2 windowSize;
+};
+
+cbuffer PVWMatrix
+{
+    float4x4 pvwMatrix;
+};
+
+struct VS_INPUT
+{
+    float3 modelPosition : POSITION;
+};
+
+struct VS_OUTPUT
+{
+    float4 vertexColor : COLOR0;
+    noperspective float3 barycentric : TEXCOORD0;
+    float4 clipPosition : SV_POSITION;
+};
+
+// The mesh is drawn without indices, one vertex per triangle corner, so
+// vertex i is corner i % 3 of its triangle.
+VS_OUTPUT VSMain(VS_INPUT input, uint vertexID : SV_VertexID)
+{
+    VS_OUTPUT output;
+#if GTE_USE_MAT_VEC
+    output.clipPosition = mul(pvwMatrix, float4(input.modelPosition, 1.0f));
+#else
+    output.clipPosition = mul(float4(input.modelPosition, 1.0f), pvwMatrix);
+#endif
+    output.vertexColor = meshColor;
+
+    uint corner = vertexID % 3;
+    output.barycentric = float3(corner == 0, corner == 1, corner == 2);
+    return output;
+}
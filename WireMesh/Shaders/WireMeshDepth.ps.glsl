@@ -0,0 +1,14 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+// The prepass writes depth only; the color writes are masked off.
+layout(location = 0) out vec4 finalColor;
+
+void main()
+{
+    finalColor = vec4(0.0f);
+}
@@ -0,0 +1,24 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+struct PS_INPUT
+{
+    float4 clipPosition : SV_POSITION;
+};
+
+struct PS_OUTPUT
+{
+    float4 pixelColor : SV_TARGET0;
+};
+
+// The prepass writes depth only; the color writes are masked off.
+PS_OUTPUT PSMain(PS_INPUT input)
+{
+    PS_OUTPUT output;
+    output.pixelColor = float4(0.0f, 0.0f, 0.0f, 0.0f);
+    return output;
+}
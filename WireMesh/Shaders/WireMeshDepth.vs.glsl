@@ -0,0 +1,24 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+uniform PVWMatrix
+{
+    mat4 pvwMatrix;
+};
+
+// The position is computed as in WireMesh.vs, so the depth of the prepass
+// equals the depth of the wireframe pass.
+layout(location = 0) in vec3 modelPosition;
+
+void main()
+{
+#if GTE_USE_MAT_VEC
+    gl_Position = pvwMatrix * vec4(modelPosition, 1.0f);
+#else
+    gl_Position = vec4(modelPosition, 1.0f) * pvwMatrix;
+#endif
+}
@@ -0,0 +1,34 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+cbuffer PVWMatrix
+{
+    float4x4 pvwMatrix;
+};
+
+struct VS_INPUT
+{
+    float3 modelPosition : POSITION;
+};
+
+struct VS_OUTPUT
+{
+    float4 clipPosition : SV_POSITION;
+};
+
+// The position is computed as in WireMesh.vs, so the depth of the prepass
+// equals the depth of the wireframe pass.
+VS_OUTPUT VSMain(VS_INPUT input)
+{
+    VS_OUTPUT output;
+#if GTE_USE_MAT_VEC
+    output.clipPosition = mul(pvwMatrix, float4(input.modelPosition, 1.0f));
+#else
+    output.clipPosition = mul(float4(input.modelPosition, 1.0f), pvwMatrix);
+#endif
+    return output;
+}
@@ -0,0 +1,61 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+uniform WireParameters
+{
+    vec4 meshColor;
+    vec4 edgeColor;
+    vec2 windowSize;
+};
+
+uniform PVMatrix
+{
+    mat4 pvMatrix;
+};
+
+uniform InstanceParameters
+{
+    uint numIndices;
+};
+
+// The mesh is shared by all instances.  Vertex i of instance k is the
+// vertex Indices[i] of the mesh transformed by WorldMatrices[k], so one
+// draw of numInstances * numIndices vertices renders every instance.
+layout(std430) buffer Positions
+{
+    vec4 position[];
+};
+
+layout(std430) buffer Indices
+{
+    uint index[];
+};
+
+#if GTE_USE_ROW_MAJOR
+layout(std430, row_major) buffer WorldMatrices
+#else
+layout(std430, column_major) buffer WorldMatrices
+#endif
+{
+    mat4 worldMatrix[];
+};
+
+layout(location = 0) out vec4 vertexColor;
+
+void main()
+{
+    uint vertexID = uint(gl_VertexID);
+    uint instance = vertexID / numIndices;
+    uint i = index[vertexID - instance * numIndices];
+    vec4 modelPosition = vec4(position[i].xyz, 1.0f);
+#if GTE_USE_MAT_VEC
+    gl_Position = pvMatrix * (worldMatrix[instance] * modelPosition);
+#else
+    gl_Position = (modelPosition * worldMatrix[instance]) * pvMatrix;
+#endif
+    vertexColor = meshColor;
+}
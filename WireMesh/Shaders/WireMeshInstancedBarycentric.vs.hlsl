@@ -0,0 +1,59 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+cbuffer WireParameters
+{
+    float4 meshColor;
+    float4 edgeColor;
+    float2 windowSize;
+};
+
+cbuffer PVMatrix
+{
+    float4x4 pvMatrix;
+};
+
+cbuffer InstanceParameters
+{
+    uint numIndices;
+};
+
+// The mesh is shared by all instances.  Vertex i of instance k is the
+// vertex Indices[i] of the mesh transformed by WorldMatrices[k], so one
+// draw of numInstances * numIndices vertices renders every instance.
+// numIndices is a multiple of 3, so vertex i is corner i % 3 of its
+// triangle.
+StructuredBuffer<float4> Positions;
+StructuredBuffer<uint> Indices;
+StructuredBuffer<float4x4> WorldMatrices;
+
+struct VS_OUTPUT
+{
+    float4 vertexColor : COLOR0;
+    noperspective float3 barycentric : TEXCOORD0;
+    float4 clipPosition : SV_POSITION;
+};
+
+VS_OUTPUT VSMain(uint vertexID : SV_VertexID)
+{
+    VS_OUTPUT output;
+    uint instance = vertexID / numIndices;
+    uint index = Indices[vertexID - instance * numIndices];
+    float4 modelPosition = float4(Positions[index].xyz, 1.0f);
+#if GTE_USE_MAT_VEC
+    float4 worldPosition = mul(WorldMatrices[instance], modelPosition);
+    output.clipPosition = mul(pvMatrix, worldPosition);
+#else
+    float4 worldPosition = mul(modelPosition, WorldMatrices[instance]);
+    output.clipPosition = mul(worldPosition, pvMatrix);
+#endif
+    output.vertexColor = meshColor;
+
+    uint corner = vertexID % 3;
+    output.barycentric = float3(corner == 0, corner == 1, corner == 2);
+    return output;
+}
@@ -0,0 +1,49 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+uniform WireParameters
+{
+    vec4 meshColor;
+    vec4 edgeColor;
+    vec2 windowSize;
+};
+
+// The PVW matrices of all visuals are in one ring buffer.  A visual's
+// PVWMatrix constant holds the slot of its matrix, and RingFrame the first
+// slot of the region written for the current frame.
+uniform PVWMatrix
+{
+    uint pvwMatrixSlot;
+};
+
+uniform RingFrame
+{
+    uint frameBase;
+};
+
+#if GTE_USE_ROW_MAJOR
+layout(std430, row_major) buffer PVWMatrices
+#else
+layout(std430, column_major) buffer PVWMatrices
+#endif
+{
+    mat4 pvwMatrix[];
+};
+
+layout(location = 0) in vec3 modelPosition;
+layout(location = 0) out vec4 vertexColor;
+
+void main()
+{
+    mat4 pvw = pvwMatrix[frameBase + pvwMatrixSlot];
+#if GTE_USE_MAT_VEC
+    gl_Position = pvw * vec4(modelPosition, 1.0f);
+#else
+    gl_Position = vec4(modelPosition, 1.0f) * pvw;
+#endif
+    vertexColor = meshColor;
+}
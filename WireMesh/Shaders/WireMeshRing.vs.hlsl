@@ -0,0 +1,52 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+cbuffer WireParameters
+{
+    float4 meshColor;
+    float4 edgeColor;
+    float2 windowSize;
+};
+
+// The PVW matrices of all visuals are in one ring buffer.  A visual's
+// PVWMatrix constant holds the slot of its matrix, and RingFrame the first
+// slot of the region written for the current frame.
+cbuffer PVWMatrix
+{
+    uint pvwMatrixSlot;
+};
+
+cbuffer RingFrame
+{
+    uint frameBase;
+};
+
+StructuredBuffer<float4x4> PVWMatrices;
+
+struct VS_INPUT
+{
+    float3 modelPosition : POSITION;
+};
+
+struct VS_OUTPUT
+{
+    float4 vertexColor : COLOR0;
+    float4 clipPosition : SV_POSITION;
+};
+
+VS_OUTPUT VSMain(VS_INPUT input)
+{
+    VS_OUTPUT output;
+    float4x4 pvwMatrix = PVWMatrices[frameBase + pvwMatrixSlot];
+#if GTE_USE_MAT_VEC
+    output.clipPosition = mul(pvwMatrix, float4(input.modelPosition, 1.0f));
+#else
+    output.clipPosition = mul(float4(input.modelPosition, 1.0f), pvwMatrix);
+#endif
+    output.vertexColor = meshColor;
+    return output;
+}
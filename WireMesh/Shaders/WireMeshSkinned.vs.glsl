@@ -0,0 +1,58 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+uniform WireParameters
+{
+    vec4 meshColor;
+    vec4 edgeColor;
+    vec2 windowSize;
+};
+
+uniform PVWMatrix
+{
+    mat4 pvwMatrix;
+};
+
+// The joint palette of the visual, which maps its bind pose to its model
+// space.  A vertex blends up to four palette entries; an index past the
+// end of the palette is clamped to its last entry.
+#if GTE_USE_ROW_MAJOR
+layout(std430, row_major) buffer JointPalette
+#else
+layout(std430, column_major) buffer JointPalette
+#endif
+{
+    mat4 jointMatrix[];
+};
+
+layout(location = 0) in vec3 modelPosition;
+layout(location = 1) in vec4 modelJoints;
+layout(location = 2) in vec4 modelWeights;
+layout(location = 0) out vec4 vertexColor;
+
+void main()
+{
+    vec4 bindPosition = vec4(modelPosition, 1.0f);
+    vec4 skinnedPosition = vec4(0.0f);
+    int lastJoint = jointMatrix.length() - 1;
+    for (int i = 0; i < 4; ++i)
+    {
+        mat4 joint = jointMatrix[clamp(int(modelJoints[i]), 0, lastJoint)];
+#if GTE_USE_MAT_VEC
+        skinnedPosition += modelWeights[i] * (joint * bindPosition);
+#else
+        skinnedPosition += modelWeights[i] * (bindPosition * joint);
+#endif
+    }
+
+#if GTE_USE_MAT_VEC
+    gl_Position = pvwMatrix * skinnedPosition;
+#else
+    gl_Position = skinnedPosition * pvwMatrix;
+#endif
+    vertexColor = meshColor;
+}
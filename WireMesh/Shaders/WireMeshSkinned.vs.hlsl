@@ -0,0 +1,63 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2019
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 4.0.2019.08.13
+
+cbuffer WireParameters
+{
+    float4 meshColor;
+    float4 edgeColor;
+    float2 windowSize;
+};
+
+cbuffer PVWMatrix
+{
+    float4x4 pvwMatrix;
+};
+
+// The joint palette of the visual, which maps its bind pose to its model
+// space.  A vertex blends up to four palette entries; an index past the
+// end of the palette is clamped to its last entry.
+StructuredBuffer<float4x4> JointPalette;
+
+struct VS_INPUT
+{
+    float3 modelPosition : POSITION;
+    float4 modelJoints : BLENDINDICES;
+    float4 modelWeights : BLENDWEIGHT;
+};
+
+struct VS_OUTPUT
+{
+    float4 vertexColor : COLOR0;
+    float4 clipPosition : SV_POSITION;
+};
+
+VS_OUTPUT VSMain(VS_INPUT input)
+{
+    VS_OUTPUT output;
+    float4 bindPosition = float4(input.modelPosition, 1.0f);
+    float4 skinnedPosition = float4(0.0f, 0.0f, 0.0f, 0.0f);
+    uint numJoints, stride;
+    JointPalette.GetDimensions(numJoints, stride);
+    [unroll]
+    for (int i = 0; i < 4; ++i)
+    {
+        float4x4 joint = JointPalette[min((uint)input.modelJoints[i], numJoints - 1)];
+#if GTE_USE_MAT_VEC
+        skinnedPosition += input.modelWeights[i] * mul(joint, bindPosition);
+#else
+        skinnedPosition += input.modelWeights[i] * mul(bindPosition, joint);
+#endif
+    }
+
+#if GTE_USE_MAT_VEC
+    output.clipPosition = mul(pvwMatrix, skinnedPosition);
+#else
+    output.clipPosition = mul(skinnedPosition, pvwMatrix);
+#endif
+    output.vertexColor = meshColor;
+    return output;
+}
@@ -6,9 +6,11 @@
 // Version: 4.0.2019.08.13
 
 #include "WireMeshWindow3.h"
+#include "Profiler.h"
 #include <Applications/LogReporter.h>
+#include <algorithm>
 
-int main(int, char const*[])
+int main(int argc, char const* argv[])
 {
 #if defined(_DEBUG)
     LogReporter reporter(
@@ -19,9 +21,50 @@ int main(int, char const*[])
         Logger::Listener::LISTEN_FOR_ALL);
 #endif
 
+    // --benchmark <frames> [--output <file>] draws offscreen without
+    // showing the window and exits.  --trace <file> records the profiled
+    // scopes of all threads and writes them when the sample exits.
+    // --barycentric starts with the wireframe that needs no geometry
+    // shader, and --depth-prepass with the depth prepass.
+    FrameBenchmark::Options options;
+    if (!FrameBenchmark::ParseCommandLine(argc, argv, options))
+    {
+        return 1;
+    }
+    if (!options.trace.empty())
+    {
+        Profiler::Enable(true);
+        Profiler::SetThreadName("Main");
+    }
+
     Window::Parameters parameters(L"WireMeshWindow3", 0, 0, 512, 512);
     auto window = TheWindowSystem.Create<WireMeshWindow3>(parameters);
-    TheWindowSystem.MessagePump(window, TheWindowSystem.DEFAULT_ACTION);
+    bool saved = true;
+    if (window && std::find(options.arguments.begin(), options.arguments.end(),
+        "--barycentric") != options.arguments.end())
+    {
+        window->UseBarycentricWire(true);
+    }
+    if (window && std::find(options.arguments.begin(), options.arguments.end(),
+        "--depth-prepass") != options.arguments.end())
+    {
+        window->UseDepthPrepass(true);
+    }
+    if (window && options.numFrames > 0)
+    {
+        saved = window->RunBenchmark(options.numFrames, options.output);
+    }
+    else
+    {
+        TheWindowSystem.MessagePump(window, TheWindowSystem.DEFAULT_ACTION);
+    }
     TheWindowSystem.Destroy(window);
-    return 0;
+
+    // The window's worker threads have been joined, so the trace is
+    // complete.
+    if (!options.trace.empty())
+    {
+        saved = Profiler::SaveChromeTrace(options.trace) && saved;
+    }
+    return saved ? 0 : 1;
 }
@@ -7,11 +7,23 @@
 
 #include <iostream>
 #include "WireMeshWindow3.h"
+#include "Profiler.h"
 #include <Graphics/MeshFactory.h>
 
+// The repository's shaders, which include some that are not part of the
+// engine samples.
+#if !defined(WIREMESH_SHADERS_PATH)
+#define WIREMESH_SHADERS_PATH "Shaders/"
+#endif
+
 WireMeshWindow3::WireMeshWindow3(Parameters& parameters)
     :
-    Window3(parameters)
+    Window3(parameters),
+    mUseParallelCuller(false),
+    mLOD(8.0f),
+    mUseBarycentric(false),
+    mDrawQueue(DrawQueue::FRONT_TO_BACK),
+    mUseDepthPrepass(false)
 {
 
     if (!SetEnvironment() || !CreateScene())
@@ -27,28 +39,52 @@ WireMeshWindow3::WireMeshWindow3(Parameters& parameters)
         { 0.0f, 0.0f, -2.5f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f, 0.0f });
     mPVWMatrices.Update();
 
-    mCuller.ComputeVisibleSet(mCamera, mScene);
+    ComputeVisibleSet();
 }
 
 void WireMeshWindow3::OnIdle()
 {
+    GTE_PROFILE_SCOPE("OnIdle");
     mTimer.Measure();
+    mBenchmark.BeginFrame(mEngine);
 
-    if (mCameraRig.Move())
+    if (mBenchmark.MoveCamera(*mCamera) || mCameraRig.Move())
     {
+        mBenchmark.Begin(FrameBenchmark::PVW_UPDATE);
         mPVWMatrices.Update();
-        mCuller.ComputeVisibleSet(mCamera, mScene);
+        mBenchmark.End();
+
+        mBenchmark.Begin(FrameBenchmark::CULL);
+        ComputeVisibleSet();
+        mBenchmark.End();
     }
 
-    mEngine->ClearBuffers();
+    {
+        GTE_PROFILE_SCOPE("ClearBuffers");
+        mEngine->ClearBuffers();
+    }
 
-    for (auto const& visual : mCuller.GetVisibleSet())
+    mBenchmark.Begin(FrameBenchmark::DRAW_SUBMISSION);
+    VisibleSet const& visuals = mDrawQueue.GetVisuals();
+    if (mUseDepthPrepass)
     {
-      mEngine->Draw(visual);
+        mDepthPrepass->Begin(mEngine, visuals);
+    }
+    for (auto const& visual : visuals)
+    {
+        if (!mUseBarycentric || !mBarycentric->Draw(mEngine, visual))
+        {
+            mEngine->Draw(visual);
+        }
+    }
+    if (mUseDepthPrepass)
+    {
+        mDepthPrepass->End(mEngine);
     }
 
     mEngine->Draw(8, mYSize - 8, { 1.0f, 1.0f, 1.0f, 1.0 }, mTimer.GetFPS());
-    mEngine->DisplayColorBuffer(0);
+    mBenchmark.End();
+    mBenchmark.Present(mEngine);
 
     mTimer.UpdateFrameCount();
 }
@@ -57,11 +93,91 @@ bool WireMeshWindow3::OnResize(int xSize, int ySize)
 {
     if (Window3::OnResize(xSize, ySize))
     {
-        mCuller.ComputeVisibleSet(mCamera, mScene);
+        ComputeVisibleSet();
     }
     return true;
 }
 
+bool WireMeshWindow3::RunBenchmark(unsigned int numFrames, std::string const& output)
+{
+    // The PVW updater uploads the constant buffers; timing its buffer
+    // updater separates the uploads from the matrix products.
+    mPVWMatrices.Set(mCamera, [this](std::shared_ptr<Buffer> const& buffer)
+    {
+        mBenchmark.Begin(FrameBenchmark::CONSTANT_UPLOAD);
+        mEngine->Update(buffer);
+        mBenchmark.End();
+    });
+
+    // Circle the sphere at the distance of the initial camera.
+    mBenchmark.Start(numFrames, mXSize, mYSize, { 0.0f, 0.0f, 5.0f, 1.0f }, 7.5f, 1.0f);
+    while (mBenchmark.IsRunning())
+    {
+        OnIdle();
+    }
+
+    mPVWMatrices.Set(mCamera, mUpdater);
+    std::string name = "WireMesh";
+    if (mUseBarycentric)
+    {
+        name += " barycentric";
+    }
+    if (mUseDepthPrepass)
+    {
+        name += " depth prepass";
+    }
+    return mBenchmark.Save(output, name);
+}
+
+bool WireMeshWindow3::OnCharPress(unsigned char key, int x, int y)
+{
+    switch (key)
+    {
+    case 'c':  // toggle between the BVH culler and the parallel culler
+    case 'C':
+        mUseParallelCuller = !mUseParallelCuller;
+        ComputeVisibleSet();
+        return true;
+
+    case 'g':  // toggle between the geometry shader and barycentric wireframes
+    case 'G':
+        mUseBarycentric = !mUseBarycentric;
+        return true;
+
+    case 'z':  // toggle the depth prepass
+    case 'Z':
+        mUseDepthPrepass = !mUseDepthPrepass;
+        return true;
+    }
+    return Window3::OnCharPress(key, x, y);
+}
+
+void WireMeshWindow3::ComputeVisibleSet()
+{
+    if (mUseParallelCuller)
+    {
+        mParallelCuller.ComputeVisibleSet(mCamera, mScene);
+    }
+    else
+    {
+        mCuller.ComputeVisibleSet(mCamera, mScene);
+    }
+
+    {
+        GTE_PROFILE_SCOPE("SelectLOD");
+        mLOD.Select(mCamera, mYSize, GetVisibleSet());
+    }
+
+    // The levels change the buffers, so the draws are sorted after them.
+    GTE_PROFILE_SCOPE("SortDraws");
+    mDrawQueue.Sort(mCamera, GetVisibleSet());
+}
+
+VisibleSet const& WireMeshWindow3::GetVisibleSet()
+{
+    return mUseParallelCuller ? mParallelCuller.GetVisibleSet() : mCuller.GetVisibleSet();
+}
+
 bool WireMeshWindow3::SetEnvironment()
 {
     std::string path = GetGTEPath();
@@ -71,12 +187,17 @@ bool WireMeshWindow3::SetEnvironment()
     }
 
     mEnvironment.Insert(path + "/Samples/Graphics/WireMesh/Shaders/");
+    mEnvironment.Insert(WIREMESH_SHADERS_PATH);
 
     std::vector<std::string> inputs =
     {
         mEngine->GetShaderName("WireMesh.vs"),
         mEngine->GetShaderName("WireMesh.ps"),
-        mEngine->GetShaderName("WireMesh.gs")
+        mEngine->GetShaderName("WireMesh.gs"),
+        mEngine->GetShaderName("WireMeshBarycentric.vs"),
+        mEngine->GetShaderName("WireMeshBarycentric.ps"),
+        mEngine->GetShaderName("WireMeshDepth.vs"),
+        mEngine->GetShaderName("WireMeshDepth.ps")
     };
 
     for (auto const& input : inputs)
@@ -93,13 +214,18 @@ bool WireMeshWindow3::SetEnvironment()
 
 bool WireMeshWindow3::CreateScene()
 {
+    GTE_PROFILE_SCOPE("CreateScene");
     mScene = std::make_shared<Node>();
 
     std::string vsPath = mEnvironment.GetPath(mEngine->GetShaderName("WireMesh.vs"));
     std::string psPath = mEnvironment.GetPath(mEngine->GetShaderName("WireMesh.ps"));
     std::string gsPath = mEnvironment.GetPath(mEngine->GetShaderName("WireMesh.gs"));
 
-    auto program = mProgramFactory->CreateFromFiles(vsPath, psPath, gsPath);
+    std::shared_ptr<VisualProgram> program;
+    {
+        GTE_PROFILE_SCOPE("CreateProgram");
+        program = mProgramFactory->CreateFromFiles(vsPath, psPath, gsPath);
+    }
     if (!program)
     {
         return false;
@@ -114,6 +240,28 @@ bool WireMeshWindow3::CreateScene()
     program->GetPixelShader()->Set("WireParameters", parameters);
     program->GetGeometryShader()->Set("WireParameters", parameters);
 
+    // The barycentric wireframe has no geometry shader and shares the
+    // WireParameters buffer.
+    std::shared_ptr<VisualProgram> barycentricProgram = mProgramFactory->CreateFromFiles(
+        mEnvironment.GetPath(mEngine->GetShaderName("WireMeshBarycentric.vs")),
+        mEnvironment.GetPath(mEngine->GetShaderName("WireMeshBarycentric.ps")), "");
+    if (!barycentricProgram)
+    {
+        return false;
+    }
+    barycentricProgram->GetVertexShader()->Set("WireParameters", parameters);
+    barycentricProgram->GetPixelShader()->Set("WireParameters", parameters);
+    mBarycentric = std::make_unique<BarycentricWire>(barycentricProgram);
+
+    std::shared_ptr<VisualProgram> depthProgram = mProgramFactory->CreateFromFiles(
+        mEnvironment.GetPath(mEngine->GetShaderName("WireMeshDepth.vs")),
+        mEnvironment.GetPath(mEngine->GetShaderName("WireMeshDepth.ps")), "");
+    if (!depthProgram)
+    {
+        return false;
+    }
+    mDepthPrepass = std::make_unique<DepthPrepass>(depthProgram);
+
     auto cbuffer = std::make_shared<ConstantBuffer>(sizeof(Matrix4x4<float>), true);
     program->GetVertexShader()->Set("PVWMatrix", cbuffer);
 
@@ -123,8 +271,17 @@ bool WireMeshWindow3::CreateScene()
     vformat.Bind(VA_POSITION, DF_R32G32B32_FLOAT, 0);
     MeshFactory mf;
     mf.SetVertexFormat(vformat);
-    std::shared_ptr<Visual> mMesh = mf.CreateSphere(16, 16, 1.0f);
+    std::shared_ptr<Visual> mMesh;
+    {
+        GTE_PROFILE_SCOPE("CreateMesh");
+        mMesh = mf.CreateSphere(16, 16, 1.0f);
+    }
     mMesh->localTransform.SetTranslation(0.0, 0.0, 5.0);
+
+    // The 16x16 sphere the sample used to draw is the third level.
+    int chain = mLOD.AddChain({ mf.CreateSphere(64, 64, 1.0f), mf.CreateSphere(32, 32, 1.0f),
+        mMesh, mf.CreateSphere(8, 8, 1.0f) });
+    mLOD.Add(mMesh.get(), chain);
     mMesh->SetEffect(effect);
     mPVWMatrices.Subscribe(mMesh->worldTransform, cbuffer);
 
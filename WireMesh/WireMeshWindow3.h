@@ -8,6 +8,13 @@
 #pragma once
 
 #include <Applications/Window3.h>
+#include "BarycentricWire.h"
+#include "BVHCuller.h"
+#include "DepthPrepass.h"
+#include "DrawQueue.h"
+#include "FrameBenchmark.h"
+#include "LODSelector.h"
+#include "ParallelCuller.h"
 using namespace gte;
 
 class WireMeshWindow3 : public Window3
@@ -19,10 +26,47 @@ public:
 
     virtual bool OnResize(int xSize, int ySize) override;
 
-	//virtual bool OnCharPress(unsigned char key, int x, int y) override;
+    // The 'c' key toggles between BVH culling and parallel culling, the
+    // 'g' key between the geometry shader wireframe and the barycentric
+    // one, and the 'z' key the depth prepass.
+    virtual bool OnCharPress(unsigned char key, int x, int y) override;
+
+    inline void UseBarycentricWire(bool use)
+    {
+        mUseBarycentric = use;
+    }
+
+    inline void UseDepthPrepass(bool use)
+    {
+        mUseDepthPrepass = use;
+    }
+
+    // Draw numFrames frames offscreen along a fixed camera path and write
+    // the frame times to 'output'.
+    bool RunBenchmark(unsigned int numFrames, std::string const& output);
 
 private:
-    Culler mCuller;
+    BVHCuller mCuller;
+    ParallelCuller mParallelCuller;
+    bool mUseParallelCuller;
+    FrameBenchmark mBenchmark;
+
+    // The sphere draws the tessellation whose edges are about 8 pixels
+    // long on screen.
+    LODSelector mLOD;
+
+    std::unique_ptr<BarycentricWire> mBarycentric;
+    bool mUseBarycentric;
+
+    // The wireframe is opaque, so the visible set is drawn front to back.
+    // The prepass fills the depth buffer first, which shades each covered
+    // pixel once at the cost of drawing the geometry twice.
+    DrawQueue mDrawQueue;
+    std::unique_ptr<DepthPrepass> mDepthPrepass;
+    bool mUseDepthPrepass;
+
+    void ComputeVisibleSet();
+    VisibleSet const& GetVisibleSet();
 
     bool SetEnvironment();
     bool CreateScene();
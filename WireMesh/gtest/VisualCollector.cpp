@@ -0,0 +1,45 @@
+#include "VisualCollector.h"
+
+void VisualCollector::Reserve(size_t numVisuals, size_t stackDepth)
+{
+	mVisuals.reserve(numVisuals);
+	mStack.reserve(stackDepth);
+}
+
+void VisualCollector::Collect(std::shared_ptr<gte::Spatial> const& scene)
+{
+	// clear() keeps the capacity of both arrays, which is what makes the
+	// steady state allocation free.
+	mVisuals.clear();
+	mStack.clear();
+
+	if (!scene)
+	{
+		return;
+	}
+
+	mStack.push_back(scene.get());
+	while (!mStack.empty())
+	{
+		gte::Spatial* spatial = mStack.back();
+		mStack.pop_back();
+
+		if (auto visual = dynamic_cast<gte::Visual*>(spatial))
+		{
+			mVisuals.push_back(visual);
+		}
+		else if (auto node = dynamic_cast<gte::Node*>(spatial))
+		{
+			// Push in reverse so that the children are popped, and therefore
+			// drawn, in attachment order.  Detached slots are null.
+			for (int i = node->GetNumChildren() - 1; i >= 0; --i)
+			{
+				gte::Spatial* child = node->GetChild(i).get();
+				if (child)
+				{
+					mStack.push_back(child);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <Graphics/Node.h>
+#include <Graphics/Visual.h>
+#include <memory>
+#include <vector>
+
+// Gathers every Visual below a scene root into a flat array of raw
+// pointers.  The array and the traversal stack are members that are only
+// cleared between frames, so once they have grown to the size of the scene
+// a call to Collect does not touch the heap.  The scene graph owns the
+// visuals; the pointers are valid until the graph is modified.
+class VisualCollector
+{
+public:
+	VisualCollector() = default;
+
+	// Pre-size the internal arrays when the scene size is known up front.
+	void Reserve(size_t numVisuals, size_t stackDepth = 64);
+
+	// Reset the visual array and walk the tree below 'scene' depth first.
+	// Children are visited in their attachment order.
+	void Collect(std::shared_ptr<gte::Spatial> const& scene);
+
+	inline std::vector<gte::Visual*> const& GetVisuals() const
+	{
+		return mVisuals;
+	}
+
+	inline size_t GetNumVisuals() const
+	{
+		return mVisuals.size();
+	}
+
+private:
+	std::vector<gte::Visual*> mVisuals;
+	std::vector<gte::Spatial*> mStack;
+};
@@ -4,35 +4,32 @@
 #include <gtest/gtest.h>
 
 #include "MyWindow.h"
+#include "Profiler.h"
 
-#define SPHERE_COUNT 10
-#define TEST_CULL 1
-
-
-std::vector<std::shared_ptr<gte::Visual*>>* GetVisualsOfScene(const std::shared_ptr<gte::Node>& node)
-{
-	// TODO: try linked list because of the append function and might be faster than std::vector
-	std::vector<std::shared_ptr<gte::Visual*>>* visuals = new std::vector<std::shared_ptr<gte::Visual*>>();
-
-	for (int i = 0; i < node->GetNumChildren(); i++)
-	{
-		auto child = node->GetChild(i);
-		if (auto v = dynamic_cast<gte::Visual*>(child.get()))
-		{
-			std::shared_ptr<gte::Visual*> vp = std::make_shared<gte::Visual*>(v);
-			visuals->push_back(vp);
-		} else if (auto n = dynamic_cast<gte::Node*>(child.get()))
-		{
-			std::shared_ptr<gte::Node> np = std::make_shared<gte::Node>(*n);
-			std::vector<std::shared_ptr<gte::Visual*>>* t = GetVisualsOfScene(np);
-			visuals->insert(visuals->end(), t->begin(), t->end());
-		}
-	}
-
-	return visuals;
-}
+// The repository's shaders, which include some that are not part of the
+// engine samples.  The project defines the path; the fallback assumes the
+// working directory is the project directory.
+#if !defined(WIREMESH_SHADERS_PATH)
+#define WIREMESH_SHADERS_PATH "../Shaders/"
+#endif
 
-gtest::gtest(Parameters& parameters) : Window3(parameters)
+#define SPHERE_COUNT 10
+#define TEST_CULL 1		// 0: Culler, 1: draw everything, 2: BVHCuller, 3: ParallelCuller
+#define TEST_INSTANCING 1	// 0: one draw per visual, 1: one instanced draw per shared mesh
+#define SCENE_CACHE "gtest.gtsc"	// written on the first run, mapped on later runs
+#define TEST_TRACE 0		// 1: write the profiled scopes to gtest.trace.json on exit
+#define TEST_FLAT_HIERARCHY 1	// 0: Spatial::Update, 1: transforms and bounds propagated by FlatHierarchy
+#define TEST_LOD 1		// 0: fixed 16x16 tessellations, 1: spheres and tori pick a tessellation by screen size
+#define LOD_EDGE_PIXELS 8.0f	// the shortest mean edge length on screen of a selected level
+#define TEST_BARYCENTRIC 0	// 0: wire edges from the geometry shader, 1: from barycentric coordinates ('g' toggles)
+#define TEST_SORT 1		// 0: scene order, 1: DrawQueue order by program, buffers and depth, 2: front to back
+#define TEST_DEPTH_PREPASS 0	// 1: fill the depth buffer before shading, one draw per visual ('z' toggles)
+#define TEST_OCCLUSION 1	// 1: the spheres occlude, and visuals hidden behind them in a CPU depth pyramid are not drawn
+
+gtest::gtest(Parameters& parameters) : Window3(parameters), mEffects(mProgramFactory),
+	mUseBarycentric(TEST_BARYCENTRIC == 1), mLOD(LOD_EDGE_PIXELS),
+	mDrawQueue(TEST_SORT == 2 ? DrawQueue::FRONT_TO_BACK : DrawQueue::BY_STATE),
+	mUseDepthPrepass(TEST_DEPTH_PREPASS == 1)
 {
 	if (!SetEnvironment() || !CreateScene())
 	{
@@ -48,14 +45,23 @@ gtest::gtest(Parameters& parameters) : Window3(parameters)
 	mPVWMatrices.Update();
 
 	mCuller.ComputeVisibleSet(mCamera, mScene);
+	mBVHCuller.ComputeVisibleSet(mCamera, mScene);
+	mParallelCuller.ComputeVisibleSet(mCamera, mScene);
+	mCollector.Reserve(4 * SPHERE_COUNT);
 }
 
 void gtest::OnIdle()
 {
+	GTE_PROFILE_SCOPE("OnIdle");
 	mTimer.Measure();
 
+#if (TEST_FLAT_HIERARCHY == 1)
+	mHierarchy.Update();	// Returns at once while no local transform changes
+#endif
+
 	if (mCameraRig.Move())
 	{
+		GTE_PROFILE_SCOPE("PVWUpdateAndCull");
 		mPVWMatrices.Update();
 #if (TEST_CULL == 0)
 		mCuller.ComputeVisibleSet(mCamera, mScene);			// Built in cull
@@ -63,37 +69,147 @@ void gtest::OnIdle()
 	}
 	mEngine->ClearBuffers();
 
-	for (auto const& visual : mCuller.GetVisibleSet())
-	{
-		mEngine->Draw(visual);
+	DrawVisuals(mCuller.GetVisibleSet());
+#elif (TEST_CULL == 2)
+		mBVHCuller.ComputeVisibleSet(mCamera, mScene);		// Bounding volume hierarchy
+	}
+	mEngine->ClearBuffers();
+
+	DrawVisuals(mBVHCuller.GetVisibleSet());
+#elif (TEST_CULL == 3)
+		mParallelCuller.ComputeVisibleSet(mCamera, mScene);	// Subtree tasks on all cores
 	}
+	mEngine->ClearBuffers();
+
+	DrawVisuals(mParallelCuller.GetVisibleSet());
 #else
 }
 	mEngine->ClearBuffers();
-	std::vector<std::shared_ptr<gte::Visual*>>* test = GetVisualsOfScene(mScene);
-
-	for (auto const& visual : *test)
 	{
-		mEngine->Draw(*visual.get());
+		GTE_PROFILE_SCOPE("Collect");
+		mCollector.Collect(mScene);
 	}
+
+	DrawVisuals(mCollector.GetVisuals());
 #endif
 
 
 	mEngine->Draw(8, mYSize - 8, { 1.0f, 1.0f, 1.0f, 1.0 }, mTimer.GetFPS());
-	mEngine->DisplayColorBuffer(0);
+	{
+		GTE_PROFILE_SCOPE("Present");
+		mEngine->DisplayColorBuffer(0);
+	}
 
 	mTimer.UpdateFrameCount();
 }
 
+void gtest::DrawVisuals(std::vector<Visual*> const& visuals)
+{
+	GTE_PROFILE_SCOPE("DrawVisuals");
+#if (TEST_OCCLUSION == 1)
+	{
+		// The occluders are drawn with the levels selected last frame.
+		GTE_PROFILE_SCOPE("OcclusionCull");
+		mOcclusion.Cull(mCamera, visuals);
+	}
+	std::vector<Visual*> const& unoccluded = mOcclusion.GetVisibleSet();
+#else
+	std::vector<Visual*> const& unoccluded = visuals;
+#endif
+
+#if (TEST_LOD == 1)
+	{
+		// Only the visuals that survived culling change level.
+		GTE_PROFILE_SCOPE("SelectLOD");
+		mLOD.Select(mCamera, mYSize, unoccluded);
+	}
+#endif
+
+	// The levels are selected first because they change the buffers.
+#if (TEST_SORT != 0)
+	{
+		GTE_PROFILE_SCOPE("SortDraws");
+		mDrawQueue.Sort(mCamera, unoccluded);
+	}
+	std::vector<Visual*> const& sorted = mDrawQueue.GetVisuals();
+#else
+	std::vector<Visual*> const& sorted = unoccluded;
+#endif
+
+	// The instanced shaders multiply the world and PV matrices separately,
+	// so their depths need not equal those of the prepass, which the
+	// LESS_EQUAL test of the shading pass requires.  With the prepass the
+	// visuals are drawn one at a time.
+	if (mUseDepthPrepass)
+	{
+		{
+			GTE_PROFILE_SCOPE("DepthPrepass");
+			mDepthPrepass->Begin(mEngine, sorted);
+		}
+		for (auto visual : sorted)
+		{
+			DrawVisual(visual);
+		}
+		mDepthPrepass->End(mEngine);
+		return;
+	}
+
+#if (TEST_INSTANCING == 1)
+	auto& batcher = (mUseBarycentric ? mBarycentricBatcher : mBatcher);
+	batcher->Begin();
+	for (auto visual : sorted)
+	{
+		if (!batcher->Add(visual))
+		{
+			DrawVisual(visual);
+		}
+	}
+	batcher->End(mEngine, mCamera->GetProjectionViewMatrix());
+#else
+	for (auto visual : sorted)
+	{
+		DrawVisual(visual);
+	}
+#endif
+}
+
+void gtest::DrawVisual(Visual* visual)
+{
+	if (!mUseBarycentric || !mBarycentric->Draw(mEngine, visual))
+	{
+		EffectCache::Bind(visual);
+		mEngine->Draw(visual);
+	}
+}
+
 bool gtest::OnResize(int xSize, int ySize)
 {
 	if (Window3::OnResize(xSize, ySize))
 	{
 		mCuller.ComputeVisibleSet(mCamera, mScene);
+		mBVHCuller.ComputeVisibleSet(mCamera, mScene);
+		mParallelCuller.ComputeVisibleSet(mCamera, mScene);
 	}
 	return true;
 }
 
+bool gtest::OnCharPress(unsigned char key, int x, int y)
+{
+	switch (key)
+	{
+	case 'g':  // toggle between the geometry shader and barycentric wireframes
+	case 'G':
+		mUseBarycentric = !mUseBarycentric;
+		return true;
+
+	case 'z':  // toggle the depth prepass
+	case 'Z':
+		mUseDepthPrepass = !mUseDepthPrepass;
+		return true;
+	}
+	return Window3::OnCharPress(key, x, y);
+}
+
 bool gtest::SetEnvironment()
 {
 	std::string path = GetGTEPath();
@@ -103,12 +219,19 @@ bool gtest::SetEnvironment()
 	}
 
 	mEnvironment.Insert(path + "/Samples/Graphics/WireMesh/Shaders/");
+	mEnvironment.Insert(WIREMESH_SHADERS_PATH);
 
 	std::vector<std::string> inputs =
 	{
 		mEngine->GetShaderName("WireMesh.vs"),
 		mEngine->GetShaderName("WireMesh.ps"),
-		mEngine->GetShaderName("WireMesh.gs")
+		mEngine->GetShaderName("WireMesh.gs"),
+		mEngine->GetShaderName("WireMeshInstanced.vs"),
+		mEngine->GetShaderName("WireMeshBarycentric.vs"),
+		mEngine->GetShaderName("WireMeshBarycentric.ps"),
+		mEngine->GetShaderName("WireMeshInstancedBarycentric.vs"),
+		mEngine->GetShaderName("WireMeshDepth.vs"),
+		mEngine->GetShaderName("WireMeshDepth.ps")
 	};
 
 	for (auto const& input : inputs)
@@ -125,181 +248,320 @@ bool gtest::SetEnvironment()
 
 bool gtest::CreateScene()
 {
-	mScene = std::make_shared<Node>();
-
-	for (int i = 0; i < SPHERE_COUNT; i++)
+	GTE_PROFILE_SCOPE("CreateScene");
+	std::string vsPath = mEnvironment.GetPath(mEngine->GetShaderName("WireMesh.vs"));
+	std::string psPath = mEnvironment.GetPath(mEngine->GetShaderName("WireMesh.ps"));
+	std::string gsPath = mEnvironment.GetPath(mEngine->GetShaderName("WireMesh.gs"));
+
+	// All the meshes use the same shaders and colors, so they share one
+	// program and one WireParameters buffer.  The cache compiles the
+	// program on the first request and returns it for the others.
+	auto parameters = std::make_shared<ConstantBuffer>(3 * sizeof(Vector4<float>), false);
+	auto* data = parameters->Get<Vector4<float>>();
+	data[0] = { 0.0f, 0.0f, 1.0f, 1.0f };  // mesh color
+	data[1] = { 0.0f, 0.0f, 0.0f, 1.0f };  // edge color
+	data[2] = { static_cast<float>(mXSize), static_cast<float>(mYSize), 0.0f, 0.0f };
+	auto initializer = [&parameters](std::shared_ptr<VisualProgram> const& program)
 	{
-		std::string vsPath = mEnvironment.GetPath(mEngine->GetShaderName("WireMesh.vs"));
-		std::string psPath = mEnvironment.GetPath(mEngine->GetShaderName("WireMesh.ps"));
-		std::string gsPath = mEnvironment.GetPath(mEngine->GetShaderName("WireMesh.gs"));
-
-		auto program = mProgramFactory->CreateFromFiles(vsPath, psPath, gsPath);
-		if (!program)
-		{
-			return false;
-		}
-
-		auto parameters = std::make_shared<ConstantBuffer>(3 * sizeof(Vector4<float>), false);
-		auto* data = parameters->Get<Vector4<float>>();
-		data[0] = { 0.0f, 0.0f, 1.0f, 1.0f };  // mesh color
-		data[1] = { 0.0f, 0.0f, 0.0f, 1.0f };  // edge color
-		data[2] = { static_cast<float>(mXSize), static_cast<float>(mYSize), 0.0f, 0.0f };
 		program->GetVertexShader()->Set("WireParameters", parameters);
 		program->GetPixelShader()->Set("WireParameters", parameters);
 		program->GetGeometryShader()->Set("WireParameters", parameters);
+	};
 
-		auto cbuffer = std::make_shared<ConstantBuffer>(sizeof(Matrix4x4<float>), true);
-		program->GetVertexShader()->Set("PVWMatrix", cbuffer);
-
-		auto effect = std::make_shared<VisualEffect>(program);
-
-		VertexFormat vformat;
-		vformat.Bind(VA_POSITION, DF_R32G32B32_FLOAT, 0);
-		MeshFactory mf;
-		mf.SetVertexFormat(vformat);
-		std::shared_ptr<Visual> Spheres;
-
-		Spheres = mf.CreateSphere(16, 16, 1.0f);
-		Spheres->localTransform.SetTranslation(2 * i - SPHERE_COUNT + 1, 0.0, 10.0);
-		Spheres->SetEffect(effect);
-
-		mPVWMatrices.Subscribe(Spheres->worldTransform, cbuffer);
+	// Only the vertex shader differs for instancing.
+	auto instancedProgram = mEffects.CreateFromFiles(
+		mEnvironment.GetPath(mEngine->GetShaderName("WireMeshInstanced.vs")),
+		psPath, gsPath, initializer);
+	if (!instancedProgram)
+	{
+		return false;
+	}
+	mBatcher = std::make_unique<InstancedBatcher>(instancedProgram);
 
-		mScene->AttachChild(Spheres);
+	// The barycentric programs have no geometry shader.  Their batcher
+	// instances every group, even a single visual, so that no visual falls
+	// back to the geometry shader of its own effect.
+	auto barycentricInitializer = [&parameters](std::shared_ptr<VisualProgram> const& program)
+	{
+		program->GetVertexShader()->Set("WireParameters", parameters);
+		program->GetPixelShader()->Set("WireParameters", parameters);
+	};
+	std::string barycentricPSPath = mEnvironment.GetPath(mEngine->GetShaderName("WireMeshBarycentric.ps"));
+	auto barycentricProgram = mEffects.CreateFromFiles(
+		mEnvironment.GetPath(mEngine->GetShaderName("WireMeshBarycentric.vs")),
+		barycentricPSPath, "", barycentricInitializer);
+	auto instancedBarycentricProgram = mEffects.CreateFromFiles(
+		mEnvironment.GetPath(mEngine->GetShaderName("WireMeshInstancedBarycentric.vs")),
+		barycentricPSPath, "", barycentricInitializer);
+	if (!barycentricProgram || !instancedBarycentricProgram)
+	{
+		return false;
 	}
+	mBarycentric = std::make_unique<BarycentricWire>(barycentricProgram);
+	mBarycentricBatcher = std::make_unique<InstancedBatcher>(instancedBarycentricProgram, 1);
 
-	for (int i = 0; i < SPHERE_COUNT; i++)
+	auto depthProgram = mEffects.CreateFromFiles(
+		mEnvironment.GetPath(mEngine->GetShaderName("WireMeshDepth.vs")),
+		mEnvironment.GetPath(mEngine->GetShaderName("WireMeshDepth.ps")), "");
+	if (!depthProgram)
 	{
-		std::string vsPath = mEnvironment.GetPath(mEngine->GetShaderName("WireMesh.vs"));
-		std::string psPath = mEnvironment.GetPath(mEngine->GetShaderName("WireMesh.ps"));
-		std::string gsPath = mEnvironment.GetPath(mEngine->GetShaderName("WireMesh.gs"));
+		return false;
+	}
+	mDepthPrepass = std::make_unique<DepthPrepass>(depthProgram);
 
-		auto program = mProgramFactory->CreateFromFiles(vsPath, psPath, gsPath);
+	// The PVWMatrix buffer is the only per-object resource.
+	auto attachEffect = [&](std::shared_ptr<Visual> const& mesh)
+	{
+		auto program = mEffects.CreateFromFiles(vsPath, psPath, gsPath, initializer);
 		if (!program)
 		{
 			return false;
 		}
 
-		auto parameters = std::make_shared<ConstantBuffer>(3 * sizeof(Vector4<float>), false);
-		auto* data = parameters->Get<Vector4<float>>();
-		data[0] = { 0.0f, 0.0f, 1.0f, 1.0f };  // mesh color
-		data[1] = { 0.0f, 0.0f, 0.0f, 1.0f };  // edge color
-		data[2] = { static_cast<float>(mXSize), static_cast<float>(mYSize), 0.0f, 0.0f };
-		program->GetVertexShader()->Set("WireParameters", parameters);
-		program->GetPixelShader()->Set("WireParameters", parameters);
-		program->GetGeometryShader()->Set("WireParameters", parameters);
-
 		auto cbuffer = std::make_shared<ConstantBuffer>(sizeof(Matrix4x4<float>), true);
-		program->GetVertexShader()->Set("PVWMatrix", cbuffer);
-
-		auto effect = std::make_shared<VisualEffect>(program);
-
-		VertexFormat vformat;
-		vformat.Bind(VA_POSITION, DF_R32G32B32_FLOAT, 0);
-		MeshFactory mf;
-		mf.SetVertexFormat(vformat);
-		std::shared_ptr<Visual> Spheres;
-
-		Spheres = mf.CreateSphere(16, 16, 1.0f);
-		Spheres->localTransform.SetTranslation(2 * i - SPHERE_COUNT + 1, 0.0, -10.0);
-		Spheres->SetEffect(effect);
+		mesh->SetEffect(mEffects.CreateEffect(program, cbuffer));
+		mPVWMatrices.Subscribe(mesh->worldTransform, cbuffer);
+		return true;
+	};
 
-		mPVWMatrices.Subscribe(Spheres->worldTransform, cbuffer);
+	auto updateScene = [this]()
+	{
+#if (TEST_FLAT_HIERARCHY == 1)
+		mHierarchy.Build(mScene);
+		mHierarchy.Update();
+#else
+		mScene->Update();
+#endif
+	};
 
-		mScene->AttachChild(Spheres);
-	}
+	VertexFormat vformat;
+	vformat.Bind(VA_POSITION, DF_R32G32B32_FLOAT, 0);
+	MeshFactory mf;
+	mf.SetVertexFormat(vformat);
 
-	for (int i = 0; i < SPHERE_COUNT; i++)
+	// The factory meshes are packed into the pages of the pool, once per
+	// set of generator parameters.
+	mGeometry = std::make_unique<GeometryPool>(vformat);
+	auto sphere = [&](unsigned int samples)
+	{
+		return mGeometry->Create("sphere " + std::to_string(samples) + " " + std::to_string(samples) + " 1",
+			[&]() { return mf.CreateSphere(samples, samples, 1.0f); });
+	};
+	auto torus = [&](unsigned int samples)
+	{
+		return mGeometry->Create("torus " + std::to_string(samples) + " " + std::to_string(samples) + " 1 0.5",
+			[&]() { return mf.CreateTorus(samples, samples, 1.0f, 0.5f); });
+	};
+	auto octahedron = mGeometry->Create("octahedron", [&]() { return mf.CreateOctahedron(); });
+
+	// The levels of detail, finest first.  Tessellating them takes longer
+	// than the rest of the scene, so they are the chains of the scene
+	// cache, the sphere's first and the torus's second.  The visuals of a
+	// shape get its chain once the scene is complete.
+	mLOD.Clear();
+	SceneCache::Chains levels;
+	std::vector<std::pair<std::shared_ptr<Visual>, int>> lodMeshes;
+	auto addLevels = [&](std::shared_ptr<Visual> const& mesh, std::string const& shape)
+	{
+#if (TEST_LOD == 1)
+		if (shape != "Octahedron")
+		{
+			lodMeshes.push_back({ mesh, shape == "Sphere" ? 0 : 1 });
+		}
+#endif
+		return true;
+	};
+	auto createChains = [&]()
 	{
-		std::string vsPath = mEnvironment.GetPath(mEngine->GetShaderName("WireMesh.vs"));
-		std::string psPath = mEnvironment.GetPath(mEngine->GetShaderName("WireMesh.ps"));
-		std::string gsPath = mEnvironment.GetPath(mEngine->GetShaderName("WireMesh.gs"));
+#if (TEST_LOD == 1)
+		int chains[2];
+		for (int shape = 0; shape < 2; ++shape)
+		{
+			chains[shape] = (levels.size() == 2 ? mLOD.AddChain(levels[shape]) : -1);
+			if (chains[shape] < 0)
+			{
+				return false;
+			}
+		}
+		for (auto const& lodMesh : lodMeshes)
+		{
+			if (!mLOD.Add(lodMesh.first.get(), chains[lodMesh.second]))
+			{
+				return false;
+			}
+		}
+#endif
+		return true;
+	};
 
-		auto program = mProgramFactory->CreateFromFiles(vsPath, psPath, gsPath);
-		if (!program)
+	// The spheres hide what is behind them.  An occluder is drawn into the
+	// depth pyramid with the buffers of its current level.  Like the LOD
+	// chains, the occluders are given to mOcclusion only once the scene is
+	// complete, so a cache that fails to load leaves nothing registered.
+	mOcclusion.Clear();
+	std::vector<std::shared_ptr<Visual>> occluders;
+	auto addOccluder = [&](std::shared_ptr<Visual> const& mesh, std::string const& shape)
+	{
+#if (TEST_OCCLUSION == 1)
+		if (shape == "Sphere")
+		{
+			occluders.push_back(mesh);
+		}
+#endif
+		return true;
+	};
+	auto registerMeshes = [&]()
+	{
+		if (!createChains())
 		{
 			return false;
 		}
+		for (auto const& occluder : occluders)
+		{
+			if (!mOcclusion.AddOccluder(occluder.get()))
+			{
+				return false;
+			}
+		}
+		return true;
+	};
 
-		auto parameters = std::make_shared<ConstantBuffer>(3 * sizeof(Vector4<float>), false);
-		auto* data = parameters->Get<Vector4<float>>();
-		data[0] = { 0.0f, 0.0f, 1.0f, 1.0f };  // mesh color
-		data[1] = { 0.0f, 0.0f, 0.0f, 1.0f };  // edge color
-		data[2] = { static_cast<float>(mXSize), static_cast<float>(mYSize), 0.0f, 0.0f };
-		program->GetVertexShader()->Set("WireParameters", parameters);
-		program->GetPixelShader()->Set("WireParameters", parameters);
-		program->GetGeometryShader()->Set("WireParameters", parameters);
-
-		auto cbuffer = std::make_shared<ConstantBuffer>(sizeof(Matrix4x4<float>), true);
-		program->GetVertexShader()->Set("PVWMatrix", cbuffer);
-
-		auto effect = std::make_shared<VisualEffect>(program);
+	// The tag changes whenever the generated geometry does, which makes an
+	// older cache file stale.  The effect name of a cached visual is its
+	// shape.
+	std::string const cacheTag = "gtest sphere 16x16, torus 16x16, octahedron, count "
+		+ std::to_string(SPHERE_COUNT) + ", named shapes"
+#if (TEST_LOD == 1)
+		+ ", level chains 64 32 16 8"
+#endif
+		;
+	mScene = mSceneCache.Load(SCENE_CACHE, cacheTag,
+		[&](std::shared_ptr<Visual> const& mesh, std::string const& effect)
+		{
+			return (effect == "Sphere" || effect == "Torus" || effect == "Octahedron")
+				&& attachEffect(mesh) && addLevels(mesh, effect) && addOccluder(mesh, effect);
+		}, &levels);
+	if (mScene)
+	{
+		if (registerMeshes())
+		{
+			mGeometry->Seal();
+			updateScene();
+			return true;
+		}
+		LogWarning("The levels of detail or occluders in " SCENE_CACHE " are invalid");
+		mScene = nullptr;
+		mSceneCache.Clear();
+	}
 
-		VertexFormat vformat;
-		vformat.Bind(VA_POSITION, DF_R32G32B32_FLOAT, 0);
-		MeshFactory mf;
-		mf.SetVertexFormat(vformat);
-		std::shared_ptr<Visual> Spheres;
+	// Whatever the resolver registered belongs to the Visuals of a scene
+	// that no longer exists.
+	mPVWMatrices.UnsubscribeAll();
+	mLOD.Clear();
+	mOcclusion.Clear();
+	levels.clear();
+	lodMeshes.clear();
+	occluders.clear();
+	mScene = std::make_shared<Node>();
 
-		Spheres = mf.CreateTorus(16, 16, 1.0f, 0.5f);
-		Spheres->localTransform.SetTranslation(-SPHERE_COUNT + 1, 0.0, 9 - 2 * i);
-		Spheres->SetEffect(effect);
+	// The copies of a shape share the vertex and index buffers of one
+	// pooled mesh, which is what lets the batcher draw them together.  The
+	// model bound is the mesh's; UpdateModelBound would measure the page.
+	auto attach = [&](std::shared_ptr<Visual> const& shape, float x, float y, float z)
+	{
+		auto mesh = std::make_shared<Visual>(shape->GetVertexBuffer(), shape->GetIndexBuffer());
+		mesh->modelBound = shape->modelBound;
+		mesh->localTransform.SetTranslation(x, y, z);
+		if (!attachEffect(mesh))
+		{
+			return false;
+		}
 
-		mPVWMatrices.Subscribe(Spheres->worldTransform, cbuffer);
+		mScene->AttachChild(mesh);
+		return true;
+	};
 
-		mScene->AttachChild(Spheres);
+	auto sphere16 = sphere(16);
+	auto torus16 = torus(16);
+#if (TEST_LOD == 1)
+	levels.resize(2);
+	for (unsigned int samples : { 64u, 32u, 16u, 8u })
+	{
+		levels[0].push_back(sphere(samples));
+		levels[1].push_back(torus(samples));
 	}
+#endif
+	mGeometry->Seal();
 
 	for (int i = 0; i < SPHERE_COUNT; i++)
 	{
-		std::string vsPath = mEnvironment.GetPath(mEngine->GetShaderName("WireMesh.vs"));
-		std::string psPath = mEnvironment.GetPath(mEngine->GetShaderName("WireMesh.ps"));
-		std::string gsPath = mEnvironment.GetPath(mEngine->GetShaderName("WireMesh.gs"));
-
-		auto program = mProgramFactory->CreateFromFiles(vsPath, psPath, gsPath);
-		if (!program)
+		if (!attach(sphere16, 2.0f * i - SPHERE_COUNT + 1, 0.0f, 10.0f))
 		{
 			return false;
 		}
+	}
 
-		auto parameters = std::make_shared<ConstantBuffer>(3 * sizeof(Vector4<float>), false);
-		auto* data = parameters->Get<Vector4<float>>();
-		data[0] = { 0.0f, 0.0f, 1.0f, 1.0f };  // mesh color
-		data[1] = { 0.0f, 0.0f, 0.0f, 1.0f };  // edge color
-		data[2] = { static_cast<float>(mXSize), static_cast<float>(mYSize), 0.0f, 0.0f };
-		program->GetVertexShader()->Set("WireParameters", parameters);
-		program->GetPixelShader()->Set("WireParameters", parameters);
-		program->GetGeometryShader()->Set("WireParameters", parameters);
-
-		auto cbuffer = std::make_shared<ConstantBuffer>(sizeof(Matrix4x4<float>), true);
-		program->GetVertexShader()->Set("PVWMatrix", cbuffer);
+	for (int i = 0; i < SPHERE_COUNT; i++)
+	{
+		if (!attach(sphere16, 2.0f * i - SPHERE_COUNT + 1, 0.0f, -10.0f))
+		{
+			return false;
+		}
+	}
 
-		auto effect = std::make_shared<VisualEffect>(program);
+	for (int i = 0; i < SPHERE_COUNT; i++)
+	{
+		if (!attach(torus16, -SPHERE_COUNT + 1.0f, 0.0f, 9.0f - 2 * i))
+		{
+			return false;
+		}
+	}
 
-		VertexFormat vformat;
-		vformat.Bind(VA_POSITION, DF_R32G32B32_FLOAT, 0);
-		MeshFactory mf;
-		mf.SetVertexFormat(vformat);
-		std::shared_ptr<Visual> Spheres;
+	for (int i = 0; i < SPHERE_COUNT; i++)
+	{
+		if (!attach(octahedron, static_cast<float>(SPHERE_COUNT), 0.0f, 9.0f - 2 * i))
+		{
+			return false;
+		}
+	}
 
-		Spheres = mf.CreateOctahedron();
-		Spheres->localTransform.SetTranslation(SPHERE_COUNT, 0.0, 9 - 2 * i);
-		Spheres->SetEffect(effect);
+	updateScene();
 
-		mPVWMatrices.Subscribe(Spheres->worldTransform, cbuffer);
+	// A failed write only costs the next run its fast start.
+	// The shapes share a page, so their index buffers tell them apart.
+	auto shapeOf = [&](Visual const& mesh)
+	{
+		auto const& ibuffer = mesh.GetIndexBuffer();
+		return std::string(ibuffer == sphere16->GetIndexBuffer() ? "Sphere" :
+			ibuffer == torus16->GetIndexBuffer() ? "Torus" : "Octahedron");
+	};
+	SceneCache::Save(SCENE_CACHE, cacheTag, mScene, shapeOf, levels);
 
-		mScene->AttachChild(Spheres);
+	// The levels replace the shared buffers only after the save, which
+	// identifies the shapes by them.
+	for (int i = 0; i < mScene->GetNumChildren(); ++i)
+	{
+		auto mesh = std::static_pointer_cast<Visual>(mScene->GetChild(i));
+		std::string const shape = shapeOf(*mesh);
+		if (!addLevels(mesh, shape) || !addOccluder(mesh, shape))
+		{
+			return false;
+		}
 	}
 
-	mScene->Update();
-
-	return true;
+	return registerMeshes();
 }
 
 int main(int, char const*[])
 {
 	EXPECT_EQ(1, 2);
+#if (TEST_TRACE == 1)
+	Profiler::Enable(true);
+#endif
 	InitWindow();
+#if (TEST_TRACE == 1)
+	Profiler::SaveChromeTrace("gtest.trace.json");
+#endif
 
 
 	return 0;
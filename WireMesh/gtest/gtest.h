@@ -1,5 +1,18 @@
 #pragma once
 #include <Applications/Window3.h>
+#include "BarycentricWire.h"
+#include "BVHCuller.h"
+#include "DepthPrepass.h"
+#include "DrawQueue.h"
+#include "EffectCache.h"
+#include "FlatHierarchy.h"
+#include "GeometryPool.h"
+#include "InstancedBatcher.h"
+#include "LODSelector.h"
+#include "OcclusionCuller.h"
+#include "ParallelCuller.h"
+#include "SceneCache.h"
+#include "VisualCollector.h"
 using namespace gte;
 
 class gtest : public Window3
@@ -11,12 +24,34 @@ public:
 
 	virtual bool OnResize(int xSize, int ySize) override;
 
+	// The 'g' key toggles between the geometry shader wireframe and the
+	// barycentric one, and the 'z' key the depth prepass.
+	virtual bool OnCharPress(unsigned char key, int x, int y) override;
+
 private:
 	Culler mCuller;
+	BVHCuller mBVHCuller;
+	ParallelCuller mParallelCuller;
+	VisualCollector mCollector;
+	EffectCache mEffects;
+	std::unique_ptr<InstancedBatcher> mBatcher;
+	std::unique_ptr<InstancedBatcher> mBarycentricBatcher;
+	std::unique_ptr<BarycentricWire> mBarycentric;
+	bool mUseBarycentric;
+	SceneCache mSceneCache;
+	FlatHierarchy mHierarchy;
+	LODSelector mLOD;
+	DrawQueue mDrawQueue;
+	std::unique_ptr<DepthPrepass> mDepthPrepass;
+	bool mUseDepthPrepass;
+	OcclusionCuller mOcclusion;
+	std::unique_ptr<GeometryPool> mGeometry;
 
 	bool SetEnvironment();
 	bool CreateScene();
 	void CullScene();
+	void DrawVisuals(std::vector<Visual*> const& visuals);
+	void DrawVisual(Visual* visual);
 
 	std::shared_ptr<Node> mScene;
 	std::shared_ptr<Visual*> culledScene;